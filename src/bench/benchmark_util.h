@@ -5,16 +5,80 @@
 #ifndef BENCH_BENCHMARK_UTIL_H_
 #define BENCH_BENCHMARK_UTIL_H_
 
+#include <cstddef>
+#include <cstdio>
 #include <string>
 
+#include "femtolog/build/build_flag.h"
 #include "femtolog/core/base/file_util.h"
 
+#if FEMTOLOG_IS_WINDOWS
+#include <windows.h>
+// windows.h must come first.
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
 namespace femtolog::bench {
 
 inline std::string get_benchmark_log_path(const char* filename) {
   return core::join_path(core::exe_dir(), "benchmark_logs", filename);
 }
 
+// User plus system CPU time consumed by the whole process so far.
+inline double process_cpu_seconds() {
+#if FEMTOLOG_IS_WINDOWS
+  FILETIME creation, exit, kernel, user;
+  GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+  auto to_seconds = [](const FILETIME& ft) {
+    const uint64_t ticks =
+        (static_cast<uint64_t>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+    return static_cast<double>(ticks) * 1e-7;
+  };
+  return to_seconds(kernel) + to_seconds(user);
+#else
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  auto to_seconds = [](const timeval& tv) {
+    return static_cast<double>(tv.tv_sec) +
+           static_cast<double>(tv.tv_usec) * 1e-6;
+  };
+  return to_seconds(usage.ru_utime) + to_seconds(usage.ru_stime);
+#endif
+}
+
+// Resident set size of the whole process in bytes, or 0 where it cannot be
+// read.
+inline std::size_t process_rss_bytes() {
+#if FEMTOLOG_IS_WINDOWS
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                            sizeof(counters))) {
+    return 0;
+  }
+  return counters.WorkingSetSize;
+#elif FEMTOLOG_IS_LINUX
+  std::FILE* file = std::fopen("/proc/self/statm", "r");
+  if (!file) {
+    return 0;
+  }
+  unsigned long total_pages = 0;  // NOLINT(runtime/int)
+  unsigned long resident_pages = 0;  // NOLINT(runtime/int)
+  const int matched = std::fscanf(file, "%lu %lu", &total_pages,
+                                  &resident_pages);
+  std::fclose(file);
+  if (matched != 2) {
+    return 0;
+  }
+  return static_cast<std::size_t>(resident_pages) *
+         static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#else
+  return 0;
+#endif
+}
+
 }  // namespace femtolog::bench
 
 #endif  // BENCH_BENCHMARK_UTIL_H_
@@ -0,0 +1,169 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#include "femtolog/build/build_flag.h"
+
+#if FEMTOLOG_IS_LINUX
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "bench/benchmark_util.h"
+#include "benchmark/benchmark.h"
+#include "femtolog/base/format_util.h"
+#include "femtolog/base/log_entry.h"
+#include "femtolog/core/base/file_util.h"
+#include "femtolog/sinks/file_sink.h"
+#include "femtolog/sinks/io_uring_file_sink.h"
+#include "fmt/format.h"
+
+namespace {
+
+using femtolog::FileSink;
+using femtolog::LogEntry;
+
+constexpr std::size_t kLinesPerBatch = 1024;
+constexpr std::size_t kBatches = 4096;
+
+enum Location : int64_t { kTmpfs = 0, kDisk = 1 };
+
+std::string log_path(int64_t location, const char* filename) {
+  if (location == kTmpfs) {
+    return femtolog::core::join_path("/dev/shm", "femtolog_bench", filename);
+  }
+  return femtolog::bench::get_benchmark_log_path(filename);
+}
+
+// Calls fsync() on `path` every millisecond until destroyed, as a database or
+// another logger sharing the disk would.
+class BackgroundFsync {
+ public:
+  BackgroundFsync(const std::string& path, bool enabled) {
+    if (!enabled) {
+      return;
+    }
+    thread_ = std::thread([this, path]() {
+      const int fd = open(path.c_str(), O_WRONLY);
+      while (!stop_.load(std::memory_order_relaxed)) {
+        fsync(fd);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      close(fd);
+    });
+  }
+
+  ~BackgroundFsync() {
+    stop_.store(true, std::memory_order_relaxed);
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+  }
+
+ private:
+  std::atomic<bool> stop_ = false;
+  std::thread thread_;
+};
+
+// Writes laid out lines to a sink the way the backend does under sustained
+// load, and reports the slowest batch, which is how long the backend stops
+// dequeuing.
+template <typename MakeSink>
+void write_lines(benchmark::State& state, const char* filename,
+                 MakeSink make_sink) {
+  const std::string path = log_path(state.range(0), filename);
+  femtolog::core::remove_file(path.c_str());
+
+  LogEntry entry;
+  entry.timestamp_ns = femtolog::timestamp_ns();
+  const std::string message(64, 'x');
+  double max_batch_us = 0;
+  {
+    auto sink = make_sink(path);
+    BackgroundFsync fsync(path, state.range(1) != 0);
+    for (auto _ : state) {
+      const auto start = std::chrono::steady_clock::now();
+      for (std::size_t i = 0; i < kLinesPerBatch; ++i) {
+        fmt::memory_buffer* out = sink->begin_log(entry);
+        sink->layout()->format_line(entry, message.data(), message.size(),
+                                    out);
+        sink->end_log(entry);
+        entry.timestamp_ns += 1000;
+      }
+      const std::chrono::duration<double, std::micro> elapsed =
+          std::chrono::steady_clock::now() - start;
+      max_batch_us = std::max(max_batch_us, elapsed.count());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kLinesPerBatch);
+  state.counters["max_batch_us"] = max_batch_us;
+
+  femtolog::core::remove_file(path.c_str());
+}
+
+void file_sink_write_lines(benchmark::State& state) {
+  write_lines(state, "file_sink.log", [](const std::string& path) {
+    return std::make_unique<FileSink>(path);
+  });
+}
+
+#if FEMTOLOG_HAS_IO_URING
+using femtolog::IoUringFileSink;
+using femtolog::IoUringFileSinkOptions;
+
+void io_uring_file_sink_write_lines(benchmark::State& state) {
+  write_lines(state, "io_uring_file_sink.log", [](const std::string& path) {
+    return std::make_unique<IoUringFileSink>(path);
+  });
+}
+
+void io_uring_file_sink_direct_write_lines(benchmark::State& state) {
+  write_lines(state, "io_uring_file_sink_direct.log",
+              [](const std::string& path) {
+                IoUringFileSinkOptions options;
+                options.direct_io = true;
+                return std::make_unique<IoUringFileSink>(
+                    path, IoUringFileSink::DefaultLayout::functions(),
+                    options);
+              });
+}
+
+// As above, with as many direct writes in flight as there are buffers.
+void io_uring_file_sink_direct_queued_write_lines(benchmark::State& state) {
+  write_lines(state, "io_uring_file_sink_direct_queued.log",
+              [](const std::string& path) {
+                IoUringFileSinkOptions options;
+                options.direct_io = true;
+                options.direct_writes_in_flight = options.buffer_count;
+                return std::make_unique<IoUringFileSink>(
+                    path, IoUringFileSink::DefaultLayout::functions(),
+                    options);
+              });
+}
+#endif  // FEMTOLOG_HAS_IO_URING
+
+void sink_args(benchmark::internal::Benchmark* bench) {
+  bench->ArgNames({"disk", "fsync"})
+      ->ArgsProduct({{kTmpfs, kDisk}, {0, 1}})
+      ->Iterations(kBatches)
+      ->UseRealTime();
+}
+
+BENCHMARK(file_sink_write_lines)->Apply(sink_args);
+#if FEMTOLOG_HAS_IO_URING
+BENCHMARK(io_uring_file_sink_write_lines)->Apply(sink_args);
+BENCHMARK(io_uring_file_sink_direct_write_lines)->Apply(sink_args);
+BENCHMARK(io_uring_file_sink_direct_queued_write_lines)->Apply(sink_args);
+#endif  // FEMTOLOG_HAS_IO_URING
+
+}  // namespace
+
+#endif  // FEMTOLOG_IS_LINUX
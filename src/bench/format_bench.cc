@@ -3,11 +3,20 @@
 // which can be found in the LICENSE file.
 
 #include <array>
-#include <format>
+#include <cstdint>
 #include <string>
 #include <string_view>
+#include <version>
+
+#if defined(__cpp_lib_format)
+#include <format>
+#endif
 
 #include "benchmark/benchmark.h"
+#include "femtolog/base/format_util.h"
+#include "femtolog/base/serialize_util.h"
+#include "femtolog/logging/impl/args_deserializer.h"
+#include "femtolog/logging/impl/args_serializer.h"
 #include "fmt/core.h"
 #include "fmt/format.h"
 
@@ -17,6 +26,7 @@ constexpr const int value = 42;
 constexpr const std::string_view name = "Foo";
 constexpr const double pi = 3.14159;
 
+#if defined(__cpp_lib_format)
 void format_std_format_simple(benchmark::State& state) {
   for (auto _ : state) {
     std::string s = std::format("value = {}", value);
@@ -24,6 +34,7 @@ void format_std_format_simple(benchmark::State& state) {
   }
 }
 BENCHMARK(format_std_format_simple);
+#endif
 
 void format_fmt_format_simple(benchmark::State& state) {
   for (auto _ : state) {
@@ -33,6 +44,7 @@ void format_fmt_format_simple(benchmark::State& state) {
 }
 BENCHMARK(format_fmt_format_simple);
 
+#if defined(__cpp_lib_format)
 void format_std_format(benchmark::State& state) {
   for (auto _ : state) {
     std::string s =
@@ -41,6 +53,7 @@ void format_std_format(benchmark::State& state) {
   }
 }
 BENCHMARK(format_std_format);
+#endif
 
 void format_fmt_format(benchmark::State& state) {
   for (auto _ : state) {
@@ -51,6 +64,7 @@ void format_fmt_format(benchmark::State& state) {
 }
 BENCHMARK(format_fmt_format);
 
+#if defined(__cpp_lib_format)
 void format_std_format_to_n_simple(benchmark::State& state) {
   for (auto _ : state) {
     std::array<char, 128> buffer;
@@ -60,6 +74,7 @@ void format_std_format_to_n_simple(benchmark::State& state) {
   }
 }
 BENCHMARK(format_std_format_to_n_simple);
+#endif
 
 void format_fmt_format_to_n_simple(benchmark::State& state) {
   for (auto _ : state) {
@@ -81,6 +96,7 @@ void format_fmt_format_to_n_simple_wo_fmt_string(benchmark::State& state) {
 }
 BENCHMARK(format_fmt_format_to_n_simple_wo_fmt_string);
 
+#if defined(__cpp_lib_format)
 void format_std_format_to_n(benchmark::State& state) {
   for (auto _ : state) {
     std::array<char, 128> buffer;
@@ -91,6 +107,7 @@ void format_std_format_to_n(benchmark::State& state) {
   }
 }
 BENCHMARK(format_std_format_to_n);
+#endif
 
 void format_fmt_format_to_n(benchmark::State& state) {
   for (auto _ : state) {
@@ -121,4 +138,79 @@ void format_fmt_format_dynamic(benchmark::State& state) {
 }
 BENCHMARK(format_fmt_format_dynamic);
 
+// What the backend does per message for the cases of femtolog_bench.cc:
+// decode the arguments of a queued entry and format them, either with the
+// format string parsed at runtime or compiled.
+template <femtolog::FixedString fmt, bool compiled, typename... Args>
+void format_femtolog(benchmark::State& state, Args&&... args) {
+  using Dispatcher = femtolog::logging::DeserializeDispatcher<
+      false, femtolog::serialized_arg_t<Args>...>;
+  constexpr femtolog::DeserializeAndFormatFunction deserialize =
+      compiled ? Dispatcher::template compiled_function<fmt>()
+               : Dispatcher::function();
+  constexpr femtolog::FormatFunction format =
+      femtolog::FormatDispatcher<fmt>::function();
+
+  std::array<char, 1024> payload;
+  femtolog::logging::serialize_args_to<false, Args...>(
+      payload.data(), std::forward<Args>(args)...);
+
+  fmt::memory_buffer buffer;
+  buffer.reserve(1024);
+  for (auto _ : state) {
+    buffer.clear();
+    std::size_t size = deserialize(&buffer, format, payload.data());
+    benchmark::DoNotOptimize(size);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+template <bool compiled>
+void format_femtolog_int(benchmark::State& state) {
+  format_femtolog<"Value: {}\n", compiled>(state, 123);
+}
+BENCHMARK(format_femtolog_int<false>);
+BENCHMARK(format_femtolog_int<true>);
+
+template <bool compiled>
+void format_femtolog_multi_int(benchmark::State& state) {
+  format_femtolog<"A: {}, B: {}, C: {}\n", compiled>(state, 1, 2, 3);
+}
+BENCHMARK(format_femtolog_multi_int<false>);
+BENCHMARK(format_femtolog_multi_int<true>);
+
+template <bool compiled>
+void format_femtolog_small_string(benchmark::State& state) {
+  const std::string user = "benchmark_user";
+  format_femtolog<"User: {}\n", compiled>(state, user);
+}
+BENCHMARK(format_femtolog_small_string<false>);
+BENCHMARK(format_femtolog_small_string<true>);
+
+template <bool compiled>
+void format_femtolog_mixed(benchmark::State& state) {
+  const std::string user = "user42";
+  const std::string_view op = "login";
+  format_femtolog<"User: {}, Op: {}, Success: {}, ID: {}\n", compiled>(
+      state, user, op, true, int64_t{9876543210});
+}
+BENCHMARK(format_femtolog_mixed<false>);
+BENCHMARK(format_femtolog_mixed<true>);
+
+template <bool compiled>
+void format_femtolog_float(benchmark::State& state) {
+  format_femtolog<"value = {}, name = {}, pi = {:.2f}\n", compiled>(
+      state, value, name, pi);
+}
+BENCHMARK(format_femtolog_float<false>);
+BENCHMARK(format_femtolog_float<true>);
+
+template <bool compiled>
+void format_femtolog_large_string(benchmark::State& state) {
+  const std::string payload(512, 'X');
+  format_femtolog<"Payload: {}\n", compiled>(state, payload);
+}
+BENCHMARK(format_femtolog_large_string<false>);
+BENCHMARK(format_femtolog_large_string<true>);
+
 }  // namespace
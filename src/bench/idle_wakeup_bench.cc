@@ -0,0 +1,155 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <thread>
+
+#include "bench/benchmark_util.h"
+#include "benchmark/benchmark.h"
+#include "femtolog/logger.h"
+#include "femtolog/options.h"
+#include "femtolog/sinks/sink_base.h"
+
+namespace femtolog {
+
+namespace {
+
+// Compares BackendWaitStrategy::kPolling with kEventDriven on a logger that is
+// idle most of the time: how long the first message after an idle period
+// takes to reach the sink, and how much CPU an idle backend burns.
+
+constexpr auto kIdlePeriod = std::chrono::milliseconds(20);
+constexpr auto kIdleCpuWindow = std::chrono::milliseconds(200);
+
+// Records when the backend delivered the last entry.
+class ArrivalSink final : public SinkBase {
+ public:
+  explicit ArrivalSink(std::atomic<int64_t>* arrival_ns)
+      : arrival_ns_(arrival_ns) {}
+  ~ArrivalSink() override = default;
+
+  void on_log(const LogEntry&, const char*, std::size_t) override {
+    arrival_ns_->store(now_ns(), std::memory_order_release);
+  }
+
+  static int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+ private:
+  std::atomic<int64_t>* arrival_ns_;
+};
+
+// Logger::logger() is per thread and its dedicated backend keeps the options
+// of its first init, so every case runs on a fresh thread.
+template <typename Fn>
+void run_on_fresh_thread(benchmark::State& state, Fn fn) {
+  std::thread thread([&] { fn(state); });
+  thread.join();
+}
+
+constexpr FemtologOptions make_options(BackendWaitStrategy strategy) {
+  FemtologOptions options;
+  options.backend_worker_cpu_affinity = std::numeric_limits<std::size_t>::max();
+  options.backend_wait_strategy = strategy;
+  return options;
+}
+
+template <BackendWaitStrategy strategy>
+void femtolog_idle_to_first_message(benchmark::State& state) {
+  std::atomic<int64_t> arrival_ns = 0;
+  Logger& logger = Logger::logger();
+  logger.init(make_options(strategy));
+  logger.register_sink<ArrivalSink>(&arrival_ns);
+  logger.start_worker();
+
+  for (auto _ : state) {
+    std::this_thread::sleep_for(kIdlePeriod);
+    arrival_ns.store(0, std::memory_order_relaxed);
+
+    const int64_t begin_ns = ArrivalSink::now_ns();
+    logger.info<"wake up\n">();
+    int64_t end_ns;
+    while ((end_ns = arrival_ns.load(std::memory_order_acquire)) == 0) {
+      std::this_thread::yield();
+    }
+    state.SetIterationTime(static_cast<double>(end_ns - begin_ns) * 1e-9);
+  }
+
+  logger.stop_worker();
+  logger.reset_count();
+  logger.clear_sinks();
+}
+
+template <BackendWaitStrategy strategy>
+void femtolog_idle_cpu(benchmark::State& state) {
+  std::atomic<int64_t> arrival_ns = 0;
+  Logger& logger = Logger::logger();
+  logger.init(make_options(strategy));
+  logger.register_sink<ArrivalSink>(&arrival_ns);
+  logger.start_worker();
+
+  // Let the backend settle into its idlest state first.
+  std::this_thread::sleep_for(kIdlePeriod);
+
+  double cpu_seconds = 0;
+  double wall_seconds = 0;
+  for (auto _ : state) {
+    const double cpu_begin = bench::process_cpu_seconds();
+    const auto wall_begin = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(kIdleCpuWindow);
+    cpu_seconds += bench::process_cpu_seconds() - cpu_begin;
+    wall_seconds += std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - wall_begin)
+                        .count();
+  }
+  state.counters["idle cpu usage (cores)"] = cpu_seconds / wall_seconds;
+
+  logger.stop_worker();
+  logger.reset_count();
+  logger.clear_sinks();
+}
+
+void femtolog_idle_to_first_message_polling(benchmark::State& state) {
+  constexpr auto kStrategy = BackendWaitStrategy::kPolling;
+  run_on_fresh_thread(state, femtolog_idle_to_first_message<kStrategy>);
+}
+BENCHMARK(femtolog_idle_to_first_message_polling)
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond)
+    ->Iterations(50);
+
+void femtolog_idle_to_first_message_event_driven(benchmark::State& state) {
+  constexpr auto kStrategy = BackendWaitStrategy::kEventDriven;
+  run_on_fresh_thread(state, femtolog_idle_to_first_message<kStrategy>);
+}
+BENCHMARK(femtolog_idle_to_first_message_event_driven)
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond)
+    ->Iterations(50);
+
+void femtolog_idle_cpu_polling(benchmark::State& state) {
+  run_on_fresh_thread(state, femtolog_idle_cpu<BackendWaitStrategy::kPolling>);
+}
+BENCHMARK(femtolog_idle_cpu_polling)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Iterations(5);
+
+void femtolog_idle_cpu_event_driven(benchmark::State& state) {
+  constexpr auto kStrategy = BackendWaitStrategy::kEventDriven;
+  run_on_fresh_thread(state, femtolog_idle_cpu<kStrategy>);
+}
+BENCHMARK(femtolog_idle_cpu_event_driven)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Iterations(5);
+
+}  // namespace
+
+}  // namespace femtolog
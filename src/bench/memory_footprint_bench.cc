@@ -0,0 +1,49 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "bench/benchmark_util.h"
+#include "benchmark/benchmark.h"
+#include "femtolog/logger.h"
+#include "femtolog/options.h"
+
+namespace femtolog {
+
+namespace {
+
+// Resident memory added by each initialized logger, i.e. what every thread
+// that logs costs the process before it writes its first entry. Runs a
+// single iteration, since memory freed by a previous one would be reused.
+
+constexpr std::size_t kLoggerCount = 256;
+
+void femtolog_memory_footprint_per_logger(benchmark::State& state) {
+  FemtologOptions options;
+  options.backend_worker_cpu_affinity = std::numeric_limits<std::size_t>::max();
+
+  for (auto _ : state) {
+    std::vector<Logger> loggers;
+    loggers.reserve(kLoggerCount);
+
+    const std::size_t rss_begin = bench::process_rss_bytes();
+    for (std::size_t i = 0; i < kLoggerCount; ++i) {
+      loggers.push_back(Logger::create_logger());
+      loggers.back().init(options);
+    }
+    const std::size_t rss_end = bench::process_rss_bytes();
+
+    state.counters["rss per logger (KiB)"] =
+        static_cast<double>(rss_end - rss_begin) / kLoggerCount / 1024.0;
+  }
+}
+BENCHMARK(femtolog_memory_footprint_per_logger)
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+
+}  // namespace femtolog
@@ -0,0 +1,111 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#include <chrono>
+#include <limits>
+
+#include "bench/benchmark_util.h"
+#include "benchmark/benchmark.h"
+#include "femtolog/logger.h"
+#include "femtolog/options.h"
+#include "femtolog/sinks/null_sink.h"
+
+namespace femtolog {
+
+namespace {
+
+// Compares one backend thread per producer (BackendMode::kDedicated) with the
+// process-wide shared backend (BackendMode::kShared) for 1, 8 and 64 producer
+// threads. Besides throughput, reports the whole process CPU usage in cores
+// (CPU seconds / wall seconds) observed while the producers were logging, which
+// is where per-thread spinning backends show their cost.
+
+constexpr FemtologOptions make_options(BackendMode mode) {
+  FemtologOptions options;
+  options.spsc_queue_size = 1024 * 256;
+  options.backend_format_buffer_size = 1024 * 64;
+  options.backend_dequeue_buffer_size = 1024 * 64;
+  options.backend_worker_cpu_affinity = std::numeric_limits<std::size_t>::max();
+  options.backend_mode = mode;
+  options.shared_backend_worker_count = 1;
+  return options;
+}
+
+// Keeps the shared backend alive across the producer threads of a
+// shared-mode benchmark run, so the workers are not restarted by every thread.
+void setup_shared_backend(const benchmark::State&) {
+  static bool initialized = false;
+
+  Logger& owner = Logger::global_logger();
+  if (!initialized) {
+    owner.init(make_options(BackendMode::kShared));
+    Logger::register_shared_sink<NullSink>();
+    initialized = true;
+  }
+  owner.start_worker();
+}
+
+void teardown_shared_backend(const benchmark::State&) {
+  Logger::global_logger().stop_worker();
+}
+
+template <BackendMode mode>
+void femtolog_multi_thread_info_format_int(benchmark::State& state) {
+  Logger& logger = Logger::logger();
+  logger.init(make_options(mode));
+  if constexpr (mode == BackendMode::kDedicated) {
+    logger.register_sink<NullSink>();
+  }
+  logger.start_worker();
+
+  const double cpu_begin = bench::process_cpu_seconds();
+  const auto wall_begin = std::chrono::steady_clock::now();
+
+  for (auto _ : state) {
+    logger.info<"Value: {}\n">(123);
+  }
+  logger.flush();
+
+  if (state.thread_index() == 0) {
+    const double wall_seconds = std::chrono::duration<double>(
+                                    std::chrono::steady_clock::now() -
+                                    wall_begin)
+                                    .count();
+    state.counters["cpu usage (cores)"] =
+        (bench::process_cpu_seconds() - cpu_begin) / wall_seconds;
+  }
+  state.counters["enqueued count"] = logger.enqueued_count();
+  state.counters["dropped count"] = logger.dropped_count();
+  state.SetItemsProcessed(state.iterations());
+
+  logger.stop_worker();
+  logger.reset_count();
+  if constexpr (mode == BackendMode::kDedicated) {
+    logger.clear_sinks();
+  }
+}
+
+void femtolog_multi_thread_dedicated(benchmark::State& state) {
+  femtolog_multi_thread_info_format_int<BackendMode::kDedicated>(state);
+}
+BENCHMARK(femtolog_multi_thread_dedicated)
+    ->Threads(1)
+    ->Threads(8)
+    ->Threads(64)
+    ->UseRealTime();
+
+void femtolog_multi_thread_shared(benchmark::State& state) {
+  femtolog_multi_thread_info_format_int<BackendMode::kShared>(state);
+}
+BENCHMARK(femtolog_multi_thread_shared)
+    ->Setup(setup_shared_backend)
+    ->Teardown(teardown_shared_backend)
+    ->Threads(1)
+    ->Threads(8)
+    ->Threads(64)
+    ->UseRealTime();
+
+}  // namespace
+
+}  // namespace femtolog
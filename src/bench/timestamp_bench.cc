@@ -0,0 +1,76 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#include <cstdint>
+
+#include "benchmark/benchmark.h"
+#include "femtolog/base/format_util.h"
+#include "femtolog/base/log_entry.h"
+#include "femtolog/sinks/layout.h"
+#include "femtolog/sinks/sink_base.h"
+#include "fmt/chrono.h"
+#include "fmt/format.h"
+
+namespace {
+
+using femtolog::FixedString;
+using femtolog::Layout;
+using femtolog::LogEntry;
+using femtolog::TimeZone;
+
+// Entries one microsecond apart, as at a million lines per second.
+constexpr uint64_t kLineIntervalNs = 1000;
+
+// Exposes SinkBase::format_timestamp(), which renders every field per entry.
+class ChronoTimestamp : public femtolog::SinkBase {
+ public:
+  using SinkBase::format_timestamp;
+
+  void on_log(const LogEntry&, const char*, std::size_t) override {}
+};
+
+void timestamp_fmt_chrono(benchmark::State& state) {
+  uint64_t timestamp_ns = femtolog::timestamp_ns();
+  char buffer[64];
+  for (auto _ : state) {
+    const std::size_t size =
+        ChronoTimestamp::format_timestamp<TimeZone::kLocal,
+                                          "[{:%Y-%m-%d %H:%M:%S}.{:09d}] ">(
+            timestamp_ns, buffer, sizeof(buffer));
+    benchmark::DoNotOptimize(size);
+    benchmark::DoNotOptimize(buffer);
+    timestamp_ns += kLineIntervalNs;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(timestamp_fmt_chrono);
+
+// Renders the timestamp of a layout, with lines `interval_ns` apart.
+template <uint64_t interval_ns>
+void timestamp_layout(benchmark::State& state) {
+  using TimestampLayout = Layout<"[{time:%Y-%m-%d %H:%M:%S.%9}] {msg}">;
+  LogEntry entry;
+  entry.timestamp_ns = femtolog::timestamp_ns();
+  fmt::memory_buffer buffer;
+  for (auto _ : state) {
+    buffer.clear();
+    TimestampLayout::format_prefix(entry, &buffer);
+    benchmark::DoNotOptimize(buffer.data());
+    entry.timestamp_ns += interval_ns;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void timestamp_layout_1m_lines_per_sec(benchmark::State& state) {
+  timestamp_layout<kLineIntervalNs>(state);
+}
+BENCHMARK(timestamp_layout_1m_lines_per_sec);
+
+// Every line in a new second, so the calendar is rendered every time.
+void timestamp_layout_new_second_per_line(benchmark::State& state) {
+  timestamp_layout<1'000'000'000>(state);
+}
+BENCHMARK(timestamp_layout_new_second_per_line);
+
+}  // namespace
@@ -206,6 +206,22 @@ macro(femtolog_setup_common_flags)
   else()
     list(APPEND FEMTOLOG_COMPILE_DEFINITIONS FEMTOLOG_ENABLE_AVX2=0)
   endif()
+
+  # The header is checked for by femtolog/build/build_flag.h.
+  if(FEMTOLOG_ENABLE_IO_URING)
+    list(APPEND FEMTOLOG_COMPILE_DEFINITIONS FEMTOLOG_ENABLE_IO_URING=1)
+  else()
+    list(APPEND FEMTOLOG_COMPILE_DEFINITIONS FEMTOLOG_ENABLE_IO_URING=0)
+  endif()
+
+  # Compile-time log level stripping. The index matches femtolog::LogLevel.
+  set(FEMTOLOG_LEVEL_NAMES raw fatal error warn info debug trace)
+  string(TOLOWER "${FEMTOLOG_ACTIVE_LEVEL}" lower_active_level)
+  list(FIND FEMTOLOG_LEVEL_NAMES "${lower_active_level}" FEMTOLOG_ACTIVE_LEVEL_VALUE)
+  if(FEMTOLOG_ACTIVE_LEVEL_VALUE EQUAL -1)
+    message(FATAL_ERROR "unknown FEMTOLOG_ACTIVE_LEVEL: ${FEMTOLOG_ACTIVE_LEVEL}. expected one of ${FEMTOLOG_LEVEL_NAMES}")
+  endif()
+  list(APPEND FEMTOLOG_COMPILE_DEFINITIONS FEMTOLOG_ACTIVE_LEVEL=${FEMTOLOG_ACTIVE_LEVEL_VALUE})
 endmacro()
 
 macro(femtolog_setup_flags)
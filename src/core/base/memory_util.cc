@@ -4,5 +4,75 @@
 
 #include "femtolog/core/base/memory_util.h"
 
-namespace femtolog::core {}  // namespace femtolog::core
+#if FEMTOLOG_IS_LINUX
+#include <unistd.h>
+#endif
 
+namespace femtolog::core {
+
+void* mirrored_alloc(std::size_t size) {
+#if FEMTOLOG_IS_LINUX
+  if (size == 0 || size % mirrored_alloc_granularity() != 0) {
+    return nullptr;
+  }
+
+  const int fd = memfd_create("femtolog_ring", MFD_CLOEXEC);
+  if (fd < 0) {
+    return nullptr;
+  }
+  if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    close(fd);
+    return nullptr;
+  }
+
+  // Reserve the address range first so that both views land next to each
+  // other, then map the same pages over each half.
+  void* base = mmap(nullptr, size * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS,
+                    -1, 0);
+  if (base == MAP_FAILED) {
+    close(fd);
+    return nullptr;
+  }
+  std::byte* first = static_cast<std::byte*>(base);
+  std::byte* second = first + size;
+  const bool mapped =
+      mmap(first, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd,
+           0) == first &&
+      mmap(second, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd,
+           0) == second;
+  // The mappings keep the memory alive.
+  close(fd);
+
+  if (!mapped) {
+    munmap(base, size * 2);
+    return nullptr;
+  }
+  return base;
+#else
+  static_cast<void>(size);
+  return nullptr;
+#endif
+}
+
+void mirrored_free(void* ptr, std::size_t size) {
+#if FEMTOLOG_IS_LINUX
+  if (ptr) {
+    munmap(ptr, size * 2);
+  }
+#else
+  static_cast<void>(ptr);
+  static_cast<void>(size);
+#endif
+}
+
+std::size_t mirrored_alloc_granularity() {
+#if FEMTOLOG_IS_LINUX
+  static const std::size_t page_size =
+      static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+  return page_size;
+#else
+  return 1;
+#endif
+}
+
+}  // namespace femtolog::core
@@ -0,0 +1,106 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#include "femtolog/core/base/tsc_clock.h"
+
+#include <chrono>
+
+namespace femtolog::core {
+
+namespace {
+
+// Busy-wait window used for the first, per-process rate estimate.
+constexpr uint64_t kCalibrationWindowNs = 2000000;
+
+struct Anchor {
+  uint64_t ticks;
+  uint64_t monotonic_ns;
+  uint64_t realtime_ns;
+};
+
+inline uint64_t monotonic_ns() noexcept {
+#if FEMTOLOG_IS_LINUX
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+#else
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+#endif
+}
+
+inline uint64_t realtime_ns() noexcept {
+#if FEMTOLOG_IS_LINUX
+  timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+#else
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count());
+#endif
+}
+
+// Samples the tick counter on both sides of the clock reads and takes the
+// midpoint, so the pairing error is at most half the read latency.
+Anchor read_anchor() noexcept {
+  const uint64_t before = tsc_ticks();
+  const uint64_t mono = monotonic_ns();
+  const uint64_t real = realtime_ns();
+  const uint64_t after = tsc_ticks();
+  return Anchor{before + (after - before) / 2, mono, real};
+}
+
+double initial_ns_per_tick() noexcept {
+  if constexpr (!kHasTsc) {
+    // tsc_ticks() already returns nanoseconds.
+    return 1.0;
+  }
+
+  static const double ns_per_tick = [] {
+    const Anchor begin = read_anchor();
+    Anchor end = read_anchor();
+    while (end.monotonic_ns - begin.monotonic_ns < kCalibrationWindowNs) {
+      end = read_anchor();
+    }
+    return static_cast<double>(end.monotonic_ns - begin.monotonic_ns) /
+           static_cast<double>(end.ticks - begin.ticks);
+  }();
+  return ns_per_tick;
+}
+
+}  // namespace
+
+TscClock::TscClock(uint64_t resync_interval_ns)
+    : ns_per_tick_(initial_ns_per_tick()),
+      resync_interval_ns_(resync_interval_ns) {
+  const Anchor anchor = read_anchor();
+  rate_ticks_ = anchor.ticks;
+  rate_monotonic_ns_ = anchor.monotonic_ns;
+  base_ticks_ = anchor.ticks;
+  base_ns_ = anchor.realtime_ns;
+  resync_ticks_ = static_cast<int64_t>(
+      static_cast<double>(resync_interval_ns_) / ns_per_tick_);
+}
+
+void TscClock::resync() noexcept {
+  const Anchor anchor = read_anchor();
+  if constexpr (kHasTsc) {
+    if (anchor.ticks > rate_ticks_ &&
+        anchor.monotonic_ns > rate_monotonic_ns_) [[likely]] {
+      ns_per_tick_ =
+          static_cast<double>(anchor.monotonic_ns - rate_monotonic_ns_) /
+          static_cast<double>(anchor.ticks - rate_ticks_);
+    }
+  }
+  base_ticks_ = anchor.ticks;
+  base_ns_ = anchor.realtime_ns;
+  resync_ticks_ = static_cast<int64_t>(
+      static_cast<double>(resync_interval_ns_) / ns_per_tick_);
+}
+
+}  // namespace femtolog::core
@@ -0,0 +1,48 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#include "benchmark/benchmark.h"
+#include "femtolog/base/format_util.h"
+#include "femtolog/core/base/tsc_clock.h"
+
+namespace femtolog::core {
+
+namespace {
+
+// Frontend cost: what the producer pays per entry for each timestamp source.
+void tsc_clock_tsc_ticks(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(tsc_ticks());
+  }
+}
+BENCHMARK(tsc_clock_tsc_ticks);
+
+void tsc_clock_coarse_monotonic_ns(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(coarse_monotonic_ns());
+  }
+}
+BENCHMARK(tsc_clock_coarse_monotonic_ns);
+
+// Backend cost: stamping at dequeue time versus converting frontend ticks.
+void tsc_clock_realtime_timestamp_ns(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(timestamp_ns());
+  }
+}
+BENCHMARK(tsc_clock_realtime_timestamp_ns);
+
+void tsc_clock_to_ns(benchmark::State& state) {
+  TscClock clock;
+  uint64_t ticks = tsc_ticks();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(clock.to_ns(ticks));
+    ticks += 64;
+  }
+}
+BENCHMARK(tsc_clock_to_ns);
+
+}  // namespace
+
+}  // namespace femtolog::core
@@ -0,0 +1,78 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#include "femtolog/core/base/tsc_clock.h"
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+namespace femtolog::core {
+
+namespace {
+
+// Generous enough for the coarse clock fallback (a few milliseconds).
+constexpr int64_t kToleranceNs = 10000000;
+
+int64_t realtime_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+TEST(TscClockTest, ConvertsToWallClock) {
+  TscClock clock;
+  EXPECT_GT(clock.ns_per_tick(), 0.0);
+
+  const int64_t before = realtime_ns();
+  const uint64_t ticks = tsc_ticks();
+  const int64_t after = realtime_ns();
+
+  const int64_t converted = static_cast<int64_t>(clock.to_ns(ticks));
+  EXPECT_GE(converted, before - kToleranceNs);
+  EXPECT_LE(converted, after + kToleranceNs);
+}
+
+TEST(TscClockTest, PreservesOrdering) {
+  TscClock clock;
+  uint64_t previous = clock.to_ns(tsc_ticks());
+  for (int i = 0; i < 1000; ++i) {
+    const uint64_t current = clock.to_ns(tsc_ticks());
+    EXPECT_GE(current, previous);
+    previous = current;
+  }
+}
+
+TEST(TscClockTest, ResyncKeepsTrackingWallClock) {
+  // Resync every millisecond so the conversion below crosses several anchors.
+  TscClock clock(1000000);
+  for (int i = 0; i < 5; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(3));
+    const int64_t before = realtime_ns();
+    const uint64_t ticks = tsc_ticks();
+    const int64_t after = realtime_ns();
+
+    const int64_t converted = static_cast<int64_t>(clock.to_ns(ticks));
+    EXPECT_GE(converted, before - kToleranceNs);
+    EXPECT_LE(converted, after + kToleranceNs);
+  }
+}
+
+TEST(TscClockTest, ConvertsTicksTakenBeforeResync) {
+  TscClock clock(1000000);
+  const uint64_t old_ticks = tsc_ticks();
+  const int64_t old_wall = realtime_ns();
+  std::this_thread::sleep_for(std::chrono::milliseconds(3));
+  clock.resync();
+
+  const int64_t converted = static_cast<int64_t>(clock.to_ns(old_ticks));
+  EXPECT_NEAR(static_cast<double>(converted), static_cast<double>(old_wall),
+              static_cast<double>(kToleranceNs));
+}
+
+}  // namespace femtolog::core
@@ -0,0 +1,165 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#ifndef INCLUDE_FEMTOLOG_BASE_CALL_SITE_H_
+#define INCLUDE_FEMTOLOG_BASE_CALL_SITE_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+
+#include "femtolog/base/format_util.h"
+#include "femtolog/base/log_level.h"
+#include "femtolog/base/serialize_util.h"
+#include "femtolog/base/string_registry.h"
+#include "femtolog/build/build_flag.h"
+#include "femtolog/core/check.h"
+
+namespace femtolog {
+
+// Everything about a log call that is the same from one call to the next.
+// Queued entries refer to it by index instead of repeating it.
+struct CallSite {
+  LogLevel level = LogLevel::kInfo;
+  StringId format_id = 0;
+  // The format string, or the whole message of a literal call site.
+  std::string_view format;
+  // Both null for literal call sites. Log calls register a deserializer that
+  // formats with `format` compiled, which ignores `format_func`.
+  FormatFunction format_func = nullptr;
+  DeserializeAndFormatFunction deserialize_and_format_func = nullptr;
+
+  [[nodiscard]] inline bool is_literal() const noexcept {
+    return deserialize_and_format_func == nullptr;
+  }
+};
+
+// Process-wide, append-only table of call sites. Call sites are registered
+// before main() (see StaticCallSiteRegistration), so the log path only reads
+// an index, and the backend resolves indices without locking.
+class CallSiteRegistry {
+ public:
+  CallSiteRegistry() = default;
+  ~CallSiteRegistry() = default;
+
+  CallSiteRegistry(const CallSiteRegistry&) = delete;
+  CallSiteRegistry& operator=(const CallSiteRegistry&) = delete;
+
+  CallSiteRegistry(CallSiteRegistry&&) noexcept = delete;
+  CallSiteRegistry& operator=(CallSiteRegistry&&) noexcept = delete;
+
+  static CallSiteRegistry& instance() {
+    static CallSiteRegistry registry;
+    return registry;
+  }
+
+  // Returns the index of the new call site, which is never zero, or zero if
+  // the table is full. Strings in `site` must outlive the registry.
+  uint32_t register_call_site(const CallSite& site) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (size_ == kMaxCallSites) [[unlikely]] {
+      return 0;
+    }
+    const std::size_t chunk_index = size_ / kChunkSize;
+    Chunk* chunk = chunks_[chunk_index].load(std::memory_order_relaxed);
+    if (!chunk) {
+      chunk_storage_[chunk_index] = std::make_unique<Chunk>();
+      chunk = chunk_storage_[chunk_index].get();
+      chunks_[chunk_index].store(chunk, std::memory_order_release);
+    }
+    (*chunk)[size_ % kChunkSize] = site;
+    return static_cast<uint32_t>(++size_);
+  }
+
+  // Lock-free. The registration of `index` must happen-before this call, as
+  // it does for indices read from a queued entry.
+  [[nodiscard]] inline const CallSite& get(uint32_t index) const noexcept {
+    FEMTOLOG_DCHECK_GT(index, 0u);
+    const std::size_t slot = index - 1;
+    const Chunk* chunk =
+        chunks_[slot / kChunkSize].load(std::memory_order_acquire);
+    return (*chunk)[slot % kChunkSize];
+  }
+
+  std::size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size_;
+  }
+
+  std::size_t memory_usage() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return (size_ + kChunkSize - 1) / kChunkSize * sizeof(Chunk);
+  }
+
+ private:
+  static constexpr std::size_t kChunkSize = 256;
+  static constexpr std::size_t kChunkCount = 256;
+  static constexpr std::size_t kMaxCallSites = kChunkSize * kChunkCount;
+  using Chunk = std::array<CallSite, kChunkSize>;
+
+  mutable std::mutex mutex_;
+  // Append-only, so readers only need the chunk pointer.
+  std::array<std::atomic<Chunk*>, kChunkCount> chunks_{};
+  std::array<std::unique_ptr<Chunk>, kChunkCount> chunk_storage_;
+  std::size_t size_ = 0;
+};
+
+// Registers the call site logging `fmt` at `level` from its constructor. One
+// instance exists per call site, as a variable template specialization, and
+// is dynamically initialized before main(). Calls made before that register
+// the call site on first use instead. `deserialize` is null for literals.
+template <LogLevel level,
+          FixedString fmt,
+          DeserializeAndFormatFunction deserialize>
+class StaticCallSiteRegistration {
+ public:
+  StaticCallSiteRegistration() { static_cast<void>(index()); }
+
+  // Zero if the registry is full.
+  [[nodiscard]] inline uint32_t index() noexcept {
+    const uint32_t index = index_.load(std::memory_order_acquire);
+    if (index != 0) [[likely]] {
+      return index;
+    }
+    return register_now();
+  }
+
+ private:
+  FEMTOLOG_NO_INLINE uint32_t register_now() noexcept {
+    CallSite site;
+    site.level = level;
+    site.format = fmt.view();
+    if constexpr (deserialize == nullptr) {
+      site.format_id = kLiteralLogStringId;
+    } else {
+      site.format_id = StringRegistry::get_string_id<fmt>();
+      site.format_func = FormatDispatcher<fmt>::function();
+      site.deserialize_and_format_func = deserialize;
+    }
+    uint32_t index = CallSiteRegistry::instance().register_call_site(site);
+    uint32_t expected = 0;
+    // A racing first use may have won; its index is as good as ours.
+    if (!index_.compare_exchange_strong(expected, index,
+                                        std::memory_order_acq_rel)) {
+      index = expected;
+    }
+    return index;
+  }
+
+  std::atomic<uint32_t> index_ = 0;
+};
+
+template <LogLevel level,
+          FixedString fmt,
+          DeserializeAndFormatFunction deserialize>
+inline StaticCallSiteRegistration<level, fmt, deserialize>
+    static_call_site_registration;
+
+}  // namespace femtolog
+
+#endif  // INCLUDE_FEMTOLOG_BASE_CALL_SITE_H_
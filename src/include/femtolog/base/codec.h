@@ -0,0 +1,56 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#ifndef INCLUDE_FEMTOLOG_BASE_CODEC_H_
+#define INCLUDE_FEMTOLOG_BASE_CODEC_H_
+
+#include <concepts>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace femtolog {
+
+// Customization point for logging arguments that are neither strings nor
+// trivially copyable, such as domain objects. Specialize it to have the log
+// call encode the argument into the queue and the backend thread decode and
+// format it, instead of formatting it on the logging thread:
+//
+//   template <>
+//   struct femtolog::codec<Order> {
+//     // Bytes encode() writes for `value`.
+//     static std::size_t size(const Order& value);
+//     // Writes `value` to `dst` and returns the position past it.
+//     static char* encode(char* dst, const Order& value);
+//     // Reads back the `size` bytes at `src` as a value fmt can format.
+//     static OrderView decode(const char* src, std::size_t size);
+//   };
+//
+// encode() runs on the logging thread and decode() on the backend thread,
+// possibly after the logged object is gone, so the encoding must not point
+// into it. decode() may return a non-owning view into `src`, which stays valid
+// until the entry has been formatted.
+template <typename T>
+struct codec;
+
+template <typename T>
+concept HasCodec =
+    requires(const T& value, char* dst, const char* src, std::size_t size) {
+      { codec<T>::size(value) } -> std::convertible_to<std::size_t>;
+      { codec<T>::encode(dst, value) } -> std::same_as<char*>;
+      codec<T>::decode(src, size);
+    };
+
+template <typename T>
+inline constexpr bool has_codec_v = HasCodec<std::decay_t<T>>;
+
+// What codec<T>::decode() returns, i.e. what the backend formats.
+template <typename T>
+using codec_decoded_t = decltype(codec<std::decay_t<T>>::decode(
+    std::declval<const char*>(),
+    std::declval<std::size_t>()));
+
+}  // namespace femtolog
+
+#endif  // INCLUDE_FEMTOLOG_BASE_CODEC_H_
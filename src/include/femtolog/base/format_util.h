@@ -11,6 +11,7 @@
 
 #include "femtolog/build/build_flag.h"
 #include "fmt/args.h"
+#include "fmt/compile.h"
 #include "fmt/core.h"
 #include "fmt/format.h"
 
@@ -55,16 +56,37 @@ inline uint64_t timestamp_ns() noexcept {
 #endif
 }
 
+// Appends the formatted message to the buffer and returns its length.
 using FormatFunction = std::size_t (*)(fmt::memory_buffer*,
                                        const fmt::format_args&);
 
+// The base of FMT_COMPILE() strings, which left fmt::detail in fmt 10.
+#if FMT_VERSION >= 100000
+using FmtCompiledString = fmt::compiled_string;
+#else
+using FmtCompiledString = fmt::detail::compiled_string;
+#endif
+
+// `fmt` as a format string for fmt's compiled API, like FMT_COMPILE(). It is
+// parsed at compile time into code specialized for the argument types, instead
+// of at every call.
+template <FixedString fmt>
+struct CompiledFormat : FmtCompiledString {
+  using char_type = char;
+
+  explicit constexpr operator fmt::basic_string_view<char>() const {
+    return fmt::basic_string_view<char>(fmt.data, fmt.size);
+  }
+};
+
+// Formats with a runtime format string and type-erased arguments.
 template <FixedString fmt>
 struct FormatDispatcher {
   static std::size_t format(fmt::memory_buffer* buf,
                             const fmt::format_args& args) {
-    auto result =
-        fmt::vformat_to_n(buf->data(), buf->capacity(), fmt.view(), args);
-    return result.size;
+    const std::size_t begin = buf->size();
+    fmt::vformat_to(fmt::appender(*buf), fmt.view(), args);
+    return buf->size() - begin;
   }
 
   static constexpr FormatFunction function() { return &format; }
@@ -5,64 +5,102 @@
 #ifndef INCLUDE_FEMTOLOG_BASE_LOG_ENTRY_H_
 #define INCLUDE_FEMTOLOG_BASE_LOG_ENTRY_H_
 
-#include <algorithm>
-#include <string_view>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 
+#include "femtolog/base/call_site.h"
 #include "femtolog/base/log_level.h"
+#include "femtolog/base/serialize_util.h"
 
 namespace femtolog {
 
+// A dequeued log entry, as the backend hands it to sinks.
 struct LogEntry {
-  LogEntry() = default;
-  ~LogEntry() = default;
+  uint64_t timestamp_ns = 0;
+  // The log call the entry came from.
+  const CallSite* call_site = nullptr;
+  uint32_t thread_id = 0;
+  // Bytes of serialized arguments the entry carried, in the queue or out of
+  // line.
+  uint32_t payload_len = 0;
+  uint16_t format_id = 0;
+  LogLevel level = LogLevel::kInfo;
+};
 
-  [[nodiscard]] inline const char* payload() const noexcept {
-    return reinterpret_cast<const char*>(this + 1);
-  }
+// Header of an entry in a log queue. Entries are packed back to back without
+// padding, each one being
+//
+//   call site index   4 bytes, see CallSiteRegistry, or'ed with the flags
+//   payload length    varint
+//   timestamp delta   varint, only in queues whose producer stamps entries:
+//                     ticks since the previous entry of the queue
+//   payload           serialized arguments
+//
+// The thread id and the timestamp base are the same for every entry of a
+// queue, so they live in its QueueMetadata instead.
+struct QueuedEntryHeader {
+  static constexpr std::size_t kMaxSize =
+      sizeof(uint32_t) + 2 * kMaxVarintSize;
 
-  [[nodiscard]] inline char* payload() noexcept {
-    return reinterpret_cast<char*>(this + 1);
-  }
+  // The payload is a LargeMessagePool::Buffer pointer; the arguments are in
+  // the buffer.
+  static constexpr uint32_t kOutOfLinePayload = 1u << 31;
+  // A string argument was cut short to fit OversizePolicy::kTruncate.
+  static constexpr uint32_t kTruncated = 1u << 30;
+  static constexpr uint32_t kCallSiteIndexMask = (1u << 30) - 1;
 
-  [[nodiscard]] inline std::string_view message_view() const noexcept {
-    return std::string_view(payload(), payload_len);
-  }
+  uint32_t call_site_index = 0;
+  uint32_t flags = 0;
+  uint32_t payload_len = 0;
+  uint64_t timestamp_delta = 0;
 
-  [[nodiscard]] inline constexpr std::size_t total_size() const noexcept {
-    return sizeof(LogEntry) + payload_len;
+  [[nodiscard, gnu::always_inline]] inline constexpr std::size_t size(
+      bool has_timestamp) const noexcept {
+    return sizeof(call_site_index) + varint_size(payload_len) +
+           (has_timestamp ? varint_size(timestamp_delta) : 0);
   }
 
-  [[nodiscard]] inline std::size_t copy_raw_payload(
-      char* dst_buf,
-      std::size_t dst_size) const noexcept {
-    std::size_t to_copy = std::min<std::size_t>(dst_size, payload_len);
-    std::memcpy(dst_buf, payload(), to_copy);
-    return to_copy;
+  // Returns where the payload goes.
+  [[gnu::always_inline]] inline char* encode(
+      char* dst,
+      bool has_timestamp) const noexcept {
+    const uint32_t word = call_site_index | flags;
+    std::memcpy(dst, &word, sizeof(word));
+    dst = write_varint(dst + sizeof(call_site_index), payload_len);
+    if (has_timestamp) {
+      dst = write_varint(dst, timestamp_delta);
+    }
+    return dst;
   }
 
-  [[nodiscard]] static LogEntry* create(void* buffer,
-                                        uint32_t thread_id,
-                                        uint16_t format_id,
-                                        LogLevel level,
-                                        uint64_t timestamp_ns,
-                                        const char* payload,
-                                        std::size_t payload_len) {
-    auto* entry = reinterpret_cast<LogEntry*>(buffer);
-    entry->timestamp_ns = timestamp_ns;
-    entry->thread_id = thread_id;
-    entry->format_id = format_id;
-    entry->payload_len = static_cast<uint16_t>(payload_len);
-    entry->level = level;
-
-    std::memcpy(entry->payload(), payload, payload_len);
-    return entry;
+  // Returns the size of the header at `src`, or zero if the `size` bytes
+  // there hold only part of it.
+  inline std::size_t decode(const char* src,
+                            std::size_t size,
+                            bool has_timestamp) noexcept {
+    if (size < sizeof(call_site_index)) [[unlikely]] {
+      return 0;
+    }
+    const char* end = src + size;
+    uint32_t word;
+    std::memcpy(&word, src, sizeof(word));
+    call_site_index = word & kCallSiteIndexMask;
+    flags = word & ~kCallSiteIndexMask;
+    uint64_t len;
+    const char* pos = read_varint(src + sizeof(call_site_index), end, &len);
+    if (!pos) [[unlikely]] {
+      return 0;
+    }
+    payload_len = static_cast<uint32_t>(len);
+    if (has_timestamp) {
+      pos = read_varint(pos, end, &timestamp_delta);
+      if (!pos) [[unlikely]] {
+        return 0;
+      }
+    }
+    return static_cast<std::size_t>(pos - src);
   }
-
-  uint16_t payload_len = 0;
-  uint16_t format_id = 0;
-  uint32_t thread_id = 0;
-  uint64_t timestamp_ns = 0;
-  LogLevel level = LogLevel::kInfo;
 };
 
 }  // namespace femtolog
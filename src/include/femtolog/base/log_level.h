@@ -8,6 +8,7 @@
 #include <cstdint>
 #include <string>
 
+#include "femtolog/build/build_flag.h"
 #include "femtolog/core/base/string_util.h"
 
 namespace femtolog {
@@ -26,6 +27,22 @@ enum class LogLevel : uint8_t {
   kMaxValue = kUnknown,
 };
 
+static_assert(static_cast<int>(LogLevel::kRaw) == FEMTOLOG_LEVEL_RAW &&
+              static_cast<int>(LogLevel::kFatal) == FEMTOLOG_LEVEL_FATAL &&
+              static_cast<int>(LogLevel::kError) == FEMTOLOG_LEVEL_ERROR &&
+              static_cast<int>(LogLevel::kWarn) == FEMTOLOG_LEVEL_WARN &&
+              static_cast<int>(LogLevel::kInfo) == FEMTOLOG_LEVEL_INFO &&
+              static_cast<int>(LogLevel::kDebug) == FEMTOLOG_LEVEL_DEBUG &&
+              static_cast<int>(LogLevel::kTrace) == FEMTOLOG_LEVEL_TRACE);
+
+// Least severe level compiled into the binary. See FEMTOLOG_ACTIVE_LEVEL.
+inline constexpr LogLevel kActiveLevel =
+    static_cast<LogLevel>(FEMTOLOG_ACTIVE_LEVEL);
+
+inline constexpr bool is_level_active(LogLevel level) {
+  return level <= kActiveLevel;
+}
+
 inline constexpr const char* log_level_to_lower_str(LogLevel level) {
   switch (level) {
     case LogLevel::kRaw: return "raw";
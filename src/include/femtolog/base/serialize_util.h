@@ -6,11 +6,18 @@
 #define INCLUDE_FEMTOLOG_BASE_SERIALIZE_UTIL_H_
 
 #include <algorithm>
+#include <bit>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <iterator>
 #include <new>
+#include <ranges>
 #include <string>
+#include <string_view>
+#include <type_traits>
 
+#include "femtolog/base/codec.h"
 #include "femtolog/base/format_util.h"
 #include "femtolog/base/string_registry.h"
 #include "femtolog/core/base/memory_util.h"
@@ -18,6 +25,9 @@
 
 namespace femtolog {
 
+// Decodes the serialized arguments at the last parameter, appends the message
+// formatted from them to the buffer and returns its length. The buffer may be
+// a sink's, with the sink's prefix already in it.
 using DeserializeAndFormatFunction = std::size_t (*)(fmt::memory_buffer*,
                                                      FormatFunction,
                                                      const char*);
@@ -33,6 +43,42 @@ struct SerializedArgsHeader {
         deserialize_and_format_func(deserialize_func_ptr) {}
 };
 
+// LEB128 varints: seven bits per byte, least significant group first, with
+// the high bit set on every byte but the last.
+inline constexpr std::size_t kMaxVarintSize = 10;
+
+[[nodiscard]] inline constexpr std::size_t varint_size(
+    uint64_t value) noexcept {
+  return (static_cast<std::size_t>(std::bit_width(value | 1)) + 6) / 7;
+}
+
+// Returns the position past the written bytes.
+inline char* write_varint(char* dst, uint64_t value) noexcept {
+  while (value >= 0x80) {
+    *dst++ = static_cast<char>(value | 0x80);
+    value >>= 7;
+  }
+  *dst++ = static_cast<char>(value);
+  return dst;
+}
+
+// Returns the position past the varint, or nullptr if it does not end before
+// `end`.
+inline const char* read_varint(const char* src,
+                               const char* end,
+                               uint64_t* value) noexcept {
+  uint64_t result = 0;
+  for (unsigned shift = 0; src < end && shift < 64; shift += 7) {
+    const auto byte = static_cast<uint8_t>(*src++);
+    result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (byte < 0x80) {
+      *value = result;
+      return src;
+    }
+  }
+  return nullptr;
+}
+
 template <std::size_t kCapacity = 8192>
 class SerializedArgs {
  public:
@@ -54,11 +100,110 @@ class SerializedArgs {
   std::size_t size_ = 0;
 };
 
+// A string with static storage duration, such as a string literal, a
+// constexpr std::string_view or the view() of a FixedString template argument.
+// The constructors are consteval, so only constant strings convert, and log
+// calls pass the string by pointer instead of copying it into the queue.
+// Wrap string literal arguments in it to have them passed by pointer:
+//
+//   logger.info<"op={}\n">(StaticString("login"));
+class StaticString {
+ public:
+  constexpr StaticString() noexcept : data_(""), size_(0) {}
+
+  consteval StaticString(std::string_view view)  // NOLINT
+      : data_(view.data()), size_(view.size()) {}
+
+  template <std::size_t N>
+  consteval StaticString(const char (&str)[N])  // NOLINT
+      : StaticString(std::string_view(str)) {}
+
+  [[nodiscard]] inline constexpr std::string_view view() const noexcept {
+    return std::string_view(data_, size_);
+  }
+
+ private:
+  const char* data_;
+  std::size_t size_;
+};
+
+// Elements of a trivially copyable type packed back to back in a log entry.
+// Entries make no alignment guarantees, so elements are loaded with memcpy
+// rather than read through a `const T*`.
+template <typename T>
+class PackedSpan {
+  static_assert(std::is_trivially_copyable_v<T>);
+
+ public:
+  class Iterator {
+   public:
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+
+    constexpr Iterator() noexcept = default;
+    explicit constexpr Iterator(const char* pos) noexcept : pos_(pos) {}
+
+    inline T operator*() const noexcept {
+      T value;
+      std::memcpy(&value, pos_, sizeof(T));
+      return value;
+    }
+    inline Iterator& operator++() noexcept {
+      pos_ += sizeof(T);
+      return *this;
+    }
+    inline Iterator operator++(int) noexcept {
+      Iterator it = *this;
+      ++*this;
+      return it;
+    }
+    inline bool operator==(const Iterator&) const noexcept = default;
+
+   private:
+    const char* pos_ = nullptr;
+  };
+
+  constexpr PackedSpan() noexcept = default;
+  constexpr PackedSpan(const char* data, std::size_t size) noexcept
+      : data_(data), size_(size) {}
+
+  [[nodiscard]] inline std::size_t size() const noexcept { return size_; }
+  [[nodiscard]] inline bool empty() const noexcept { return size_ == 0; }
+  [[nodiscard]] inline Iterator begin() const noexcept {
+    return Iterator(data_);
+  }
+  [[nodiscard]] inline Iterator end() const noexcept {
+    return Iterator(data_ + size_ * sizeof(T));
+  }
+  [[nodiscard]] inline T operator[](std::size_t index) const noexcept {
+    return *Iterator(data_ + index * sizeof(T));
+  }
+
+ private:
+  const char* data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+// Sized contiguous ranges of trivially copyable elements, such as
+// std::vector<int>, std::array<double, N> or std::span<const uint64_t>. Their
+// elements are copied into the entry and come out as a PackedSpan.
 template <typename T>
-struct IsFixedStringTrait : std::false_type {};
+struct TrivialRangeTrait : std::false_type {};
 
-template <std::size_t N>
-struct IsFixedStringTrait<const char (&)[N]> : std::true_type {};
+template <typename T>
+  requires std::ranges::contiguous_range<const T> &&
+           std::ranges::sized_range<const T> &&
+           std::is_trivially_copyable_v<std::ranges::range_value_t<const T>>
+struct TrivialRangeTrait<T> : std::true_type {
+  using element_type = std::ranges::range_value_t<const T>;
+};
+
+// Matches undecayed argument types. Only StaticString opts into being passed
+// by pointer: a const char array may as well be a local buffer or a member of
+// a short-lived object as a string literal, so char arrays are always copied.
+template <typename T>
+struct IsStaticStringTrait
+    : std::is_same<std::remove_cvref_t<T>, StaticString> {};
 
 template <typename T>
 struct ArgTypeInfo {
@@ -68,7 +213,7 @@ struct ArgTypeInfo {
       std::is_array_v<Decayed> &&
       std::is_same_v<std::remove_extent_t<Decayed>, char>;
 
-  static constexpr bool is_static_string = IsFixedStringTrait<Decayed>::value;
+  static constexpr bool is_static_string = IsStaticStringTrait<T>::value;
 
   static constexpr bool is_dynamic_string =
       (std::is_convertible_v<Decayed, std::string_view> ||
@@ -78,8 +223,18 @@ struct ArgTypeInfo {
 
   static constexpr bool is_string_like = is_dynamic_string || is_static_string;
 
+  // Encoded by a codec<T> specialization. Takes precedence over copying the
+  // bytes of trivially copyable types.
+  static constexpr bool has_codec = HasCodec<Decayed> && !is_string_like;
+
+  // Copied element-wise, even when the range object itself is trivially
+  // copyable like std::span.
+  static constexpr bool is_trivial_range =
+      TrivialRangeTrait<Decayed>::value && !is_string_like && !has_codec;
+
   static constexpr bool is_serializeable =
-      is_string_like || std::is_trivially_copyable_v<Decayed>;
+      is_string_like || has_codec || is_trivial_range ||
+      std::is_trivially_copyable_v<Decayed>;
 
   ArgTypeInfo() = delete;
 };
@@ -93,18 +248,67 @@ inline constexpr bool is_dynamic_string_v = ArgTypeInfo<T>::is_dynamic_string;
 template <typename T>
 inline constexpr bool is_string_like_v = ArgTypeInfo<T>::is_string_like;
 template <typename T>
+inline constexpr bool is_codec_encoded_v = ArgTypeInfo<T>::has_codec;
+template <typename T>
+inline constexpr bool is_trivial_range_v = ArgTypeInfo<T>::is_trivial_range;
+template <typename T>
+using range_element_t =
+    typename TrivialRangeTrait<std::decay_t<T>>::element_type;
+template <typename T>
 inline constexpr bool is_serializeable_v = ArgTypeInfo<T>::is_serializeable;
 
+// The type an argument of type `T` travels through the queue as. Static
+// strings of any type become a StaticString, so that the serializer and the
+// deserializer agree on their encoding.
+template <typename T>
+using serialized_arg_t =
+    std::conditional_t<is_static_string_v<T>, StaticString, std::decay_t<T>>;
+
+// Strings come back as views, either of the string a reference or a static
+// string points to, or of the bytes copied into the entry, so that the backend
+// never allocates to decode them.
 template <bool ref_mode, typename T>
 struct DeserializedArgType {
-  using type = std::conditional_t<
-      is_string_like_v<T>,
-      std::conditional_t<ref_mode, std::string_view, std::string>,
-      std::decay_t<T>>;
+  using type = std::conditional_t<is_string_like_v<T>,
+                                  std::string_view,
+                                  std::decay_t<T>>;
+};
+
+template <bool ref_mode, typename T>
+  requires is_codec_encoded_v<T>
+struct DeserializedArgType<ref_mode, T> {
+  using type = codec_decoded_t<T>;
+};
+
+template <bool ref_mode, typename T>
+  requires is_trivial_range_v<T>
+struct DeserializedArgType<ref_mode, T> {
+  using type = PackedSpan<range_element_t<T>>;
 };
 template <bool ref_mode, typename T>
 using deserialized_arg_type_t = typename DeserializedArgType<ref_mode, T>::type;
 
 }  // namespace femtolog
 
+// Formats like a range: "[1, 2, 3]", with the format spec applied to each
+// element.
+template <typename T>
+struct fmt::formatter<femtolog::PackedSpan<T>>
+    : fmt::formatter<fmt::join_view<typename femtolog::PackedSpan<T>::Iterator,
+                                    typename femtolog::PackedSpan<T>::Iterator,
+                                    char>> {
+  template <typename FormatContext>
+  auto format(const femtolog::PackedSpan<T>& span, FormatContext& ctx) const {
+    auto out = ctx.out();
+    *out++ = '[';
+    ctx.advance_to(out);
+    out = fmt::formatter<fmt::join_view<
+        typename femtolog::PackedSpan<T>::Iterator,
+        typename femtolog::PackedSpan<T>::Iterator,
+        char>>::format(fmt::join(span.begin(), span.end(), ", "), ctx);
+    *out++ = ']';
+    return out;
+  }
+};
+
 #endif  // INCLUDE_FEMTOLOG_BASE_SERIALIZE_UTIL_H_
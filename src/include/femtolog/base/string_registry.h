@@ -5,10 +5,13 @@
 #ifndef INCLUDE_FEMTOLOG_BASE_STRING_REGISTRY_H_
 #define INCLUDE_FEMTOLOG_BASE_STRING_REGISTRY_H_
 
-#include <array>
+#include <algorithm>
+#include <cstring>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 #include "femtolog/base/format_util.h"
@@ -40,51 +43,85 @@ inline StringId hash_string_from_pointer(const char* ptr) noexcept {
   return static_cast<StringId>((raw >> 3) ^ (raw & 0xFFFF));
 }
 
+// Maps format string ids to their text. There is one process-wide instance.
+// Format strings used by log calls are registered during static
+// initialization, before main() runs, so the log path never touches the
+// registry. Storage is a small open-addressed table that grows with the
+// number of distinct strings, plus an arena for strings that are not static.
+// Ids are 16-bit hashes; when two different strings hash to the same id, the
+// first one stays registered and the collision is counted. Thread-safe.
 class StringRegistry {
  public:
-  StringRegistry()
-      : table_(kUint16Max + 1),
-        arena_buffer_(std::make_unique<char[]>(kInitialArenaSize)) {
-    // Construct all string_view as empty string
-    table_.resize(table_.capacity());
-  }
-
+  StringRegistry() = default;
   ~StringRegistry() = default;
 
   StringRegistry(const StringRegistry&) = delete;
   StringRegistry& operator=(const StringRegistry&) = delete;
 
-  StringRegistry(StringRegistry&&) noexcept = default;
-  StringRegistry& operator=(StringRegistry&&) noexcept = default;
+  StringRegistry(StringRegistry&&) noexcept = delete;
+  StringRegistry& operator=(StringRegistry&&) noexcept = delete;
+
+  static StringRegistry& instance() {
+    static StringRegistry registry;
+    return registry;
+  }
+
+  // Makes sure `fixed_str` is registered in instance() at static
+  // initialization time. Generates no code at the call site.
+  template <FixedString fixed_str>
+  static inline void register_static();
 
   template <FixedString fixed_str>
-  inline void register_string() {
+  inline bool register_string() {
     constexpr StringId id = get_string_id<fixed_str>();
     constexpr std::string_view view(fixed_str.data, fixed_str.size);
-    set(id, view);
+    return register_string(id, view);
   }
 
-  void register_string(StringId id, std::string_view view) { set(id, view); }
-
-  void register_string_arena(StringId id, std::string_view view) {
-    FEMTOLOG_DCHECK_LE(arena_size_ + view.size(), arena_capacity_);
+  // Returns false if `id` is already taken by a different string.
+  bool register_string(StringId id, std::string_view view) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!check_collision(id, view)) {
+      return false;
+    }
+    set(id, view);
+    return true;
+  }
 
-    const std::string_view previous = table_[id];
-    if (!previous.empty() && previous == view) [[unlikely]] {
-      return;
+  // Same as register_string() but keeps a copy of `view`.
+  bool register_string_arena(StringId id, std::string_view view) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (find(id)) {
+      return check_collision(id, view);
     }
+    set(id, copy_to_arena(view));
+    return true;
+  }
 
-    char* dest = arena_buffer_.get() + arena_size_;
-    // include null termination
-    std::size_t len = view.size();
-    std::memcpy(dest, view.data(), len);
+  // Returns an empty view for unknown ids.
+  std::string_view get_string(StringId id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Slot* slot = find(id);
+    return slot ? slot->view : std::string_view();
+  }
 
-    std::string_view stored(dest, len);
-    arena_size_ += len;
-    set(id, stored);
+  std::size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size_;
   }
 
-  inline std::string_view get_string(StringId id) const { return table_[id]; }
+  // Number of registrations rejected because their id was taken by a
+  // different string.
+  std::size_t collision_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return collision_count_;
+  }
+
+  // Bytes held by the table and the arena.
+  std::size_t memory_usage() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return slots_.capacity() * sizeof(Slot) + arena_bytes_;
+  }
 
   template <FixedString fixed_str>
   static consteval StringId get_string_id() {
@@ -98,21 +135,133 @@ class StringRegistry {
   }
 
  private:
-  inline void set(StringId id, std::string_view view) {
+  // Returns false, and counts a collision, if `id` maps to a string other
+  // than `view`.
+  bool check_collision(StringId id, std::string_view view) {
+    const Slot* existing = find(id);
+    if (existing && existing->view != view) [[unlikely]] {
+      ++collision_count_;
+      return false;
+    }
+    return true;
+  }
+
+  struct Slot {
+    std::string_view view;
+    // `id + 1`, so that zero marks an empty slot.
+    uint32_t key = 0;
+  };
+
+  static constexpr std::size_t kInitialSlots = 64;
+  static constexpr std::size_t kArenaChunkSize = 4096;
+
+  // Ids are hashes already, so their low bits index the table directly.
+  const Slot* find(StringId id) const {
+    if (slots_.empty()) {
+      return nullptr;
+    }
+    const std::size_t mask = slots_.size() - 1;
+    for (std::size_t i = id & mask;; i = (i + 1) & mask) {
+      const Slot& slot = slots_[i];
+      if (slot.key == 0) {
+        return nullptr;
+      }
+      if (slot.key == static_cast<uint32_t>(id) + 1) {
+        return &slot;
+      }
+    }
+  }
+
+  void set(StringId id, std::string_view view) {
     FEMTOLOG_DCHECK_LT(id, kUint16Max);
-    table_[id] = view;
+    // Keep the load factor at or below one half.
+    if ((size_ + 1) * 2 > slots_.size()) {
+      rehash(std::max(kInitialSlots, slots_.size() * 2));
+    }
+    insert(id, view);
   }
 
-  static constexpr std::size_t kInitialArenaSize = 1024 * 1024;  // 1MiB
+  void insert(StringId id, std::string_view view) {
+    const std::size_t mask = slots_.size() - 1;
+    const uint32_t key = static_cast<uint32_t>(id) + 1;
+    for (std::size_t i = id & mask;; i = (i + 1) & mask) {
+      Slot& slot = slots_[i];
+      if (slot.key == key) {
+        slot.view = view;
+        return;
+      }
+      if (slot.key == 0) {
+        slot = Slot{view, key};
+        ++size_;
+        return;
+      }
+    }
+  }
 
-  std::vector<std::string_view> table_;
-  std::unique_ptr<char[]> arena_buffer_;
-  std::size_t arena_size_ = 0;
-#if FEMTOLOG_IS_DEBUG
-  std::size_t arena_capacity_ = kInitialArenaSize;
-#endif
+  void rehash(std::size_t new_size) {
+    std::vector<Slot> old = std::move(slots_);
+    slots_.assign(new_size, Slot{});
+    size_ = 0;
+    for (const Slot& slot : old) {
+      if (slot.key != 0) {
+        insert(static_cast<StringId>(slot.key - 1), slot.view);
+      }
+    }
+  }
+
+  std::string_view copy_to_arena(std::string_view view) {
+    if (view.empty()) {
+      return {};
+    }
+    if (arena_chunks_.empty() ||
+        arena_chunk_used_ + view.size() > arena_chunk_capacity_) {
+      arena_chunk_capacity_ = std::max(kArenaChunkSize, view.size());
+      // Intentionally uninitialized; only the copied bytes are touched.
+      arena_chunks_.emplace_back(new char[arena_chunk_capacity_]);
+      arena_chunk_used_ = 0;
+      arena_bytes_ += arena_chunk_capacity_;
+    }
+    char* dest = arena_chunks_.back().get() + arena_chunk_used_;
+    std::memcpy(dest, view.data(), view.size());
+    arena_chunk_used_ += view.size();
+    return std::string_view(dest, view.size());
+  }
+
+  mutable std::mutex mutex_;
+  std::vector<Slot> slots_;
+  std::size_t size_ = 0;
+  std::size_t collision_count_ = 0;
+
+  std::vector<std::unique_ptr<char[]>> arena_chunks_;
+  std::size_t arena_chunk_used_ = 0;
+  std::size_t arena_chunk_capacity_ = 0;
+  std::size_t arena_bytes_ = 0;
+};
+
+// Registers its string from its constructor. One instance exists per format
+// string, as a variable template specialization, and is dynamically
+// initialized before main() like any other namespace-scope object.
+template <FixedString fixed_str>
+struct StaticStringRegistration {
+  StaticStringRegistration() {
+    // The backend does not need the text to format the entry, so a collision
+    // only loses the text of the later string. It is counted in
+    // StringRegistry::collision_count() rather than treated as an error,
+    // since it runs before main() and any program may run into one.
+    StringRegistry::instance().template register_string<fixed_str>();
+  }
 };
 
+template <FixedString fixed_str>
+inline StaticStringRegistration<fixed_str> static_string_registration;
+
+// static
+template <FixedString fixed_str>
+inline void StringRegistry::register_static() {
+  // Odr-using the specialization is what instantiates it.
+  static_cast<void>(&static_string_registration<fixed_str>);
+}
+
 }  // namespace femtolog
 
 #endif  // INCLUDE_FEMTOLOG_BASE_STRING_REGISTRY_H_
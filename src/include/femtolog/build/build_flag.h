@@ -283,6 +283,32 @@
 
 #endif
 
+// ================
+// Active Log Level
+// ================
+
+// Numeric values of femtolog::LogLevel, usable in preprocessor conditions.
+#define FEMTOLOG_LEVEL_RAW 0
+#define FEMTOLOG_LEVEL_FATAL 1
+#define FEMTOLOG_LEVEL_ERROR 2
+#define FEMTOLOG_LEVEL_WARN 3
+#define FEMTOLOG_LEVEL_INFO 4
+#define FEMTOLOG_LEVEL_DEBUG 5
+#define FEMTOLOG_LEVEL_TRACE 6
+
+// Least severe level compiled into the binary. Calls to less severe levels
+// compile to nothing. Set through the FEMTOLOG_ACTIVE_LEVEL CMake option.
+#ifndef FEMTOLOG_ACTIVE_LEVEL
+#define FEMTOLOG_ACTIVE_LEVEL FEMTOLOG_LEVEL_TRACE
+
+#endif
+
+#if FEMTOLOG_ACTIVE_LEVEL < FEMTOLOG_LEVEL_RAW || \
+    FEMTOLOG_ACTIVE_LEVEL > FEMTOLOG_LEVEL_TRACE
+#error "FEMTOLOG_ACTIVE_LEVEL is out of range."
+
+#endif
+
 // ==========================
 // Compiler Version Detection
 // ==========================
@@ -409,4 +435,21 @@
 
 #endif
 
+// io_uring is used where the Linux headers declare it, unless turned off with
+// the FEMTOLOG_ENABLE_IO_URING CMake option. Whether they declare the
+// operations it needs is checked by femtolog/sinks/io_uring_file_sink.h.
+#ifndef FEMTOLOG_ENABLE_IO_URING
+#define FEMTOLOG_ENABLE_IO_URING 1
+
+#endif
+
+#if FEMTOLOG_IS_LINUX && FEMTOLOG_ENABLE_IO_URING && \
+    __has_include(<linux/io_uring.h>)
+#define FEMTOLOG_HAS_IO_URING_HEADER 1
+
+#else
+#define FEMTOLOG_HAS_IO_URING_HEADER 0
+
+#endif
+
 #endif  // INCLUDE_FEMTOLOG_BUILD_BUILD_FLAG_H_
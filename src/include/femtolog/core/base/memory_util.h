@@ -44,10 +44,41 @@ inline void aligned_free_wrapper(void* ptr) {
 #endif
 }
 
+// Hints the CPU to pull the cache line at `ptr` in ahead of a read.
+inline void prefetch_for_read(const void* ptr) noexcept {
+#if FEMTOLOG_COMPILER_MSVC
+  PreFetchCacheLine(PF_TEMPORAL_LEVEL_1, ptr);
+#else
+  __builtin_prefetch(ptr, 0, 3);
+#endif
+}
+
 struct AlignedDeleter {
   inline void operator()(void* ptr) const { aligned_free_wrapper(ptr); }
 };
 
+// Maps `size` bytes twice, back to back, so that an access running past the
+// end continues at the start. `size` must be a multiple of
+// mirrored_alloc_granularity(). Linux only; returns nullptr elsewhere or on
+// failure.
+FEMTOLOG_CORE_EXPORT void* mirrored_alloc(std::size_t size);
+FEMTOLOG_CORE_EXPORT void mirrored_free(void* ptr, std::size_t size);
+FEMTOLOG_CORE_EXPORT std::size_t mirrored_alloc_granularity();
+
+// Releases a ring buffer from aligned_alloc_wrapper(), or from
+// mirrored_alloc() when `mirrored_size` is set.
+struct RingBufferDeleter {
+  std::size_t mirrored_size = 0;
+
+  inline void operator()(void* ptr) const {
+    if (mirrored_size != 0) {
+      mirrored_free(ptr, mirrored_size);
+    } else {
+      aligned_free_wrapper(ptr);
+    }
+  }
+};
+
 #ifdef __GCC_DESTRUCTIVE_SIZE
 constexpr const std::size_t kCacheSize = __GCC_DESTRUCTIVE_SIZE;
 #else
@@ -0,0 +1,97 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#ifndef INCLUDE_FEMTOLOG_CORE_BASE_TSC_CLOCK_H_
+#define INCLUDE_FEMTOLOG_CORE_BASE_TSC_CLOCK_H_
+
+#include <cstdint>
+
+#include "femtolog/build/build_flag.h"
+#include "femtolog/core/base/core_export.h"
+
+#if FEMTOLOG_ARCH_X64 || FEMTOLOG_ARCH_X86
+#if FEMTOLOG_COMPILER_MSVC
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+#if FEMTOLOG_IS_LINUX
+#include <ctime>
+#else
+#include <chrono>
+#endif
+
+namespace femtolog::core {
+
+inline constexpr bool kHasTsc = FEMTOLOG_ARCH_X64 || FEMTOLOG_ARCH_X86;
+
+inline uint64_t coarse_monotonic_ns() noexcept {
+#if FEMTOLOG_IS_LINUX
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+#else
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+#endif
+}
+
+// Cheap timestamp for the frontend hot path. Returns the time stamp counter
+// where available, and the coarse monotonic clock in nanoseconds elsewhere.
+// Only meaningful when converted by TscClock::to_ns().
+inline uint64_t tsc_ticks() noexcept {
+#if FEMTOLOG_ARCH_X64 || FEMTOLOG_ARCH_X86
+  return __rdtsc();
+#else
+  return coarse_monotonic_ns();
+#endif
+}
+
+// Converts tsc_ticks() values to nanoseconds since the Unix epoch.
+//
+// The model is `wall = base_ns + (ticks - base_ticks) * ns_per_tick`. The base
+// is re-anchored against CLOCK_REALTIME once per resync interval, which keeps
+// wall-clock adjustments visible, and the rate is refined each time over the
+// whole interval since construction. Not thread-safe; each backend worker
+// owns its own instance.
+class FEMTOLOG_CORE_EXPORT TscClock {
+ public:
+  static constexpr uint64_t kDefaultResyncIntervalNs = 1000000000ull;
+
+  explicit TscClock(uint64_t resync_interval_ns = kDefaultResyncIntervalNs);
+
+  inline uint64_t to_ns(uint64_t ticks) noexcept {
+    int64_t delta = static_cast<int64_t>(ticks - base_ticks_);
+    if (delta > resync_ticks_) [[unlikely]] {
+      resync();
+      delta = static_cast<int64_t>(ticks - base_ticks_);
+    }
+    return base_ns_ + static_cast<int64_t>(static_cast<double>(delta) *
+                                           ns_per_tick_);
+  }
+
+  void resync() noexcept;
+
+  [[nodiscard]] double ns_per_tick() const noexcept { return ns_per_tick_; }
+
+ private:
+  uint64_t base_ticks_ = 0;
+  uint64_t base_ns_ = 0;
+  int64_t resync_ticks_ = 0;
+  double ns_per_tick_ = 1.0;
+
+  // Anchor used to estimate the tick rate.
+  uint64_t rate_ticks_ = 0;
+  uint64_t rate_monotonic_ns_ = 0;
+
+  uint64_t resync_interval_ns_;
+};
+
+}  // namespace femtolog::core
+
+#endif  // INCLUDE_FEMTOLOG_CORE_BASE_TSC_CLOCK_H_
@@ -5,11 +5,13 @@
 #ifndef INCLUDE_FEMTOLOG_FEMTOLOG_H_
 #define INCLUDE_FEMTOLOG_FEMTOLOG_H_
 
+#include "femtolog/base/codec.h"
 #include "femtolog/base/femtolog_export.h"
 #include "femtolog/base/format_util.h"
 #include "femtolog/base/log_entry.h"
 #include "femtolog/base/log_level.h"
 #include "femtolog/base/string_registry.h"
+#include "femtolog/build/build_flag.h"
 #include "femtolog/core/diagnostics/signal_handler.h"
 #include "femtolog/core/diagnostics/stack_trace.h"
 #include "femtolog/core/diagnostics/terminate_handler.h"
@@ -17,10 +19,16 @@
 #include "femtolog/options.h"
 #include "femtolog/sinks/file_sink.h"
 #include "femtolog/sinks/json_lines_sink.h"
+#include "femtolog/sinks/layout.h"
 #include "femtolog/sinks/null_sink.h"
+#include "femtolog/sinks/shared_file.h"
 #include "femtolog/sinks/sink_base.h"
 #include "femtolog/sinks/stdout_sink.h"
 
+#if FEMTOLOG_HAS_IO_URING_HEADER
+#include "femtolog/sinks/io_uring_file_sink.h"
+#endif
+
 namespace femtolog {
 
 inline void register_signal_handlers() {
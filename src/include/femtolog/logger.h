@@ -12,11 +12,14 @@
 
 #include "femtolog/base/femtolog_export.h"
 #include "femtolog/base/format_util.h"
+#include "femtolog/core/base/tsc_clock.h"
 #include "femtolog/core/diagnostics/signal_handler.h"
 #include "femtolog/core/diagnostics/stack_trace.h"
 #include "femtolog/core/diagnostics/terminate_handler.h"
 #include "femtolog/logging/impl/backend_worker.h"
 #include "femtolog/logging/impl/internal_logger.h"
+#include "femtolog/logging/impl/rate_limiter.h"
+#include "femtolog/logging/impl/shared_backend.h"
 #include "femtolog/options.h"
 #include "femtolog/sinks/sink_base.h"
 
@@ -51,83 +54,302 @@ class FEMTOLOG_EXPORT Logger {
 
   inline void clear_sinks() { internal_logger_->clear_sinks(); }
 
+  // Sinks of the process-wide shared backend, used by every logger
+  // initialized with BackendMode::kShared. Register them once, before the
+  // first shared-mode logger starts its worker.
+  template <
+      typename T,
+      typename = typename std::enable_if_t<std::is_base_of_v<SinkBase, T>>,
+      typename... Args>
+  inline static void register_shared_sink(Args&&... args) {
+    logging::SharedBackend::instance().register_sink(
+        std::make_unique<T>(std::forward<Args>(args)...));
+  }
+
+  inline static void clear_shared_sinks() {
+    logging::SharedBackend::instance().clear_sinks();
+  }
+
   inline void start_worker() { internal_logger_->start_worker(); }
 
   inline void stop_worker() { internal_logger_->stop_worker(); }
 
-  template <LogLevel level, FixedString fmt, typename... Args>
+  template <LogLevel level,
+            FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
   inline constexpr void log(Args&&... args) noexcept {
-    internal_logger_->log<level, fmt, false, Args...>(
-        std::forward<Args>(args)...);
+    if constexpr (is_level_active(level)) {
+      internal_logger_->log_with_policy<level, fmt, false, policy, Args...>(
+          std::forward<Args>(args)...);
+    }
   }
 
-  template <FixedString fmt, typename... Args>
+  template <FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
   inline constexpr void raw(Args&&... args) noexcept {
-    log<LogLevel::kRaw, fmt>(std::forward<Args>(args)...);
+    log<LogLevel::kRaw, fmt, policy>(std::forward<Args>(args)...);
   }
-  template <FixedString fmt, typename... Args>
+  template <FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
   inline constexpr void fatal(Args&&... args) noexcept {
-    log<LogLevel::kFatal, fmt>(std::forward<Args>(args)...);
+    log<LogLevel::kFatal, fmt, policy>(std::forward<Args>(args)...);
   }
-  template <FixedString fmt, typename... Args>
+  template <FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
   inline constexpr void error(Args&&... args) noexcept {
-    log<LogLevel::kError, fmt>(std::forward<Args>(args)...);
+    log<LogLevel::kError, fmt, policy>(std::forward<Args>(args)...);
   }
-  template <FixedString fmt, typename... Args>
+  template <FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
   inline constexpr void warn(Args&&... args) noexcept {
-    log<LogLevel::kWarn, fmt>(std::forward<Args>(args)...);
+    log<LogLevel::kWarn, fmt, policy>(std::forward<Args>(args)...);
   }
-  template <FixedString fmt, typename... Args>
+  template <FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
   inline constexpr void info(Args&&... args) noexcept {
-    log<LogLevel::kInfo, fmt>(std::forward<Args>(args)...);
+    log<LogLevel::kInfo, fmt, policy>(std::forward<Args>(args)...);
   }
-  template <FixedString fmt, typename... Args>
+  template <FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
   inline constexpr void debug(Args&&... args) noexcept {
-    log<LogLevel::kDebug, fmt>(std::forward<Args>(args)...);
+    log<LogLevel::kDebug, fmt, policy>(std::forward<Args>(args)...);
   }
-  template <FixedString fmt, typename... Args>
+  template <FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
   inline constexpr void trace(Args&&... args) noexcept {
-    log<LogLevel::kTrace, fmt>(std::forward<Args>(args)...);
+    log<LogLevel::kTrace, fmt, policy>(std::forward<Args>(args)...);
   }
 
-  template <LogLevel level, FixedString fmt, typename... Args>
+  template <LogLevel level,
+            FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
   inline constexpr void log_ref(Args&&... args) noexcept {
     static_assert(((std::is_lvalue_reference_v<Args> ||
                     std::is_trivially_copyable_v<Args>) &&
                    ...),
                   "Args must all be l-value references.");
-    internal_logger_->log<level, fmt, true, Args...>(
-        std::forward<Args>(args)...);
+    if constexpr (is_level_active(level)) {
+      internal_logger_->log_with_policy<level, fmt, true, policy, Args...>(
+          std::forward<Args>(args)...);
+    }
   }
 
-  template <FixedString fmt, typename... Args>
+  template <FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
   inline constexpr void raw_ref(Args&&... args) noexcept {
     static_assert(sizeof...(Args) > 0, "use `raw` instead of `raw_ref`");
-    log_ref<LogLevel::kRaw, fmt>(std::forward<Args>(args)...);
+    log_ref<LogLevel::kRaw, fmt, policy>(std::forward<Args>(args)...);
   }
-  template <FixedString fmt, typename... Args>
+  template <FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
   inline constexpr void fatal_ref(Args&&... args) noexcept {
-    log_ref<LogLevel::kFatal, fmt>(std::forward<Args>(args)...);
+    log_ref<LogLevel::kFatal, fmt, policy>(std::forward<Args>(args)...);
   }
-  template <FixedString fmt, typename... Args>
+  template <FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
   inline constexpr void error_ref(Args&&... args) noexcept {
-    log_ref<LogLevel::kError, fmt>(std::forward<Args>(args)...);
+    log_ref<LogLevel::kError, fmt, policy>(std::forward<Args>(args)...);
   }
-  template <FixedString fmt, typename... Args>
+  template <FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
   inline constexpr void warn_ref(Args&&... args) noexcept {
-    log_ref<LogLevel::kWarn, fmt>(std::forward<Args>(args)...);
+    log_ref<LogLevel::kWarn, fmt, policy>(std::forward<Args>(args)...);
   }
-  template <FixedString fmt, typename... Args>
+  template <FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
   inline constexpr void info_ref(Args&&... args) noexcept {
-    log_ref<LogLevel::kInfo, fmt>(std::forward<Args>(args)...);
+    log_ref<LogLevel::kInfo, fmt, policy>(std::forward<Args>(args)...);
   }
-  template <FixedString fmt, typename... Args>
+  template <FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
   inline constexpr void debug_ref(Args&&... args) noexcept {
-    log_ref<LogLevel::kDebug, fmt>(std::forward<Args>(args)...);
+    log_ref<LogLevel::kDebug, fmt, policy>(std::forward<Args>(args)...);
   }
-  template <FixedString fmt, typename... Args>
+  template <FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
   inline constexpr void trace_ref(Args&&... args) noexcept {
-    log_ref<LogLevel::kTrace, fmt>(std::forward<Args>(args)...);
+    log_ref<LogLevel::kTrace, fmt, policy>(std::forward<Args>(args)...);
+  }
+
+  // Rate-limited logging. The limiter state is kept per call site, i.e. per
+  // format string and level, and per thread.
+  //  - `*_every_n` logs the first call and then every n-th one.
+  //  - `*_at_most` logs up to `per_sec` calls per second. The backend logs
+  //    how many calls were suppressed once a second, and on flush() and
+  //    stop_worker().
+  //  - `*_sampled` logs each call with probability `p`.
+  template <LogLevel level,
+            std::size_t n,
+            FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
+  inline void log_every_n(Args&&... args) noexcept {
+    if constexpr (is_level_active(level)) {
+      auto& limiter =
+          logging::call_site_limiter<level, fmt, logging::EveryNLimiter<n>>;
+      if (limiter.admit()) {
+        log<level, fmt, policy>(std::forward<Args>(args)...);
+      }
+    }
+  }
+
+  template <LogLevel level,
+            std::size_t per_sec,
+            FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
+  inline void log_at_most(Args&&... args) noexcept {
+    if constexpr (is_level_active(level)) {
+      auto& limiter = logging::
+          call_site_limiter<level, fmt, logging::AtMostLimiter<per_sec>>;
+      if (limiter.admit(core::coarse_monotonic_ns())) {
+        log<level, fmt, policy>(std::forward<Args>(args)...);
+      } else {
+        internal_logger_->count_suppressed<level, fmt>(&limiter);
+      }
+    }
+  }
+
+  template <LogLevel level,
+            double p,
+            FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
+  inline void log_sampled(Args&&... args) noexcept {
+    if constexpr (is_level_active(level)) {
+      auto& limiter =
+          logging::call_site_limiter<level, fmt, logging::SampledLimiter<p>>;
+      if (limiter.admit()) {
+        log<level, fmt, policy>(std::forward<Args>(args)...);
+      }
+    }
+  }
+
+  template <std::size_t n,
+            FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
+  inline void error_every_n(Args&&... args) noexcept {
+    log_every_n<LogLevel::kError, n, fmt, policy>(std::forward<Args>(args)...);
+  }
+  template <std::size_t per_sec,
+            FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
+  inline void error_at_most(Args&&... args) noexcept {
+    log_at_most<LogLevel::kError, per_sec, fmt, policy>(
+        std::forward<Args>(args)...);
+  }
+  template <double p,
+            FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
+  inline void error_sampled(Args&&... args) noexcept {
+    log_sampled<LogLevel::kError, p, fmt, policy>(std::forward<Args>(args)...);
+  }
+  template <std::size_t n,
+            FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
+  inline void warn_every_n(Args&&... args) noexcept {
+    log_every_n<LogLevel::kWarn, n, fmt, policy>(std::forward<Args>(args)...);
+  }
+  template <std::size_t per_sec,
+            FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
+  inline void warn_at_most(Args&&... args) noexcept {
+    log_at_most<LogLevel::kWarn, per_sec, fmt, policy>(
+        std::forward<Args>(args)...);
+  }
+  template <double p,
+            FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
+  inline void warn_sampled(Args&&... args) noexcept {
+    log_sampled<LogLevel::kWarn, p, fmt, policy>(std::forward<Args>(args)...);
+  }
+  template <std::size_t n,
+            FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
+  inline void info_every_n(Args&&... args) noexcept {
+    log_every_n<LogLevel::kInfo, n, fmt, policy>(std::forward<Args>(args)...);
+  }
+  template <std::size_t per_sec,
+            FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
+  inline void info_at_most(Args&&... args) noexcept {
+    log_at_most<LogLevel::kInfo, per_sec, fmt, policy>(
+        std::forward<Args>(args)...);
+  }
+  template <double p,
+            FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
+  inline void info_sampled(Args&&... args) noexcept {
+    log_sampled<LogLevel::kInfo, p, fmt, policy>(std::forward<Args>(args)...);
+  }
+  template <std::size_t n,
+            FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
+  inline void debug_every_n(Args&&... args) noexcept {
+    log_every_n<LogLevel::kDebug, n, fmt, policy>(std::forward<Args>(args)...);
+  }
+  template <std::size_t per_sec,
+            FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
+  inline void debug_at_most(Args&&... args) noexcept {
+    log_at_most<LogLevel::kDebug, per_sec, fmt, policy>(
+        std::forward<Args>(args)...);
+  }
+  template <double p,
+            FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
+  inline void debug_sampled(Args&&... args) noexcept {
+    log_sampled<LogLevel::kDebug, p, fmt, policy>(std::forward<Args>(args)...);
+  }
+  template <std::size_t n,
+            FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
+  inline void trace_every_n(Args&&... args) noexcept {
+    log_every_n<LogLevel::kTrace, n, fmt, policy>(std::forward<Args>(args)...);
+  }
+  template <std::size_t per_sec,
+            FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
+  inline void trace_at_most(Args&&... args) noexcept {
+    log_at_most<LogLevel::kTrace, per_sec, fmt, policy>(
+        std::forward<Args>(args)...);
+  }
+  template <double p,
+            FixedString fmt,
+            OverflowPolicy policy = OverflowPolicy::kDefault,
+            typename... Args>
+  inline void trace_sampled(Args&&... args) noexcept {
+    log_sampled<LogLevel::kTrace, p, fmt, policy>(std::forward<Args>(args)...);
   }
 
   inline void flush() noexcept { internal_logger_->flush(); }
@@ -177,4 +399,29 @@ class FEMTOLOG_EXPORT Logger {
 
 }  // namespace femtolog
 
+// Calls to levels below FEMTOLOG_ACTIVE_LEVEL compile to nothing, but their
+// arguments are still evaluated unless the optimizer proves them free of side
+// effects. These macros skip the arguments as well:
+//
+//   FEMTOLOG_DEBUG(logger, "state: {}\n", dump_state());
+#define FEMTOLOG_LOG(logger, level, fmt, ...)           \
+  do {                                                  \
+    if constexpr (::femtolog::is_level_active(level)) { \
+      (logger).template log<level, fmt>(__VA_ARGS__);   \
+    }                                                   \
+  } while (0)
+
+#define FEMTOLOG_FATAL(logger, fmt, ...) \
+  FEMTOLOG_LOG(logger, ::femtolog::LogLevel::kFatal, fmt, __VA_ARGS__)
+#define FEMTOLOG_ERROR(logger, fmt, ...) \
+  FEMTOLOG_LOG(logger, ::femtolog::LogLevel::kError, fmt, __VA_ARGS__)
+#define FEMTOLOG_WARN(logger, fmt, ...) \
+  FEMTOLOG_LOG(logger, ::femtolog::LogLevel::kWarn, fmt, __VA_ARGS__)
+#define FEMTOLOG_INFO(logger, fmt, ...) \
+  FEMTOLOG_LOG(logger, ::femtolog::LogLevel::kInfo, fmt, __VA_ARGS__)
+#define FEMTOLOG_DEBUG(logger, fmt, ...) \
+  FEMTOLOG_LOG(logger, ::femtolog::LogLevel::kDebug, fmt, __VA_ARGS__)
+#define FEMTOLOG_TRACE(logger, fmt, ...) \
+  FEMTOLOG_LOG(logger, ::femtolog::LogLevel::kTrace, fmt, __VA_ARGS__)
+
 #endif  // INCLUDE_FEMTOLOG_LOGGER_H_
@@ -6,10 +6,10 @@
 #define INCLUDE_FEMTOLOG_LOGGING_IMPL_ARGS_DESERIALIZER_H_
 
 #include <cstring>
-#include <string>
-#include <tuple>
+#include <string_view>
 #include <utility>
 
+#include "femtolog/base/format_util.h"
 #include "femtolog/base/serialize_util.h"
 #include "femtolog/base/string_registry.h"
 #include "fmt/args.h"
@@ -23,91 +23,76 @@ class DeserializeDispatcher {
     return &deserialize_and_format;
   }
 
+  // Formats with `fmt` compiled for the argument types, ignoring the
+  // FormatFunction it is passed.
+  template <FixedString fmt>
+  static constexpr DeserializeAndFormatFunction compiled_function() {
+    return &deserialize_and_format_compiled<fmt>;
+  }
+
  private:
+  // Reads the arguments one after another, each from where the previous one
+  // ended.
+  struct Reader {
+    const char* base;
+    std::size_t offset = 0;
+
+    template <typename T>
+    inline deserialized_arg_type_t<ref_mode, T> next() {
+      auto [arg, next_offset] = read_arg<T>(base, offset);
+      offset = next_offset;
+      return arg;
+    }
+  };
+
+  // Formats the arguments it is constructed from. Constructing it from a
+  // braced list of Reader::next() calls decodes any number of arguments in
+  // order, since the initializers of a braced list are evaluated left to
+  // right, and keeps them alive while they are formatted.
+  struct Formatter {
+    std::size_t size;
+
+    inline Formatter(fmt::memory_buffer* format_buffer,
+                     FormatFunction fmt_function,
+                     const deserialized_arg_type_t<ref_mode, Args>&... args)
+        : size(fmt_function(format_buffer, fmt::make_format_args(args...))) {}
+  };
+
+  // Appends to the buffer rather than going through format_to_n(), whose
+  // truncating iterator is slower than the parsing it saves.
+  template <FixedString fmt>
+  struct CompiledFormatter {
+    std::size_t size;
+
+    inline CompiledFormatter(
+        fmt::memory_buffer* format_buffer,
+        const deserialized_arg_type_t<ref_mode, Args>&... args) {
+      const std::size_t begin = format_buffer->size();
+      fmt::format_to(fmt::appender(*format_buffer), CompiledFormat<fmt>(),
+                     args...);
+      size = format_buffer->size() - begin;
+    }
+  };
+
   inline static std::size_t deserialize_and_format(
       fmt::memory_buffer* format_buffer,
       FormatFunction fmt_function,
       const char* data) {
-    return deserialize_and_format_impl(format_buffer, fmt_function, data,
-                                       std::index_sequence_for<Args...>{});
+    [[maybe_unused]] Reader reader{data};
+    return Formatter{format_buffer, fmt_function,
+                     reader.template next<Args>()...}
+        .size;
   }
 
-  template <std::size_t... I>
-  inline static std::size_t deserialize_and_format_impl(
+  template <FixedString fmt>
+  inline static std::size_t deserialize_and_format_compiled(
       fmt::memory_buffer* format_buffer,
-      FormatFunction fmt_function,
-      const char* data,
-      std::index_sequence<I...>) {
-    if constexpr (sizeof...(Args) == 1) {
-      using FirstArg = std::tuple_element_t<0, std::tuple<Args...>>;
-      using Decayed = std::decay_t<FirstArg>;
-
-      if constexpr (std::is_trivially_copyable_v<Decayed> &&
-                    !is_string_like_v<Decayed>) {
-        if constexpr (sizeof(Decayed) <= 8) {
-          Decayed value;
-          std::memcpy(&value, data, sizeof(value));
-          return fmt_function(format_buffer, fmt::make_format_args(value));
-        }
-      }
-    }
-
-    return format_directly(format_buffer, fmt_function, data,
-                           std::index_sequence<I...>{});
-  }
-
-  template <std::size_t... I>
-  inline static std::size_t format_directly(fmt::memory_buffer* format_buffer,
-                                            FormatFunction fmt_function,
-                                            const char* data,
-                                            std::index_sequence<I...>) {
-    if constexpr (sizeof...(Args) == 1) {
-      const auto [arg0, o0] =
-          read_arg<std::tuple_element_t<0, std::tuple<Args...>>>(data, 0);
-      return fmt_function(format_buffer, fmt::make_format_args(arg0));
-    } else if constexpr (sizeof...(Args) == 2) {
-      const auto [arg0, o0] =
-          read_arg<std::tuple_element_t<0, std::tuple<Args...>>>(data, 0);
-      const auto [arg1, o1] =
-          read_arg<std::tuple_element_t<1, std::tuple<Args...>>>(data, o0);
-      return fmt_function(format_buffer, fmt::make_format_args(arg0, arg1));
-    } else if constexpr (sizeof...(Args) == 3) {
-      const auto [arg0, o0] =
-          read_arg<std::tuple_element_t<0, std::tuple<Args...>>>(data, 0);
-      const auto [arg1, o1] =
-          read_arg<std::tuple_element_t<1, std::tuple<Args...>>>(data, o0);
-      const auto [arg2, o2] =
-          read_arg<std::tuple_element_t<2, std::tuple<Args...>>>(data, o1);
-      return fmt_function(format_buffer,
-                          fmt::make_format_args(arg0, arg1, arg2));
-    } else if constexpr (sizeof...(Args) == 4) {
-      const auto [arg0, o0] =
-          read_arg<std::tuple_element_t<0, std::tuple<Args...>>>(data, 0);
-      const auto [arg1, o1] =
-          read_arg<std::tuple_element_t<1, std::tuple<Args...>>>(data, o0);
-      const auto [arg2, o2] =
-          read_arg<std::tuple_element_t<2, std::tuple<Args...>>>(data, o1);
-      const auto [arg3, o3] =
-          read_arg<std::tuple_element_t<3, std::tuple<Args...>>>(data, o2);
-      return fmt_function(format_buffer,
-                          fmt::make_format_args(arg0, arg1, arg2, arg3));
-    } else {
-      std::size_t offset = 0;
-      const auto args = std::make_tuple([&]<typename T>(T) {
-        auto [arg, next_offset] = read_arg<T>(data, offset);
-        offset = next_offset;
-        return arg;
-      }(std::tuple_element_t<I, std::tuple<Args...>>{})...);
-
-      return std::apply(
-          [&](auto&&... unpacked) {
-            return fmt_function(
-                format_buffer,
-                fmt::make_format_args(
-                    std::forward<decltype(unpacked)>(unpacked)...));
-          },
-          args);
-    }
+      FormatFunction,
+      const char* data) {
+    [[maybe_unused]] Reader reader{data};
+    return CompiledFormatter<fmt>{format_buffer,
+                                  reader.template next<Args>()...}
+        .size;
   }
 
   template <typename T>
@@ -116,7 +101,18 @@ class DeserializeDispatcher {
     using Decayed = std::decay_t<T>;
     const char* ptr = base + offset;
 
-    if constexpr (is_string_like_v<Decayed>) {
+    if constexpr (is_static_string_v<Decayed>) {
+      uintptr_t raw_ptr;
+      std::memcpy(&raw_ptr, ptr, sizeof(raw_ptr));
+      ptr += sizeof(raw_ptr);
+
+      uint64_t str_len = 0;
+      const char* end = read_varint(ptr, ptr + kMaxVarintSize, &str_len);
+
+      const char* cptr = std::bit_cast<const char*>(raw_ptr);
+      std::string_view sv(cptr, str_len);
+      return {sv, static_cast<std::size_t>(end - base)};
+    } else if constexpr (is_string_like_v<Decayed>) {
       if constexpr (ref_mode) {
         uintptr_t raw_ptr;
         std::memcpy(&raw_ptr, ptr, sizeof(raw_ptr));
@@ -130,16 +126,39 @@ class DeserializeDispatcher {
         std::string_view sv(cptr, str_len);
         return {sv, offset + sizeof(raw_ptr) + sizeof(str_len)};
       } else {
+        // A view into the payload, which outlives the formatting.
         std::size_t str_len;
         std::memcpy(&str_len, ptr, sizeof(str_len));
         ptr += sizeof(str_len);
 
-        std::string str;
-        if (str_len > 0) {
-          str.resize(str_len);
-          std::memcpy(str.data(), ptr, str_len);
-        }
-        return {str, offset + sizeof(str_len) + str_len};
+        return {std::string_view(ptr, str_len),
+                offset + sizeof(str_len) + str_len};
+      }
+    } else if constexpr (is_codec_encoded_v<Decayed>) {
+      uint32_t encoded_size;
+      std::memcpy(&encoded_size, ptr, sizeof(encoded_size));
+      ptr += sizeof(encoded_size);
+      return {codec<Decayed>::decode(ptr, encoded_size),
+              offset + sizeof(encoded_size) + encoded_size};
+    } else if constexpr (is_trivial_range_v<Decayed>) {
+      using Element = range_element_t<Decayed>;
+      if constexpr (ref_mode) {
+        uintptr_t raw_ptr;
+        std::memcpy(&raw_ptr, ptr, sizeof(raw_ptr));
+        ptr += sizeof(raw_ptr);
+
+        std::size_t count;
+        std::memcpy(&count, ptr, sizeof(count));
+
+        const char* elements = std::bit_cast<const char*>(raw_ptr);
+        return {PackedSpan<Element>(elements, count),
+                offset + sizeof(raw_ptr) + sizeof(count)};
+      } else {
+        uint64_t count = 0;
+        const char* elements = read_varint(ptr, ptr + kMaxVarintSize, &count);
+        const std::size_t size = count * sizeof(Element);
+        return {PackedSpan<Element>(elements, count),
+                static_cast<std::size_t>(elements - base) + size};
       }
     } else if constexpr (std::is_trivially_copyable_v<Decayed>) {
       Decayed value;
@@ -10,6 +10,7 @@
 #include <cstring>
 #include <memory>
 #include <new>
+#include <ranges>
 #include <string>
 #include <string_view>
 
@@ -23,32 +24,45 @@
 
 namespace femtolog::logging {
 
-template <bool ref_mode, typename... Args>
-consteval std::size_t calculate_min_serialized_size() {
-  std::size_t total = sizeof(SerializedArgsHeader);
-  auto add_arg_size = []<typename T>() constexpr -> std::size_t {
-    using Decayed = std::decay_t<T>;
-    if constexpr (is_string_like_v<Decayed>) {
-      if constexpr (ref_mode) {
-        return sizeof(uintptr_t) + sizeof(std::size_t);
-      } else {
-        // dynamic; add lazily
-        return 0;
-      }
-    } else if constexpr (std::is_trivially_copyable_v<Decayed>) {
-      return sizeof(Decayed);
-    } else if constexpr (ref_mode) {
-      return sizeof(uintptr_t);
+template <bool ref_mode, typename T>
+consteval std::size_t min_serialized_arg_size() {
+  using Decayed = std::decay_t<T>;
+  if constexpr (is_static_string_v<T>) {
+    // pointer; the length varint is added lazily
+    return sizeof(uintptr_t);
+  } else if constexpr (is_string_like_v<Decayed>) {
+    if constexpr (ref_mode) {
+      return sizeof(uintptr_t) + sizeof(std::size_t);
     } else {
-      static_assert(sizeof(Decayed) == 0,
-                    "attempted to write unsupported type\n:"
-                    "currently only supporting string like types and trivially "
-                    "copyable types");
+      // dynamic; add lazily
+      return 0;
     }
-  };
+  } else if constexpr (is_codec_encoded_v<Decayed>) {
+    // length; the encoded bytes are added lazily
+    return sizeof(uint32_t);
+  } else if constexpr (is_trivial_range_v<Decayed>) {
+    if constexpr (ref_mode) {
+      return sizeof(uintptr_t) + sizeof(std::size_t);
+    } else {
+      // dynamic; add lazily
+      return 0;
+    }
+  } else if constexpr (std::is_trivially_copyable_v<Decayed>) {
+    return sizeof(Decayed);
+  } else if constexpr (ref_mode) {
+    return sizeof(uintptr_t);
+  } else {
+    static_assert(sizeof(Decayed) == 0,
+                  "attempted to write unsupported type\n:"
+                  "currently only supporting string like types, trivially "
+                  "copyable types and ranges of them, and types with a "
+                  "femtolog::codec");
+  }
+}
 
-  ((total += add_arg_size.template operator()<Args>()), ...);
-  return total;
+template <bool ref_mode, typename... Args>
+consteval std::size_t calculate_min_serialized_size() {
+  return (std::size_t{0} + ... + min_serialized_arg_size<ref_mode, Args>());
 }
 
 template <typename T>
@@ -56,7 +70,9 @@ inline std::string_view to_string_view(const T& value) {
   using Decayed = std::decay_t<T>;
   static_assert(is_string_like_v<Decayed>, "cannot convert to string view");
   std::string_view view;
-  if constexpr (is_char_array_v<Decayed>) {
+  if constexpr (std::is_same_v<Decayed, StaticString>) {
+    view = value.view();
+  } else if constexpr (is_char_array_v<Decayed>) {
     if (value == nullptr) [[unlikely]] {
       view = "(nullptr)";
     } else {
@@ -68,21 +84,42 @@ inline std::string_view to_string_view(const T& value) {
   return view;
 }
 
-template <typename T>
-inline void add_dynamic_string_length(std::size_t* dest, const T& value) {
+// Adds the bytes of `value` that calculate_min_serialized_size() leaves out.
+// `T` is the undecayed argument type, as for write_arg().
+template <bool ref_mode, typename T>
+inline void add_dynamic_size(std::size_t* dest, const T& value) {
   using Decayed = std::decay_t<T>;
-  if constexpr (is_string_like_v<Decayed>) {
-    const std::string_view view = to_string_view(value);
-    const std::size_t str_len = view.size();
-    *dest += sizeof(str_len) + str_len;
+  if constexpr (is_static_string_v<T>) {
+    *dest += varint_size(to_string_view(value).size());
+  } else if constexpr (is_string_like_v<Decayed>) {
+    if constexpr (!ref_mode) {
+      const std::string_view view = to_string_view(value);
+      const std::size_t str_len = view.size();
+      *dest += sizeof(str_len) + str_len;
+    }
+  } else if constexpr (is_codec_encoded_v<Decayed>) {
+    *dest += codec<Decayed>::size(value);
+  } else if constexpr (is_trivial_range_v<Decayed>) {
+    if constexpr (!ref_mode) {
+      const std::size_t count = std::ranges::size(value);
+      *dest += varint_size(count) + count * sizeof(range_element_t<T>);
+    }
   }
 }
 
+// `T` is the undecayed argument type, since decaying loses whether a char
+// array is a string literal.
 template <bool ref_mode, typename T>
 inline void write_arg(char*& pos, const T& value) {
   using Decayed = std::decay_t<T>;
 
-  if constexpr (is_string_like_v<Decayed>) {
+  if constexpr (is_static_string_v<T>) {
+    // Static strings outlive the entry in either mode.
+    const std::string_view view = to_string_view(value);
+    const uintptr_t raw = reinterpret_cast<uintptr_t>(view.data());
+    std::memcpy(pos, &raw, sizeof(raw));
+    pos = write_varint(pos + sizeof(raw), view.size());
+  } else if constexpr (is_string_like_v<Decayed>) {
     if constexpr (ref_mode) {
       const std::string_view view = to_string_view(value);
       const char* cptr = view.data();
@@ -104,6 +141,32 @@ inline void write_arg(char*& pos, const T& value) {
         pos += str_len;
       }
     }
+  } else if constexpr (is_codec_encoded_v<Decayed>) {
+    // Encoded in both modes, since the decoded value may outlive `value`.
+    char* begin = pos + sizeof(uint32_t);
+    char* end = codec<Decayed>::encode(begin, value);
+    FEMTOLOG_DCHECK_LE(static_cast<std::size_t>(end - begin),
+                       codec<Decayed>::size(value));
+    const auto encoded_size = static_cast<uint32_t>(end - begin);
+    std::memcpy(pos, &encoded_size, sizeof(encoded_size));
+    pos = end;
+  } else if constexpr (is_trivial_range_v<Decayed>) {
+    const auto* elements = std::ranges::data(value);
+    const std::size_t count = std::ranges::size(value);
+    if constexpr (ref_mode) {
+      const uintptr_t raw = reinterpret_cast<uintptr_t>(elements);
+      std::memcpy(pos, &raw, sizeof(raw));
+      pos += sizeof(raw);
+      std::memcpy(pos, &count, sizeof(count));
+      pos += sizeof(count);
+    } else {
+      pos = write_varint(pos, count);
+      const std::size_t size = count * sizeof(range_element_t<T>);
+      if (size > 0) [[likely]] {
+        std::memcpy(pos, elements, size);
+        pos += size;
+      }
+    }
   } else if constexpr (std::is_trivially_copyable_v<Decayed>) {
     std::memcpy(pos, &value, sizeof(Decayed));
     pos += sizeof(Decayed);
@@ -117,6 +180,76 @@ inline void write_arg(char*& pos, const T& value) {
   }
 }
 
+// Number of bytes serialize_args_to() writes for `args`. Both take the
+// argument types of the log call, by forwarding reference.
+template <bool ref_mode, typename... Args>
+[[gnu::always_inline]] inline std::size_t serialized_args_size(
+    Args&&... args) {
+  constexpr std::size_t kMinSize =
+      calculate_min_serialized_size<ref_mode, Args...>();
+  std::size_t dynamic_size = 0;
+  (add_dynamic_size<ref_mode, Args>(&dynamic_size, args), ...);
+  return kMinSize + dynamic_size;
+}
+
+// Writes `args` to `dst`, which must have room for serialized_args_size()
+// bytes. Used to serialize straight into queue memory, where the entry's call
+// site stands in for the functions that format them. The bytes decode as
+// serialized_arg_t<Args>... .
+template <bool ref_mode, typename... Args>
+[[gnu::hot, gnu::always_inline]] inline void serialize_args_to(
+    char* dst,
+    Args&&... args) {
+  [[maybe_unused]] char* pos = dst;
+  (write_arg<ref_mode, Args>(pos, args), ...);
+}
+
+// Like serialize_args_to(), but leaves the last `excess` bytes of the longest
+// dynamic string out, so that `excess` fewer bytes are written. Returns false
+// without writing anything if no dynamic string is that long.
+template <typename... Args>
+inline bool serialize_truncated_args_to(char* dst,
+                                        std::size_t excess,
+                                        Args&&... args) {
+  std::size_t longest_index = 0;
+  std::size_t longest_size = 0;
+  std::size_t index = 0;
+  (
+      [&] {
+        if constexpr (is_dynamic_string_v<Args>) {
+          const std::size_t size = to_string_view(args).size();
+          if (size > longest_size) {
+            longest_index = index;
+            longest_size = size;
+          }
+        }
+        index++;
+      }(),
+      ...);
+  if (longest_size < excess) {
+    return false;
+  }
+
+  char* pos = dst;
+  index = 0;
+  (
+      [&] {
+        if constexpr (is_dynamic_string_v<Args>) {
+          if (index == longest_index) {
+            const std::string_view view =
+                to_string_view(args).substr(0, longest_size - excess);
+            write_arg<false, std::string_view>(pos, view);
+            index++;
+            return;
+          }
+        }
+        write_arg<false, Args>(pos, args);
+        index++;
+      }(),
+      ...);
+  return true;
+}
+
 template <std::size_t kCapacity = 2048>
 class ArgsSerializer {
   static_assert(kCapacity >= sizeof(SerializedArgsHeader),
@@ -142,47 +275,30 @@ class ArgsSerializer {
   template <FixedString fmt, bool ref_mode, typename... Args>
   [[gnu::hot, gnu::always_inline]] inline constexpr SerializedArgs<kCapacity>&
   serialize(Args&&... args) {
-    constexpr std::size_t kTotalSizeExcludingDynStr =
-        calculate_min_serialized_size<ref_mode, Args...>();
-    static_assert(kCapacity >= kTotalSizeExcludingDynStr,
+    static_assert(kCapacity >= sizeof(SerializedArgsHeader) +
+                                   calculate_min_serialized_size<ref_mode,
+                                                                 Args...>(),
                   "Buffer too small for arguments");
 
-    // header
-    constexpr FormatFunction format_function_ptr =
-        FormatDispatcher<fmt>::function();
-    constexpr DeserializeAndFormatFunction deserialize_function_ptr =
-        DeserializeDispatcher<ref_mode, std::decay_t<Args>...>::function();
-    constexpr SerializedArgsHeader header(format_function_ptr,
-                                          deserialize_function_ptr);
-    if constexpr (ref_mode) {
-      char* pos = args_.data();
-      std::memcpy(pos, &header, sizeof(header));
-      pos += sizeof(header);
-
-      (write_arg<true>(pos, args), ...);
-
-      args_.resize(kTotalSizeExcludingDynStr);
-      return args_;
-    } else {
-      std::size_t dynamic_strings_length = 0;
-      (add_dynamic_string_length(&dynamic_strings_length, args), ...);
-
-      const std::size_t total_serialized_size =
-          kTotalSizeExcludingDynStr + dynamic_strings_length;
+    const std::size_t total_serialized_size =
+        sizeof(SerializedArgsHeader) +
+        serialized_args_size<ref_mode, Args...>(std::forward<Args>(args)...);
+    if constexpr (!ref_mode) {
       if (total_serialized_size >= kCapacity) {
         args_.resize(0);
         return args_;
-      } else {
-        char* pos = args_.data();
-        std::memcpy(pos, &header, sizeof(header));
-        pos += sizeof(header);
-
-        (write_arg<false>(pos, args), ...);
-
-        args_.resize(kTotalSizeExcludingDynStr + dynamic_strings_length);
-        return args_;
       }
     }
+
+    constexpr SerializedArgsHeader header(
+        FormatDispatcher<fmt>::function(),
+        DeserializeDispatcher<ref_mode, serialized_arg_t<Args>...>::
+            template compiled_function<fmt>());
+    std::memcpy(args_.data(), &header, sizeof(header));
+    serialize_args_to<ref_mode, Args...>(args_.data() + sizeof(header),
+                                         std::forward<Args>(args)...);
+    args_.resize(total_serialized_size);
+    return args_;
   }
 
  private:
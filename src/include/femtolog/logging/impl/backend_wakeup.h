@@ -0,0 +1,77 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#ifndef INCLUDE_FEMTOLOG_LOGGING_IMPL_BACKEND_WAKEUP_H_
+#define INCLUDE_FEMTOLOG_LOGGING_IMPL_BACKEND_WAKEUP_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "femtolog/build/build_flag.h"
+#include "femtolog/core/base/memory_util.h"
+#include "femtolog/logging/base/logging_export.h"
+
+#if !FEMTOLOG_IS_LINUX
+#include <condition_variable>
+#include <mutex>
+#endif
+
+namespace femtolog::logging {
+
+// Parking spot of an idle backend worker (BackendWaitStrategy::kEventDriven).
+//
+// The backend announces that it is about to park with prepare_park(), checks
+// its queues one last time, then sleeps in park() until woken. Producers call
+// notify() after publishing an entry, which costs one relaxed load unless the
+// backend is actually parked. Producers do not fence, so a notify() that races
+// with prepare_park() can be missed; park() therefore takes a timeout that
+// bounds the delay in that case. Waits on a futex on Linux.
+class FEMTOLOG_LOGGING_EXPORT BackendWakeup {
+ public:
+  BackendWakeup() = default;
+  ~BackendWakeup() = default;
+
+  BackendWakeup(const BackendWakeup&) = delete;
+  BackendWakeup& operator=(const BackendWakeup&) = delete;
+
+  // Producer side.
+  inline void notify() noexcept {
+    if (parked_.load(std::memory_order_relaxed)) [[unlikely]] {
+      wake();
+    }
+  }
+
+  // For control requests such as stop, flush or attach, issued after their
+  // own atomic store. Fenced, so the request and the flag check cannot pass
+  // each other.
+  inline void notify_fenced() noexcept {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    notify();
+  }
+
+  void wake() noexcept;
+
+  // Backend side. Returns the epoch to pass to park(). Everything the backend
+  // checks after this call and before park() is ordered after the flag store.
+  [[nodiscard]] uint32_t prepare_park() noexcept;
+  void cancel_park() noexcept;
+  void park(uint32_t epoch, std::chrono::microseconds timeout) noexcept;
+
+  [[nodiscard]] inline bool parked() const noexcept {
+    return parked_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  alignas(core::kCacheSize) std::atomic<uint32_t> parked_ = 0;
+  std::atomic<uint32_t> epoch_ = 0;
+#if !FEMTOLOG_IS_LINUX
+  std::mutex mutex_;
+  std::condition_variable cv_;
+#endif
+};
+
+}  // namespace femtolog::logging
+
+#endif  // INCLUDE_FEMTOLOG_LOGGING_IMPL_BACKEND_WAKEUP_H_
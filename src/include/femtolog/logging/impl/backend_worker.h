@@ -6,12 +6,18 @@
 #define INCLUDE_FEMTOLOG_LOGGING_IMPL_BACKEND_WORKER_H_
 
 #include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
 #include <thread>
 #include <vector>
 
+#include "femtolog/base/call_site.h"
 #include "femtolog/base/log_entry.h"
 #include "femtolog/base/string_registry.h"
+#include "femtolog/core/base/tsc_clock.h"
 #include "femtolog/logging/impl/args_deserializer.h"
+#include "femtolog/logging/impl/backend_wakeup.h"
 #include "femtolog/logging/impl/spsc_queue.h"
 #include "femtolog/options.h"
 #include "femtolog/sinks/sink_base.h"
@@ -42,37 +48,123 @@ class BackendWorker {
   void init(SpscQueue* queue,
             const FemtologOptions& options = FemtologOptions());
 
+  // Initializes the worker without any queue. Queues are attached later with
+  // attach_queue(), which is how the shared backend feeds its workers.
+  void init(const FemtologOptions& options);
+
   void start();
   void stop();
   void flush();
 
+  // Thread-safe. May be called while the worker is running; the queue is
+  // picked up on the next iteration of the backend loop.
+  void attach_queue(SpscQueue* queue);
+
+  // Thread-safe. If the worker is running, blocks until the backend has
+  // drained the queue and stopped polling it. The queue must not be written
+  // to after this call starts.
+  void detach_queue(SpscQueue* queue);
+
+  std::size_t queue_count() const;
+
   void register_sink(std::unique_ptr<SinkBase> sink);
+  void register_shared_sink(std::shared_ptr<SinkBase> sink);
   void clear_sinks();
 
+  // Serializes every sink call through `mutex`. Needed when several workers
+  // share the same sink instances. Must be set while not running.
+  void set_sink_mutex(std::mutex* mutex);
+
   BackendWorkerStatus status() const { return status_; }
 
+  // Producers feeding this worker notify it through here after each entry.
+  BackendWakeup* wakeup() noexcept { return &wakeup_; }
+
  private:
+  // An attached queue and the queue of its grow chain (see
+  // SpscQueue::successor()) the backend is currently reading from.
+  struct QueueCursor {
+    SpscQueue* head;
+    SpscQueue* current;
+  };
+
   void set_cpu_affinity();
-  inline bool read_and_process_one();
+  inline bool read_and_process_one(QueueCursor* cursor);
+  bool read_wrapped_entry(QueueCursor* cursor);
+  inline bool drain_queue(QueueCursor* cursor, std::size_t max_entries);
   inline void apply_polling_strategy(bool data_dequeued);
+  void park();
+  bool has_pending_work();
+  inline void sync_queues();
   void run_loop();
 
   void flush_impl();
-  void process_log_entry(LogEntry* entry);
+  void process_log_entry(QueueMetadata* metadata,
+                         const QueuedEntryHeader& header,
+                         const char* payload);
+  void process_log_entry(uint64_t entry_timestamp_ns,
+                         uint32_t thread_id,
+                         const QueuedEntryHeader& header,
+                         const char* payload);
+  // Logs the calls the rate limiters of the producer of `metadata` suppressed
+  // since they were last reported. Returns true if there were any.
+  bool report_suppressed_calls(const QueueMetadata& metadata);
+  bool report_suppressed_calls();
+  // Appends the message of the entry to `out` and returns its length.
+  std::size_t format_message(fmt::memory_buffer* out,
+                             const CallSite& call_site,
+                             const QueuedEntryHeader& header,
+                             const char* payload);
+  inline void dispatch_to_sinks(const LogEntry& entry,
+                                const char* content,
+                                std::size_t len);
+  void update_sinks();
+  void flush_sinks();
 
   alignas(64) std::vector<uint8_t> dequeue_buffer_;
   uint8_t* dequeue_buffer_ptr_ = nullptr;
-  std::vector<std::unique_ptr<SinkBase>> sinks_;
-  SpscQueue* queue_ = nullptr;
+  // Grouped by layout, so that each layout renders a line once per entry.
+  std::vector<std::shared_ptr<SinkBase>> sinks_;
+  // The only sink, if it has a log buffer to format messages into.
+  SinkBase* log_buffer_sink_ = nullptr;
+  std::mutex* sink_mutex_ = nullptr;
+
+  // Queues drained by the backend thread. `queues_` is owned by the backend
+  // thread while running and refreshed from `pending_queues_` whenever
+  // `queues_version_` moves past `queues_applied_version_`. Queues in
+  // `detached_queues_` are drained one last time on the next refresh.
+  std::vector<QueueCursor> queues_;
+  mutable std::mutex queues_mutex_;
+  std::vector<SpscQueue*> pending_queues_;
+  std::vector<SpscQueue*> detached_queues_;
+  std::atomic<uint64_t> queues_version_{0};
+  std::atomic<uint64_t> queues_applied_version_{0};
+
   std::thread worker_thread_;
   std::size_t worker_thread_cpu_affinity_ = 5;
   std::atomic<bool> shutdown_required_{false};
   std::atomic<uint64_t> flush_requested_seq_{0};
   std::atomic<uint64_t> flush_completed_seq_{0};
   fmt::memory_buffer format_buffer_;
+  // The line of the layout being dispatched to sinks.
+  fmt::memory_buffer line_buffer_;
+  core::TscClock tsc_clock_;
+
+  // When report_suppressed_calls() last ran, on the coarse monotonic clock.
+  uint64_t suppressed_calls_reported_ns_ = 0;
 
   // Polling strategy state
   std::size_t idle_iterations_ = 0;
+  BackendWaitStrategy wait_strategy_ = BackendWaitStrategy::kPolling;
+  std::size_t spin_iterations_ = 0;
+  std::chrono::microseconds park_timeout_{0};
+
+  // Whether sinks hold lines written since they were last flushed, and since
+  // when.
+  bool sinks_dirty_ = false;
+  std::chrono::steady_clock::time_point sinks_dirty_since_;
+  std::chrono::microseconds sink_flush_latency_{0};
+  BackendWakeup wakeup_;
 
   BackendWorkerStatus status_ = BackendWorkerStatus::kUninitialized;
 };
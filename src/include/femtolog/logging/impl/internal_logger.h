@@ -5,25 +5,36 @@
 #ifndef INCLUDE_FEMTOLOG_LOGGING_IMPL_INTERNAL_LOGGER_H_
 #define INCLUDE_FEMTOLOG_LOGGING_IMPL_INTERNAL_LOGGER_H_
 
+#include <cstdint>
+#include <cstring>
 #include <memory>
 #include <new>
+#include <string_view>
 #include <utility>
+#include <vector>
 
+#include "femtolog/base/call_site.h"
 #include "femtolog/base/log_entry.h"
 #include "femtolog/base/log_level.h"
 #include "femtolog/base/string_registry.h"
+#include "femtolog/build/build_flag.h"
+#include "femtolog/core/base/tsc_clock.h"
 #include "femtolog/logging/base/logging_export.h"
 #include "femtolog/logging/impl/args_serializer.h"
+#include "femtolog/logging/impl/backend_wakeup.h"
 #include "femtolog/logging/impl/backend_worker.h"
+#include "femtolog/logging/impl/large_message_pool.h"
+#include "femtolog/logging/impl/rate_limiter.h"
 #include "femtolog/logging/impl/spsc_queue.h"
 #include "femtolog/options.h"
 #include "femtolog/sinks/sink_base.h"
 
 namespace femtolog::logging {
 
-// 1KiB max per entry. (consider sizeof LogEntry)
-// Use reference mode if you need to output strings longer than this limit
-static constexpr const std::size_t kMaxPayloadSize = 1024 - sizeof(LogEntry);
+// 1KiB max per entry. (consider the size of QueuedEntryHeader)
+// Larger arguments are taken out of line, see FemtologOptions::max_message_size
+static constexpr const std::size_t kMaxPayloadSize =
+    1024 - QueuedEntryHeader::kMaxSize;
 
 class FEMTOLOG_LOGGING_EXPORT InternalLogger {
  public:
@@ -39,6 +50,7 @@ class FEMTOLOG_LOGGING_EXPORT InternalLogger {
 
   void init(const FemtologOptions& options = FemtologOptions());
 
+  // Rejected in BackendMode::kShared, whose sinks belong to SharedBackend.
   void register_sink(std::unique_ptr<SinkBase> sink);
 
   void clear_sinks();
@@ -54,6 +66,12 @@ class FEMTOLOG_LOGGING_EXPORT InternalLogger {
     return thread_id_;
   }
 
+  [[nodiscard]] inline bool running() const noexcept { return running_; }
+
+  [[nodiscard]] inline BackendMode backend_mode() const noexcept {
+    return backend_mode_;
+  }
+
   [[nodiscard]] inline std::size_t enqueued_count() const noexcept {
     return enqueued_count_;
   }
@@ -69,37 +87,95 @@ class FEMTOLOG_LOGGING_EXPORT InternalLogger {
 
   template <LogLevel level, FixedString fmt, bool ref_mode, typename... Args>
   inline void log(Args&&... args) noexcept {
-    // Compile-time level check
-    // Assuming `debug` is common threshold
-    if constexpr (level > LogLevel::kDebug) {
-      if (level > level_) [[unlikely]] {
-        return;
-      }
+    log_with_policy<level, fmt, ref_mode, OverflowPolicy::kDefault, Args...>(
+        std::forward<Args>(args)...);
+  }
+
+  template <LogLevel level,
+            FixedString fmt,
+            bool ref_mode,
+            OverflowPolicy policy,
+            typename... Args>
+  inline void log_with_policy(Args&&... args) noexcept {
+    // Levels below FEMTOLOG_ACTIVE_LEVEL leave no code behind: no level
+    // check, no format string registration and no serialization.
+    if constexpr (!is_level_active(level)) {
+      return;
     } else {
-      if (level > level_) [[likely]] {
+      // Compile-time level check
+      // Assuming `debug` is common threshold
+      if constexpr (level > LogLevel::kDebug) {
+        if (level > level_) [[unlikely]] {
+          return;
+        }
+      } else {
+        if (level > level_) [[likely]] {
+          return;
+        }
+      }
+
+      if (!running_) [[unlikely]] {
         return;
       }
-    }
 
-    if (backend_worker_.status() != BackendWorkerStatus::kRunning)
-        [[unlikely]] {
-      return;
+      if constexpr (sizeof...(Args) == 0) {
+        // Literals travel as a bare header; the backend takes the text from
+        // the call site.
+        const uint32_t call_site =
+            static_call_site_registration<level, fmt, nullptr>.index();
+        write_entry<level, policy>(call_site, 0, 0, [](char*) {});
+      } else {
+        StringRegistry::register_static<fmt>();
+        constexpr DeserializeAndFormatFunction deserialize =
+            DeserializeDispatcher<ref_mode, serialized_arg_t<Args>...>::
+                template compiled_function<fmt>();
+        const uint32_t call_site =
+            static_call_site_registration<level, fmt, deserialize>.index();
+
+        const std::size_t payload_len =
+            serialized_args_size<ref_mode, Args...>(
+                std::forward<Args>(args)...);
+        if (payload_len >= kMaxPayloadSize) [[unlikely]] {
+          write_large_entry<level, ref_mode, policy, Args...>(
+              call_site, payload_len, std::forward<Args>(args)...);
+          return;
+        }
+
+        write_entry<level, policy>(
+            call_site, 0, payload_len, [&](char* payload) {
+              serialize_args_to<ref_mode, Args...>(
+                  payload, std::forward<Args>(args)...);
+            });
+      }
     }
+  }
 
-    if constexpr (sizeof...(Args) == 0) {
-      constexpr std::string_view view(fmt.data, fmt.size);
-      log_literal<level>(view);
-    } else {
-      constexpr uint16_t format_id = StringRegistry::get_string_id<fmt>();
-      string_registry_.register_string<fmt>();
-
-      const auto& serialized_args =
-          serializer_.serialize<fmt, ref_mode>(std::forward<Args>(args)...);
-      log_serialized<level>(format_id, serialized_args);
+  // Counts a call of the call site logging `fmt` at `level` that `limiter`,
+  // an AtMostLimiter, suppressed. The backend reports the count.
+  template <LogLevel level, FixedString fmt, typename Limiter>
+  inline void count_suppressed(Limiter* limiter) noexcept {
+    if constexpr (is_level_active(level)) {
+      if (level > level_ || !running_) {
+        return;
+      }
+      SuppressedCalls* calls = limiter->suppressed_calls(id_);
+      if (!calls) [[unlikely]] {
+        StringRegistry::register_static<kSuppressedCallsFormat>();
+        constexpr DeserializeAndFormatFunction deserialize =
+            DeserializeDispatcher<false, uint64_t, std::string_view>::
+                template compiled_function<kSuppressedCallsFormat>();
+        calls = add_suppressed_calls(
+            static_call_site_registration<level, kSuppressedCallsFormat,
+                                          deserialize>
+                .index(),
+            format_without_newline<fmt>());
+        limiter->set_suppressed_calls(id_, calls);
+      }
+      calls->add();
     }
   }
 
-  inline void flush() noexcept { backend_worker_.flush(); }
+  void flush() noexcept;
 
   inline void level(LogLevel level) noexcept { level_ = level; }
 
@@ -108,78 +184,231 @@ class FEMTOLOG_LOGGING_EXPORT InternalLogger {
   [[nodiscard]] static bool is_ansi_sequence_available();
 
  private:
-  template <LogLevel level>
-  inline constexpr void log_literal(const std::string_view& message) {
-    const std::size_t payload_len = message.size();
-    if (payload_len >= kMaxPayloadSize) [[unlikely]] {
-      dropped_count_++;
-      return;
-    }
-
-    const LogEntry* entry =
-        LogEntry::create(entry_buffer_, thread_id_, kLiteralLogStringId, level,
-                         0, message.data(), message.length());
-
-    enqueue_log_entry(entry);
-  }
-
-  template <LogLevel level, std::size_t Capacity>
-  inline constexpr void log_serialized(
-      uint16_t format_id,
-      const SerializedArgs<Capacity>& serialized) {
-    // NOLINTNEXTLINE
-    if (serialized.size() >= kMaxPayloadSize || serialized.size() == 0)
-        [[unlikely]] {
-      dropped_count_++;
-      return;
-    }
-
-    const LogEntry* entry =
-        LogEntry::create(entry_buffer_, thread_id_, format_id, level, 0,
-                         serialized.data(), serialized.size());
-
-    enqueue_log_entry(entry);
-  }
-
-  inline void enqueue_log_entry(const LogEntry* entry) noexcept;
+  // Writes the entry header and lets `write_payload` fill in the payload
+  // directly in the queue, so nothing is staged on the fast path. Entries of a
+  // full call site registry are dropped. Returns true if the entry was
+  // enqueued.
+  template <LogLevel level, OverflowPolicy policy, typename PayloadWriter>
+  [[gnu::always_inline]] inline bool write_entry(
+      uint32_t call_site,
+      uint32_t flags,
+      std::size_t payload_len,
+      PayloadWriter&& write_payload) noexcept;
+
+  // Cold path of write_entry(), taken when the slot would wrap around the end
+  // of the queue or the queue is full. Fills in the timestamp of `header`.
+  template <OverflowPolicy policy, typename PayloadWriter>
+  FEMTOLOG_NO_INLINE bool write_entry_slow(
+      QueuedEntryHeader* header,
+      bool has_timestamp,
+      PayloadWriter& write_payload) noexcept;
+
+  // Serializes arguments too large for a queue entry into a buffer of
+  // `large_message_pool_`, and enqueues a pointer to it. Applies
+  // `oversize_policy_` above `max_message_size_`.
+  template <LogLevel level,
+            bool ref_mode,
+            OverflowPolicy policy,
+            typename... Args>
+  FEMTOLOG_NO_INLINE void write_large_entry(uint32_t call_site,
+                                            std::size_t payload_len,
+                                            Args&&... args) noexcept;
+
+  // Returns nullptr if the message is to be dropped. Waits for the backend to
+  // release a buffer under OverflowPolicy::kBlock.
+  [[nodiscard]] LargeMessagePool::Buffer* acquire_large_buffer(
+      std::size_t size,
+      OverflowPolicy policy) noexcept;
+
+  // Returns false if a full queue would drop the entry anyway, in which case
+  // it is not worth serializing.
+  [[nodiscard]] bool should_stage_entry(std::size_t entry_size,
+                                        OverflowPolicy policy) noexcept;
+
+  // Returns true if the staged entry was enqueued.
+  bool enqueue_staged(const void* entry,
+                      std::size_t entry_size,
+                      OverflowPolicy policy) noexcept;
+
+  // Cold path of enqueue_staged(). Returns true if the entry was enqueued.
+  bool enqueue_on_overflow(const void* entry,
+                           std::size_t entry_size,
+                           OverflowPolicy policy) noexcept;
+
+  bool grow_queue(std::size_t entry_size) noexcept;
+
+  // Returns the counter of the call site, publishing a new one in the
+  // metadata of `queue_` if the call site has none yet.
+  FEMTOLOG_NO_INLINE SuppressedCalls* add_suppressed_calls(
+      uint32_t summary_call_site,
+      std::string_view format) noexcept;
 
   [[nodiscard]] static uint32_t current_thread_id() noexcept;
 
-  friend void internal_logger_enqueue_log_entry_bench(InternalLogger* logger);
-
   // Hot data - frequently accessed (first cache line)
   alignas(core::kCacheSize) LogLevel level_ = LogLevel::kInfo;
-  const uint32_t thread_id_;
+  bool running_ = false;
+  TimestampSource timestamp_source_ = TimestampSource::kBackend;
+  // Ticks of the last enqueued entry, which the next one is delta-encoded
+  // against. Only used with frontend timestamps.
+  uint64_t last_timestamp_ = 0;
   std::size_t enqueued_count_ = 0;
   std::size_t dropped_count_ = 0;
-  StringRegistry string_registry_;
-  ArgsSerializer<> serializer_;
+  // Queue the producer currently writes to. Either `queue_` or the last one
+  // in `grown_queues_`.
+  SpscQueue* active_queue_;
+  // Wakeup of the backend worker draining `queue_`. Set while running.
+  BackendWakeup* backend_wakeup_ = nullptr;
 
   // Cold data - less frequently accessed (separate cache line)
   alignas(core::kCacheSize) SpscQueue queue_;
-
-  // Buffer management (separate cache line)
-  alignas(LogEntry) alignas(core::kCacheSize) uint8_t
-      entry_buffer_[sizeof(LogEntry) + kMaxPayloadSize];
+  const uint32_t thread_id_;
+  // Unique in the process, unlike the address of the logger.
+  const uint64_t id_;
+  std::vector<std::unique_ptr<SpscQueue>> grown_queues_;
+  OverflowPolicy overflow_policy_ = OverflowPolicy::kDrop;
+  std::size_t overflow_spin_iterations_ = 0;
+  std::size_t overflow_grow_max_size_ = 0;
+  LargeMessagePool large_message_pool_;
+  std::size_t max_message_size_ = 0;
+  OversizePolicy oversize_policy_ = OversizePolicy::kDrop;
+  // Counters of the rate limited call sites, read by the backend through the
+  // metadata of `queue_`.
+  std::vector<std::unique_ptr<SuppressedCalls>> suppressed_calls_;
 
   BackendWorker backend_worker_;
+  BackendMode backend_mode_ = BackendMode::kDedicated;
   bool terminate_on_fatal_ : 1 = true;
 };
 
-inline void InternalLogger::enqueue_log_entry(const LogEntry* entry) noexcept {
-  const std::size_t entry_size = entry->total_size();
+template <LogLevel level, OverflowPolicy policy, typename PayloadWriter>
+inline bool InternalLogger::write_entry(
+    uint32_t call_site,
+    uint32_t flags,
+    std::size_t payload_len,
+    PayloadWriter&& write_payload) noexcept {
+  if (call_site == 0) [[unlikely]] {
+    dropped_count_++;
+    return false;
+  }
 
-  // Direct enqueue with minimal overhead
-  const SpscQueueStatus result = queue_.enqueue_bytes(entry, entry_size);
-  if (result == SpscQueueStatus::kOk) [[likely]] {
+  QueuedEntryHeader header;
+  header.call_site_index = call_site;
+  header.flags = flags;
+  header.payload_len = static_cast<uint32_t>(payload_len);
+  // Without frontend timestamps the backend stamps entries at dequeue time.
+  const bool has_timestamp =
+      timestamp_source_ == TimestampSource::kFrontendTsc;
+  // The delta is only known once the clock is read, which is not worth doing
+  // for entries a full queue drops; reserve room for the longest one.
+  const std::size_t max_entry_size = header.size(false) + payload_len +
+                                     (has_timestamp ? kMaxVarintSize : 0);
+
+  bool enqueued = true;
+  std::byte* slot = active_queue_->reserve_write(max_entry_size);
+  if (slot) [[likely]] {
+    uint64_t ticks = 0;
+    if (has_timestamp) {
+      ticks = core::tsc_ticks();
+      header.timestamp_delta = ticks - last_timestamp_;
+      last_timestamp_ = ticks;
+    }
+    write_payload(header.encode(reinterpret_cast<char*>(slot), has_timestamp));
+    active_queue_->commit_write(header.size(has_timestamp) + payload_len);
     enqueued_count_++;
   } else {
+    enqueued = write_entry_slow<policy>(&header, has_timestamp, write_payload);
+  }
+  backend_wakeup_->notify();
+
+  if constexpr (level == LogLevel::kFatal) {
+    if (terminate_on_fatal_) {
+      stop_worker();
+      std::terminate();
+    }
+  }
+  return enqueued;
+}
+
+template <OverflowPolicy policy, typename PayloadWriter>
+bool InternalLogger::write_entry_slow(QueuedEntryHeader* header,
+                                      bool has_timestamp,
+                                      PayloadWriter& write_payload) noexcept {
+  const std::size_t max_entry_size = header->size(false) +
+                                     header->payload_len +
+                                     (has_timestamp ? kMaxVarintSize : 0);
+  if (!should_stage_entry(max_entry_size, policy)) {
     dropped_count_++;
+    return false;
+  }
+
+  uint64_t ticks = 0;
+  if (has_timestamp) {
+    ticks = core::tsc_ticks();
+    header->timestamp_delta = ticks - last_timestamp_;
+  }
+  char staging[QueuedEntryHeader::kMaxSize + kMaxPayloadSize];
+  write_payload(header->encode(staging, has_timestamp));
+
+  const std::size_t entry_size =
+      header->size(has_timestamp) + header->payload_len;
+  if (enqueue_staged(staging, entry_size, policy)) {
+    last_timestamp_ = ticks;
+    enqueued_count_++;
+    return true;
+  }
+  dropped_count_++;
+  return false;
+}
+
+template <LogLevel level,
+          bool ref_mode,
+          OverflowPolicy policy,
+          typename... Args>
+void InternalLogger::write_large_entry(uint32_t call_site,
+                                       std::size_t payload_len,
+                                       Args&&... args) noexcept {
+  // Reference mode arguments do not grow with the message, and cannot be cut.
+  std::size_t excess = 0;
+  if (payload_len > max_message_size_) {
+    if constexpr (!ref_mode) {
+      if (oversize_policy_ == OversizePolicy::kTruncate) {
+        excess = payload_len - max_message_size_;
+      }
+    }
+    if (excess == 0) {
+      dropped_count_++;
+      return;
+    }
   }
 
-  if (entry->level == LogLevel::kFatal && terminate_on_fatal_) {
-    backend_worker_.stop();
-    std::terminate();
+  LargeMessagePool::Buffer* buffer =
+      acquire_large_buffer(payload_len - excess, policy);
+  if (!buffer) {
+    dropped_count_++;
+    return;
+  }
+  uint32_t flags = QueuedEntryHeader::kOutOfLinePayload;
+  if (excess == 0) {
+    serialize_args_to<ref_mode, Args...>(buffer->data(),
+                                         std::forward<Args>(args)...);
+  } else if constexpr (!ref_mode) {
+    if (!serialize_truncated_args_to<Args...>(buffer->data(), excess,
+                                              std::forward<Args>(args)...)) {
+      LargeMessagePool::release(buffer);
+      dropped_count_++;
+      return;
+    }
+    flags |= QueuedEntryHeader::kTruncated;
+  }
+  buffer->size = payload_len - excess;
+
+  if (!write_entry<level, policy>(call_site, flags, sizeof(buffer),
+                                  [buffer](char* payload) {
+                                    std::memcpy(payload, &buffer,
+                                                sizeof(buffer));
+                                  })) {
+    LargeMessagePool::release(buffer);
   }
 }
 
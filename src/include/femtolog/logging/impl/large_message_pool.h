@@ -0,0 +1,97 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#ifndef INCLUDE_FEMTOLOG_LOGGING_IMPL_LARGE_MESSAGE_POOL_H_
+#define INCLUDE_FEMTOLOG_LOGGING_IMPL_LARGE_MESSAGE_POOL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "femtolog/core/base/memory_util.h"
+#include "femtolog/logging/base/logging_export.h"
+
+namespace femtolog::logging {
+
+// Heap buffers for serialized arguments too large to travel through a log
+// queue; the queued entry carries a pointer to the buffer instead.
+//
+// One producer takes buffers with acquire() and the backend gives them back
+// with release() once the entry has been formatted. Released buffers are
+// pushed onto a lock-free stack that the producer takes over whole when its
+// own free list runs dry, so the backend never waits for the producer. A
+// producer that needs a buffer while all of them are in flight can park until
+// the next release. Buffers are reused for later messages and the total
+// allocated size is capped.
+class FEMTOLOG_LOGGING_EXPORT LargeMessagePool {
+ public:
+  struct Buffer {
+    Buffer* next;
+    LargeMessagePool* pool;
+    std::size_t capacity;
+    // Bytes of serialized arguments in the buffer.
+    std::size_t size;
+
+    inline char* data() noexcept { return reinterpret_cast<char*>(this + 1); }
+  };
+
+  LargeMessagePool() = default;
+  ~LargeMessagePool();
+
+  LargeMessagePool(const LargeMessagePool&) = delete;
+  LargeMessagePool& operator=(const LargeMessagePool&) = delete;
+
+  // Producer side. Must not be called while buffers are in flight.
+  inline void set_max_size(std::size_t max_size) noexcept {
+    max_size_ = max_size;
+  }
+
+  // Producer side. Returns a buffer of at least `size` bytes, or nullptr if
+  // that would take the pool over its maximum size while other buffers are
+  // allocated.
+  [[nodiscard]] Buffer* acquire(std::size_t size) noexcept;
+
+  // Producer side. Whether buffers handed out are still to be released, so
+  // that waiting for one can succeed.
+  [[nodiscard]] bool has_buffers_in_flight() noexcept;
+
+  // Producer side. Number of release() calls so far, to pass to
+  // wait_for_release().
+  [[nodiscard]] inline uint32_t release_count() const noexcept {
+    return release_count_.load(std::memory_order_acquire);
+  }
+
+  // Producer side. Blocks until release_count() differs from `seen`.
+  void wait_for_release(uint32_t seen) noexcept;
+
+  // Any thread. Gives `buffer` back to the pool it came from.
+  static void release(Buffer* buffer) noexcept;
+
+  [[nodiscard]] inline std::size_t allocated_size() const noexcept {
+    return allocated_size_;
+  }
+
+ private:
+  // Moves the buffers released by the backend to `free_list_`.
+  void reclaim() noexcept;
+  void deallocate(Buffer* buffer) noexcept;
+
+  // Producer data
+  Buffer* free_list_ = nullptr;
+  std::size_t allocated_size_ = 0;
+  std::size_t allocated_count_ = 0;
+  std::size_t free_count_ = 0;
+  std::size_t max_size_ = 0;
+
+  // Backend side
+  alignas(core::kCacheSize) std::atomic<Buffer*> released_ = nullptr;
+  // Waited on by the producer. A 32-bit word so that it maps to a futex.
+  std::atomic<uint32_t> release_count_ = 0;
+  // Set while the producer is parked in wait_for_release().
+  std::atomic<bool> producer_waiting_ = false;
+};
+
+}  // namespace femtolog::logging
+
+#endif  // INCLUDE_FEMTOLOG_LOGGING_IMPL_LARGE_MESSAGE_POOL_H_
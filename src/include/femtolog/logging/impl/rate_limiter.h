@@ -0,0 +1,163 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#ifndef INCLUDE_FEMTOLOG_LOGGING_IMPL_RATE_LIMITER_H_
+#define INCLUDE_FEMTOLOG_LOGGING_IMPL_RATE_LIMITER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "femtolog/base/format_util.h"
+#include "femtolog/base/log_level.h"
+
+namespace femtolog::logging {
+
+// Per-call-site admission checks for Logger::*_every_n, *_at_most and
+// *_sampled. Each one is a few plain loads and stores: the state is thread
+// local (every thread has its own logger and queue anyway) and constant
+// initialized, so neither atomics nor TLS init guards are involved.
+
+// Window of AtMostLimiter, and how often the backend reports the calls it
+// suppressed.
+inline constexpr uint64_t kRateLimitWindowNs = 1000000000ull;
+
+// Line the backend reports suppressed calls with. Its arguments are the number
+// of calls, as uint64_t, and the format of their call site, as a string view.
+inline constexpr FixedString kSuppressedCallsFormat =
+    "suppressed {} messages: \"{}\"\n";
+
+// Calls of one call site suppressed by an AtMostLimiter. The producer keeps a
+// running count, and the backend reports what it has not reported yet once a
+// window, and whenever the logger is flushed or stopped, so that the last
+// window of a quiet call site is reported too. Owned by the logger, which
+// publishes it in the metadata of its queue.
+struct SuppressedCalls {
+  // Only the producer writes `count`, so it needs no read-modify-write.
+  inline void add() noexcept {
+    count.store(count.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+  }
+
+  // Index of the kSuppressedCallsFormat call site at the level of the limited
+  // call site.
+  uint32_t summary_call_site = 0;
+  // Format of the limited call site, without its trailing newline.
+  std::string_view format;
+  std::atomic<uint64_t> count = 0;
+  // Backend side: `count` when it was last reported.
+  uint64_t reported = 0;
+  // Set before the node is published, and never changed after.
+  SuppressedCalls* next = nullptr;
+};
+
+// Admits the first call and then every `n`-th one.
+template <std::size_t n>
+class EveryNLimiter {
+  static_assert(n > 0, "n must be positive");
+
+ public:
+  [[nodiscard]] inline bool admit() noexcept {
+    if (countdown_ == 0) {
+      countdown_ = n - 1;
+      return true;
+    }
+    --countdown_;
+    return false;
+  }
+
+ private:
+  std::size_t countdown_ = 0;
+};
+
+// Admits up to `per_sec` calls per one-second window. The calls it suppresses
+// are counted in the SuppressedCalls of the logger they were made on.
+template <std::size_t per_sec>
+class AtMostLimiter {
+  static_assert(per_sec > 0, "per_sec must be positive");
+
+ public:
+  static constexpr uint64_t kWindowNs = kRateLimitWindowNs;
+
+  // `now_ns` is any monotonic clock in nanoseconds.
+  [[nodiscard]] inline bool admit(uint64_t now_ns) noexcept {
+    if (now_ns - window_begin_ns_ >= kWindowNs) [[unlikely]] {
+      admitted_ = 0;
+      window_begin_ns_ = now_ns;
+    }
+    if (admitted_ < per_sec) [[likely]] {
+      ++admitted_;
+      return true;
+    }
+    return false;
+  }
+
+  // The counter of the logger `logger_id` for this call site, or null if it
+  // was not set for that logger.
+  [[nodiscard]] inline SuppressedCalls* suppressed_calls(
+      uint64_t logger_id) const noexcept {
+    return logger_id == logger_id_ ? suppressed_calls_ : nullptr;
+  }
+
+  inline void set_suppressed_calls(uint64_t logger_id,
+                                   SuppressedCalls* calls) noexcept {
+    logger_id_ = logger_id;
+    suppressed_calls_ = calls;
+  }
+
+ private:
+  uint64_t window_begin_ns_ = 0;
+  std::size_t admitted_ = 0;
+  // Loggers are told apart by id rather than address, which a later logger
+  // may reuse.
+  uint64_t logger_id_ = 0;
+  SuppressedCalls* suppressed_calls_ = nullptr;
+};
+
+// Admits each call independently with probability `p`.
+template <double p>
+class SampledLimiter {
+  static_assert(p >= 0.0 && p <= 1.0, "p must be a probability");
+
+ public:
+  [[nodiscard]] inline bool admit() noexcept {
+    if (state_ == 0) [[unlikely]] {
+      // Distinct per thread, since the limiter itself is thread local.
+      state_ = reinterpret_cast<uintptr_t>(this);
+    }
+    // splitmix64
+    uint64_t z = (state_ += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    z ^= z >> 31;
+    return (z >> 11) < kThreshold;
+  }
+
+ private:
+  // Compare the top 53 bits so that p == 1.0 admits everything.
+  static constexpr uint64_t kThreshold =
+      static_cast<uint64_t>(p * static_cast<double>(1ull << 53));
+
+  uint64_t state_ = 0;
+};
+
+// One limiter per call site. A call site is identified by its format string
+// and level rather than by the 16-bit format id, which may collide.
+template <LogLevel level, FixedString fmt, typename Limiter>
+inline thread_local Limiter call_site_limiter;
+
+// `fmt` without its trailing newline, for the kSuppressedCallsFormat line.
+template <FixedString fmt>
+consteval std::string_view format_without_newline() {
+  std::string_view view = fmt.view();
+  if (!view.empty() && view.back() == '\n') {
+    view.remove_suffix(1);
+  }
+  return view;
+}
+
+}  // namespace femtolog::logging
+
+#endif  // INCLUDE_FEMTOLOG_LOGGING_IMPL_RATE_LIMITER_H_
@@ -0,0 +1,77 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#ifndef INCLUDE_FEMTOLOG_LOGGING_IMPL_SHARED_BACKEND_H_
+#define INCLUDE_FEMTOLOG_LOGGING_IMPL_SHARED_BACKEND_H_
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "femtolog/logging/base/logging_export.h"
+#include "femtolog/logging/impl/backend_wakeup.h"
+#include "femtolog/logging/impl/backend_worker.h"
+#include "femtolog/logging/impl/spsc_queue.h"
+#include "femtolog/options.h"
+#include "femtolog/sinks/sink_base.h"
+
+namespace femtolog::logging {
+
+// Process-wide pool of backend workers used by loggers initialized with
+// BackendMode::kShared. Every attached SPSC queue is assigned to one worker,
+// and each worker drains its queues round-robin, so the number of backend
+// threads stays fixed no matter how many producer threads log.
+//
+// The workers are started when the first queue is attached and stopped when
+// the last one is detached. Sinks are owned by the pool and shared by all of
+// its workers; they are registered once for the whole process, before any
+// shared-mode logger starts, not through the loggers of each thread.
+class FEMTOLOG_LOGGING_EXPORT SharedBackend {
+ public:
+  SharedBackend(const SharedBackend&) = delete;
+  SharedBackend& operator=(const SharedBackend&) = delete;
+
+  SharedBackend(SharedBackend&&) noexcept = delete;
+  SharedBackend& operator=(SharedBackend&&) noexcept = delete;
+
+  static SharedBackend& instance();
+
+  // Creates the worker threads on first call. Later calls are no-ops.
+  void init(const FemtologOptions& options = FemtologOptions());
+
+  // Both are rejected while the workers are running.
+  void register_sink(std::unique_ptr<SinkBase> sink);
+  void clear_sinks();
+
+  // Returns the wakeup of the worker that drains `queue`.
+  BackendWakeup* attach(SpscQueue* queue);
+  void detach(SpscQueue* queue);
+
+  void flush();
+
+  [[nodiscard]] std::size_t worker_count() const;
+  [[nodiscard]] std::size_t attached_count() const;
+  [[nodiscard]] bool running() const;
+
+ private:
+  SharedBackend();
+  ~SharedBackend();
+
+  void start_workers();
+  void stop_workers();
+
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<BackendWorker>> workers_;
+  std::vector<std::shared_ptr<SinkBase>> sinks_;
+  std::unordered_map<SpscQueue*, BackendWorker*> assignments_;
+  bool running_ = false;
+
+  // Serializes sink calls when more than one worker shares the sinks.
+  std::mutex sink_mutex_;
+};
+
+}  // namespace femtolog::logging
+
+#endif  // INCLUDE_FEMTOLOG_LOGGING_IMPL_SHARED_BACKEND_H_
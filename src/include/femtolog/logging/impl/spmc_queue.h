@@ -35,7 +35,11 @@ class FEMTOLOG_LOGGING_EXPORT SpmcQueue {
   SpmcQueue(SpmcQueue&&) noexcept = delete;
   SpmcQueue& operator=(SpmcQueue&&) noexcept = delete;
 
-  void reserve(std::size_t capacity_bytes);
+  // Allocates a power-of-two ring of at least `capacity_bytes`. With
+  // `mirrored`, the ring is mapped twice back to back (Linux, rounded up to
+  // whole pages) so that every entry is contiguous in memory; falls back to a
+  // plain aligned allocation where that is not available.
+  void reserve(std::size_t capacity_bytes, bool mirrored = false);
 
   template <typename T>
   inline SpmcQueueStatus enqueue_bytes(const T* data) noexcept {
@@ -74,6 +78,10 @@ class FEMTOLOG_LOGGING_EXPORT SpmcQueue {
     return capacity_;
   }
 
+  [[nodiscard]] inline bool mirrored() const noexcept {
+    return contiguous_size_ != capacity_;
+  }
+
   [[nodiscard]] inline std::size_t available_space() const noexcept {
     FEMTOLOG_DCHECK(buffer_);
     return capacity_ - size();
@@ -98,6 +106,9 @@ class FEMTOLOG_LOGGING_EXPORT SpmcQueue {
   alignas(core::kCacheSize) std::byte* buffer_;
   std::size_t capacity_ = 0;
   std::size_t mask_ = 0;
+  // Bytes addressable from buffer_ without wrapping: the capacity, or twice
+  // that for a mirrored buffer.
+  std::size_t contiguous_size_ = 0;
 
   // Producer side (write-mostly, separate cache line)
   alignas(core::kCacheSize) std::atomic<std::size_t> tail_idx_ = 0;
@@ -109,7 +120,7 @@ class FEMTOLOG_LOGGING_EXPORT SpmcQueue {
 
   // Buffer management
   alignas(core::kCacheSize)
-      std::unique_ptr<std::byte[], core::AlignedDeleter> buffer_deleter_ =
+      std::unique_ptr<std::byte[], core::RingBufferDeleter> buffer_deleter_ =
           nullptr;
   std::size_t allocation_size_ = 0;
 };
@@ -5,10 +5,12 @@
 #ifndef INCLUDE_FEMTOLOG_LOGGING_IMPL_SPSC_QUEUE_H_
 #define INCLUDE_FEMTOLOG_LOGGING_IMPL_SPSC_QUEUE_H_
 
+#include <algorithm>
 #include <atomic>
 #include <cstddef>
 #include <memory>
 #include <new>
+#include <span>
 
 #include "femtolog/core/base/memory_util.h"
 #include "femtolog/core/check.h"
@@ -24,6 +26,23 @@ enum class SpscQueueStatus : uint8_t {
   kSizeIsZero = 4,
 };
 
+struct SuppressedCalls;
+
+// Describes the producer of a log queue, so that its entries need not repeat
+// it. The producer sets it while no backend reads the queue, and a grown
+// queue is described by the head of its chain.
+struct QueueMetadata {
+  uint32_t thread_id = 0;
+  // Entries carry a timestamp delta; see QueuedEntryHeader.
+  bool frontend_timestamps = false;
+  // Consumer side: ticks of the last entry read from the queue chain.
+  uint64_t last_timestamp = 0;
+  // Calls the rate limiters of the producer suppressed, one node per call
+  // site, newest first. Nodes are pushed by the producer and live as long as
+  // its logger.
+  std::atomic<SuppressedCalls*> suppressed_calls = nullptr;
+};
+
 class FEMTOLOG_LOGGING_EXPORT SpscQueue {
  public:
   SpscQueue();
@@ -35,7 +54,11 @@ class FEMTOLOG_LOGGING_EXPORT SpscQueue {
   SpscQueue(SpscQueue&&) noexcept = delete;
   SpscQueue& operator=(SpscQueue&&) noexcept = delete;
 
-  void reserve(std::size_t capacity_bytes);
+  // Allocates a power-of-two ring of at least `capacity_bytes`. With
+  // `mirrored`, the ring is mapped twice back to back (Linux, rounded up to
+  // whole pages) so that every entry is contiguous in memory; falls back to a
+  // plain aligned allocation where that is not available.
+  void reserve(std::size_t capacity_bytes, bool mirrored = false);
 
   template <typename T>
   inline SpscQueueStatus enqueue_bytes(const T* data) noexcept {
@@ -57,6 +80,88 @@ class FEMTOLOG_LOGGING_EXPORT SpscQueue {
   SpscQueueStatus peek_bytes(void* data_ptr,
                              std::size_t data_size) const noexcept;
 
+  // Returns a pointer to `data_size` contiguous writable bytes at the tail, or
+  // nullptr if the queue is full or the bytes would wrap around the end (never
+  // the case in a mirrored buffer). The bytes become visible to the consumer
+  // only after commit_write(). Producer side only.
+  [[nodiscard]] inline std::byte* reserve_write(
+      std::size_t data_size) noexcept {
+    FEMTOLOG_DCHECK(buffer_);
+    const std::size_t tail = tail_cached_;
+    const std::size_t offset = tail & mask_;
+    if (data_size > contiguous_size_ - offset) [[unlikely]] {
+      return nullptr;
+    }
+    if (tail + data_size - head_cached_snapshot_ > capacity_) [[unlikely]] {
+      head_cached_snapshot_ = head_idx_.load(std::memory_order_acquire);
+      if (tail + data_size - head_cached_snapshot_ > capacity_) {
+        return nullptr;
+      }
+    }
+    return buffer_ + offset;
+  }
+
+  // Publishes `data_size` bytes written through reserve_write().
+  inline void commit_write(std::size_t data_size) noexcept {
+    tail_cached_ += data_size;
+    tail_idx_.store(tail_cached_, std::memory_order_release);
+  }
+
+  // Bytes the producer can enqueue right now, wrap-around included.
+  [[nodiscard]] inline std::size_t writable_bytes() const noexcept {
+    head_cached_snapshot_ = head_idx_.load(std::memory_order_acquire);
+    return capacity_ - (tail_cached_ - head_cached_snapshot_);
+  }
+
+  // Consumer side zero-copy access. Returns the readable bytes that are
+  // contiguous in the buffer from the read position on; unless the buffer is
+  // mirrored, data that wraps around the end is only partly covered. The bytes
+  // stay valid and writable by the consumer until they are consumed and
+  // released.
+  [[nodiscard]] inline std::span<std::byte> readable_span() noexcept {
+    if (!buffer_) [[unlikely]] {
+      return {};
+    }
+    const std::size_t head = head_cached_;
+    std::size_t tail = tail_cached_snapshot_;
+    if (tail == head) {
+      tail = tail_idx_.load(std::memory_order_acquire);
+      tail_cached_snapshot_ = tail;
+    }
+    const std::size_t offset = head & mask_;
+    return {buffer_ + offset, std::min(tail - head, contiguous_size_ - offset)};
+  }
+
+  // Advances the read position without handing the space back to the
+  // producer, so that several entries can be released with one head update.
+  inline void consume(std::size_t data_size) noexcept {
+    FEMTOLOG_DCHECK_LE(data_size, tail_cached_snapshot_ - head_cached_);
+    head_cached_ += data_size;
+  }
+
+  // Publishes every consume()'d byte to the producer.
+  void release_read() noexcept;
+
+  // Blocks the producer until `data_size` bytes can be enqueued, without
+  // spinning. The consumer wakes it up after releasing space. Returns
+  // kOverflow immediately if `data_size` exceeds the capacity.
+  SpscQueueStatus wait_for_space(std::size_t data_size) noexcept;
+
+  // A queue that overflowed under OverflowPolicy::kGrow hands its producer
+  // over to a larger successor. The producer never writes to this queue again
+  // after publishing the successor, so the consumer may switch once this
+  // queue reads empty.
+  [[nodiscard]] inline SpscQueue* successor() const noexcept {
+    return successor_.load(std::memory_order_acquire);
+  }
+  inline void set_successor(SpscQueue* queue) noexcept {
+    successor_.store(queue, std::memory_order_release);
+  }
+
+  [[nodiscard]] inline QueueMetadata& metadata() noexcept {
+    return metadata_;
+  }
+
   [[nodiscard]] inline bool empty() const noexcept {
     const std::size_t head = head_cached_;
     const std::size_t tail = tail_idx_.load(std::memory_order_relaxed);
@@ -74,6 +179,10 @@ class FEMTOLOG_LOGGING_EXPORT SpscQueue {
     return capacity_;
   }
 
+  [[nodiscard]] inline bool mirrored() const noexcept {
+    return contiguous_size_ != capacity_;
+  }
+
   [[nodiscard]] inline std::size_t available_space() const noexcept {
     FEMTOLOG_DCHECK(buffer_);
     return capacity_ - size();
@@ -94,10 +203,15 @@ class FEMTOLOG_LOGGING_EXPORT SpscQueue {
   [[nodiscard]] static constexpr std::size_t next_power_of_2(
       std::size_t n) noexcept;
 
+  inline void notify_producer_if_waiting() noexcept;
+
   // Cache line aligned buffer
   alignas(core::kCacheSize) std::byte* buffer_;
   std::size_t capacity_ = 0;
   std::size_t mask_ = 0;
+  // Bytes addressable from buffer_ without wrapping: the capacity, or twice
+  // that for a mirrored buffer.
+  std::size_t contiguous_size_ = 0;
 
   // Producer side (write-mostly, separate cache line)
   alignas(core::kCacheSize) std::atomic<std::size_t> tail_idx_ = 0;
@@ -110,10 +224,15 @@ class FEMTOLOG_LOGGING_EXPORT SpscQueue {
   mutable std::size_t head_cached_ = 0;
   // Cached snapshot of tail for consumer
   mutable std::size_t tail_cached_snapshot_ = 0;
+  QueueMetadata metadata_;
+
+  // Set while the producer is parked in wait_for_space().
+  alignas(core::kCacheSize) std::atomic<bool> producer_waiting_ = false;
+  std::atomic<SpscQueue*> successor_ = nullptr;
 
   // Buffer management
   alignas(core::kCacheSize)
-      std::unique_ptr<std::byte[], core::AlignedDeleter> buffer_deleter_ =
+      std::unique_ptr<std::byte[], core::RingBufferDeleter> buffer_deleter_ =
           nullptr;
   std::size_t allocation_size_ = 0;
 };
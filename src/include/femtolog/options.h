@@ -16,6 +16,40 @@ enum class ColorMode : uint8_t {
   kNever = 2,
 };
 
+enum class OverflowPolicy : uint8_t {
+  // Per-call only: use FemtologOptions::overflow_policy.
+  kDefault = 0,
+  kDrop = 1,
+  kBlock = 2,
+  kSpinThenDrop = 3,
+  kGrow = 4,
+};
+
+enum class OversizePolicy : uint8_t {
+  kDrop = 0,
+  kTruncate = 1,
+};
+
+enum class TimestampSource : uint8_t {
+  kBackend = 0,
+  kFrontendTsc = 1,
+};
+
+enum class BackendMode : uint8_t {
+  kDedicated = 0,
+  kShared = 1,
+};
+
+enum class QueueMemory : uint8_t {
+  kAligned = 0,
+  kMirrored = 1,
+};
+
+enum class BackendWaitStrategy : uint8_t {
+  kPolling = 0,
+  kEventDriven = 1,
+};
+
 /**
  * @brief Configuration options for the femtolog's frontend and backend.
  *
@@ -77,6 +111,155 @@ struct FemtologOptions {
    * entry whose level is LogLevel::kFatal.
    */
   bool terminate_on_fatal : 1 = false;
+
+  /**
+   * @brief Which backend drains this logger's queue.
+   *
+   * BackendMode::kDedicated: the logger spawns its own backend worker thread.
+   * BackendMode::kShared: the logger's queue is attached to the process-wide
+   * shared backend, whose worker threads drain every attached queue in a
+   * round-robin fashion. Its sinks are shared by all shared-mode loggers and
+   * registered once with Logger::register_shared_sink(), not per logger.
+   * Recommended when many threads log, since the backend thread count no
+   * longer scales with the producer thread count.
+   * Default: BackendMode::kDedicated
+   */
+  BackendMode backend_mode = BackendMode::kDedicated;
+
+  /**
+   * @brief Number of worker threads of the shared backend.
+   *
+   * Only used with BackendMode::kShared. The value passed by the first logger
+   * that initializes the shared backend wins.
+   * Default: 1
+   */
+  std::size_t shared_backend_worker_count = 1;
+
+  /**
+   * @brief Where log entries get their timestamp.
+   *
+   * TimestampSource::kBackend: the backend reads CLOCK_REALTIME when it
+   * dequeues an entry, so the time spent in the queue is not reflected.
+   * TimestampSource::kFrontendTsc: the frontend stamps each entry with rdtsc
+   * (CLOCK_MONOTONIC_COARSE on non-x86 targets) at the call site, and the
+   * backend converts it to wall-clock time with a periodically recalibrated
+   * tick-to-nanosecond model. Assumes an invariant TSC.
+   * Default: TimestampSource::kBackend
+   */
+  TimestampSource timestamp_source = TimestampSource::kBackend;
+
+  /**
+   * @brief What to do when a log entry does not fit in the SPSC queue.
+   *
+   * OverflowPolicy::kDrop: drop the entry and count it in dropped_count().
+   * OverflowPolicy::kBlock: park the calling thread until the backend frees
+   * enough space. Does not burn CPU while waiting. For audit-critical logs.
+   * OverflowPolicy::kSpinThenDrop: retry for up to overflow_spin_iterations
+   * pause instructions, then drop. Bounds the added latency.
+   * OverflowPolicy::kGrow: switch to a queue twice as large, up to
+   * overflow_grow_max_size bytes, then drop.
+   * Can be overridden per call:
+   * `logger.info<"{}", OverflowPolicy::kBlock>(value)`.
+   * Default: OverflowPolicy::kDrop
+   */
+  OverflowPolicy overflow_policy = OverflowPolicy::kDrop;
+
+  /**
+   * @brief Retry budget of OverflowPolicy::kSpinThenDrop.
+   * Default: 1024
+   */
+  std::size_t overflow_spin_iterations = 1024;
+
+  /**
+   * @brief Upper bound of the queue size reached with OverflowPolicy::kGrow.
+   * Default: 64MiB (1024 * 1024 * 64 bytes)
+   */
+  std::size_t overflow_grow_max_size = 1024 * 1024 * 64;
+
+  /**
+   * @brief Largest serialized message a copy-mode log call accepts.
+   *
+   * Arguments that serialize to more than about 1KiB do not fit in a queue
+   * entry. Up to this size they are written to a pooled heap buffer instead,
+   * and the queue only carries a pointer to it. Larger messages follow
+   * oversize_policy. The formatted message may be longer than this.
+   * Default: 64KiB (1024 * 64 bytes)
+   */
+  std::size_t max_message_size = 1024 * 64;
+
+  /**
+   * @brief What to do with messages larger than max_message_size.
+   *
+   * OversizePolicy::kDrop: drop the message and count it in dropped_count().
+   * OversizePolicy::kTruncate: cut the longest string argument short so that
+   * the message fits, and append " [truncated]" to the formatted message
+   * (before its trailing newline, if any).
+   * Default: OversizePolicy::kDrop
+   */
+  OversizePolicy oversize_policy = OversizePolicy::kDrop;
+
+  /**
+   * @brief Memory a logger may hold in buffers for large messages.
+   *
+   * Buffers are reused once the backend has formatted their message. When
+   * all of them are in flight, a large message waits for one with
+   * OverflowPolicy::kBlock and is dropped otherwise.
+   * Default: 1MiB (1024 * 1024 bytes)
+   */
+  std::size_t large_message_pool_size = 1024 * 1024;
+
+  /**
+   * @brief How the SPSC queue memory is allocated.
+   *
+   * QueueMemory::kAligned: one cache-line aligned allocation. Entries that
+   * straddle the end of the ring take a slower, split copy.
+   * QueueMemory::kMirrored: the ring is mapped twice back to back (Linux,
+   * memfd_create), so every entry is contiguous and written and read in place.
+   * The size is rounded up to whole pages. Falls back to kAligned where
+   * unavailable.
+   * Default: QueueMemory::kAligned
+   */
+  QueueMemory queue_memory = QueueMemory::kAligned;
+
+  /**
+   * @brief How an idle backend worker waits for new entries.
+   *
+   * BackendWaitStrategy::kPolling: spin, then sleep in growing steps of up to
+   * 100us between polls. Keeps a core partly busy while idle, and the first
+   * message after a quiet period may wait for the current sleep to end.
+   * BackendWaitStrategy::kEventDriven: spin for backend_spin_iterations, then
+   * park on a futex until a producer signals. Producers only signal when the
+   * backend is parked, which costs them one flag check otherwise.
+   * Default: BackendWaitStrategy::kPolling
+   */
+  BackendWaitStrategy backend_wait_strategy = BackendWaitStrategy::kPolling;
+
+  /**
+   * @brief Empty polls before a BackendWaitStrategy::kEventDriven backend
+   * parks.
+   * Default: 2048
+   */
+  std::size_t backend_spin_iterations = 2048;
+
+  /**
+   * @brief Longest a parked backend sleeps without being signaled.
+   *
+   * Producers signal without a memory fence, so a signal racing with the
+   * backend going to sleep can be missed; this bounds the resulting delay.
+   * Default: 1000 (microseconds)
+   */
+  std::size_t backend_park_timeout_us = 1000;
+
+  /**
+   * @brief Longest time a line may wait in a sink's buffer while the backend
+   * is busy, in microseconds.
+   *
+   * The backend flushes its sinks whenever it has drained its queues, so lines
+   * logged at low rates are written right away. Under sustained load it keeps
+   * batching, and flushes once the oldest unflushed line is this old.
+   * Default: 5000 (5 milliseconds)
+   */
+  std::size_t sink_flush_latency_us = 5000;
 };
 
 constexpr FemtologOptions kFastOptions{
@@ -0,0 +1,523 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#ifndef INCLUDE_FEMTOLOG_SINKS_IO_URING_FILE_SINK_H_
+#define INCLUDE_FEMTOLOG_SINKS_IO_URING_FILE_SINK_H_
+
+#include "femtolog/build/build_flag.h"
+
+#if FEMTOLOG_HAS_IO_URING_HEADER
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+
+#endif
+
+// IORING_OP_WRITE is an enumerator, so the feature flag added with it in
+// Linux 5.6 tells whether the headers declare it.
+#if FEMTOLOG_HAS_IO_URING_HEADER && defined(IORING_FEAT_RW_CUR_POS) && \
+    defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define FEMTOLOG_HAS_IO_URING 1
+
+#else
+#define FEMTOLOG_HAS_IO_URING 0
+
+#endif
+
+#if FEMTOLOG_HAS_IO_URING
+
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "femtolog/base/log_entry.h"
+#include "femtolog/core/base/file_util.h"
+#include "femtolog/core/check.h"
+#include "femtolog/sinks/file_sink.h"
+#include "femtolog/sinks/layout.h"
+#include "femtolog/sinks/shared_file.h"
+#include "femtolog/sinks/sink_base.h"
+
+namespace femtolog {
+
+struct IoUringFileSinkOptions {
+  // Buffers the sink cycles through. It fills one while the kernel writes
+  // the others.
+  std::size_t buffer_count = 8;
+  // Bytes a buffer collects before it is submitted.
+  std::size_t buffer_size = 64 * 1024;
+  // Opens the file with O_DIRECT, so that writes bypass the page cache.
+  // Buffers are then copied to block aligned memory and written up to their
+  // last whole block, the rest being carried over to the next buffer. A
+  // flushed buffer is padded to whole blocks instead, so the buffer after it
+  // waits for that write, which its first block overwrites. The file is
+  // truncated to its real size when the sink is destroyed. Ignored if the
+  // file system does not support it.
+  bool direct_io = false;
+  // With direct_io, writes the kernel is given at a time, up to
+  // buffer_count. On ext4, concurrent O_DIRECT writes extending a file that
+  // another thread fsyncs stall dequeuing far longer than one at a time, as
+  // file_sink_bench shows, so only one is in flight by default.
+  std::size_t direct_writes_in_flight = 1;
+  // Writes buffers with pwrite() on the backend thread if false, as the sink
+  // does where io_uring is not available.
+  bool use_io_uring = true;
+};
+
+// Writes lines to a file like FileSink, but hands full buffers to an io_uring
+// instead of writing them on the backend thread, so that a stalling file
+// system does not hold up dequeuing until every buffer is in flight, or with
+// direct_io, until direct_writes_in_flight are. Buffers are reused as their
+// writes complete. Falls back to pwrite() where io_uring is not available.
+//
+// The sink owns its file and writes at explicit offsets, so it claims its path
+// in SharedFile's registry while it is open, and writes nothing if another
+// sink writes the path already. Like the other file sinks, it rotates the
+// file only the first time the path is opened in the process.
+// flush() submits the lines collected so far; wait_for_writes() waits until
+// they are written.
+class IoUringFileSink final : public SinkBase {
+ public:
+  using DefaultLayout = FileSink::DefaultLayout;
+
+  // Writes lines laid out by `layout`, or messages as they are if it is null.
+  explicit IoUringFileSink(
+      const std::string& file_path,
+      const LayoutFunctions* layout = DefaultLayout::functions(),
+      const IoUringFileSinkOptions& options = IoUringFileSinkOptions())
+      : slots_(std::max<std::size_t>(options.buffer_count, 2)),
+        buffer_size_(std::max(options.buffer_size, kBlockSize)),
+        direct_writes_in_flight_(std::clamp<std::size_t>(
+            options.direct_writes_in_flight, 1, slots_.size())) {
+    set_layout(layout);
+
+    if (!SharedFile::claim(file_path)) [[unlikely]] {
+      FEMTOLOG_DCHECK(false) << "another sink writes " << file_path << ".";
+      return;
+    }
+    claimed_path_ = file_path;
+    if (options.direct_io) {
+      fd_ = ::open(file_path.c_str(),
+                   O_WRONLY | O_CREAT | O_CLOEXEC | O_DIRECT, 0644);
+      // O_DIRECT writes cannot start in the middle of a block, as they would
+      // to append to a file an earlier sink left with a partial one.
+      if (fd_ >= 0 && lseek(fd_, 0, SEEK_END) % kBlockSize != 0) {
+        close(fd_);
+        fd_ = -1;
+      }
+      direct_io_ = fd_ >= 0;
+    }
+    if (fd_ < 0) {
+      fd_ = ::open(file_path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    }
+    // Appends to the file an earlier sink of the process left at the path.
+    const off_t size = fd_ >= 0 ? lseek(fd_, 0, SEEK_END) : 0;
+    offset_ = file_size_ = size > 0 ? static_cast<uint64_t>(size) : 0;
+
+    // Room for a full buffer and the message that fills it, so that messages
+    // up to buffer_size never make it grow.
+    for (Slot& slot : slots_) {
+      slot.lines.reserve(buffer_size_ * 2);
+    }
+    if (options.use_io_uring) {
+      setup_ring(static_cast<unsigned>(slots_.size()));
+    }
+  }
+
+  IoUringFileSink()
+      : IoUringFileSink(
+            core::join_path(core::exe_dir(), "logs", "latest.log")) {}
+
+  ~IoUringFileSink() override {
+    submit_current(true);
+    wait_for_writes();
+    if (direct_io_) {
+      [[maybe_unused]] const int result =
+          ftruncate(fd_, static_cast<off_t>(file_size_));
+    }
+    teardown_ring();
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+    if (!claimed_path_.empty()) {
+      SharedFile::release(claimed_path_);
+    }
+  }
+
+  inline void on_log(const LogEntry& entry,
+                     const char* content,
+                     std::size_t len) override {
+    slots_[current_].lines.append(content, content + len);
+    end_log(entry);
+  }
+
+  [[nodiscard]] inline bool has_log_buffer() const noexcept override {
+    return true;
+  }
+
+  inline fmt::memory_buffer* begin_log(const LogEntry&) override {
+    return &slots_[current_].lines;
+  }
+
+  inline void end_log(const LogEntry&) override {
+    if (slots_[current_].lines.size() >= buffer_size_) {
+      submit_current(false);
+    }
+  }
+
+  inline void flush() override {
+    submit_current(true);
+    if (ring_fd_ >= 0) {
+      reap_completions(false);
+    }
+  }
+
+  // Blocks until every submitted buffer has been written.
+  inline void wait_for_writes() {
+    for (Slot& slot : slots_) {
+      wait_for(&slot);
+    }
+  }
+
+  [[nodiscard]] inline bool uses_io_uring() const noexcept {
+    return ring_fd_ >= 0;
+  }
+  [[nodiscard]] inline bool uses_direct_io() const noexcept {
+    return direct_io_;
+  }
+
+ private:
+  struct AlignedDelete {
+    inline void operator()(char* memory) const noexcept {
+      ::operator delete(memory, std::align_val_t(kBlockSize));
+    }
+  };
+
+  struct Slot {
+    fmt::memory_buffer lines;
+    // Block aligned copy of `lines` for O_DIRECT.
+    std::unique_ptr<char, AlignedDelete> aligned;
+    std::size_t aligned_capacity = 0;
+
+    // The part of the buffer the kernel has yet to write.
+    bool in_flight = false;
+    const char* pending_data = nullptr;
+    std::size_t pending_size = 0;
+    uint64_t pending_offset = 0;
+  };
+
+  // Submits the buffer being filled and moves on to the next one. With
+  // O_DIRECT, its unfinished last block is written too, padded, only if
+  // `pad`; otherwise it is left for the next buffer to write.
+  void submit_current(bool pad) {
+    Slot& slot = slots_[current_];
+    const std::size_t size = slot.lines.size();
+    if (size == carried_size_ && (carried_written_ || !pad)) {
+      return;
+    }
+
+    const char* data = slot.lines.data();
+    std::size_t write_size = size;
+    std::size_t tail = 0;
+    if (direct_io_) {
+      tail = size % kBlockSize;
+      write_size = pad ? (size + kBlockSize - 1) & ~(kBlockSize - 1)
+                       : size - tail;
+      if (slot.aligned_capacity < write_size) {
+        slot.aligned.reset(static_cast<char*>(
+            ::operator new(write_size, std::align_val_t(kBlockSize))));
+        slot.aligned_capacity = write_size;
+      }
+      const std::size_t copy_size = std::min(size, write_size);
+      std::memcpy(slot.aligned.get(), data, copy_size);
+      std::memset(slot.aligned.get() + copy_size, 0, write_size - copy_size);
+      data = slot.aligned.get();
+
+      // This write starts with the block the previous one padded.
+      if (tail_slot_ != kNoSlot) {
+        wait_for(&slots_[tail_slot_]);
+        tail_slot_ = kNoSlot;
+      }
+      while (writes_in_flight() >= direct_writes_in_flight_) {
+        reap_completions(true);
+      }
+    }
+
+    if (write_size > 0) {
+      write_at(&slot, data, write_size, offset_);
+    }
+    if (direct_io_) {
+      file_size_ = offset_ + size;
+      offset_ += size - tail;
+      if (pad && tail != 0) {
+        tail_slot_ = current_;
+      }
+      carried_written_ = pad || tail == 0;
+    } else {
+      offset_ += size;
+    }
+
+    const std::size_t previous = current_;
+    current_ = (current_ + 1) % slots_.size();
+    Slot& next = slots_[current_];
+    wait_for(&next);
+    next.lines.clear();
+    // An unfinished block is written, or written again, with the lines that
+    // complete it.
+    const char* lines = slots_[previous].lines.data();
+    next.lines.append(lines + size - tail, lines + size);
+    carried_size_ = tail;
+  }
+
+  [[nodiscard]] inline std::size_t writes_in_flight() const noexcept {
+    return static_cast<std::size_t>(
+        std::count_if(slots_.begin(), slots_.end(),
+                      [](const Slot& slot) { return slot.in_flight; }));
+  }
+
+  void write_at(Slot* slot,
+                const char* data,
+                std::size_t size,
+                uint64_t offset) {
+    if (ring_fd_ < 0) [[unlikely]] {
+      pwrite_all(data, size, offset);
+      return;
+    }
+
+    // Entries are submitted one at a time, and taken back below if the kernel
+    // does not consume one, so the queue always has room for one more.
+    const unsigned tail = *sq_tail_;
+    const unsigned index = tail & *sq_mask_;
+    io_uring_sqe* sqe = &sqes_[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->fd = fd_;
+    sqe->addr = reinterpret_cast<uint64_t>(data);
+    sqe->len = static_cast<uint32_t>(size);
+    sqe->off = offset;
+    sqe->user_data = static_cast<uint64_t>(slot - slots_.data());
+    sq_array_[index] = index;
+    std::atomic_ref<unsigned>(*sq_tail_).store(tail + 1,
+                                               std::memory_order_release);
+
+    // Submission fails without consuming the entry if the kernel is short of
+    // memory or busy; it is then retried a few times before the buffer is
+    // written on this thread instead.
+    for (int attempt = 0; attempt < kSubmitAttempts; ++attempt) {
+      const int result = enter(1, 0, 0);
+      if (result > 0 ||
+          std::atomic_ref<unsigned>(*sq_head_).load(
+              std::memory_order_acquire) != tail) {
+        slot->in_flight = true;
+        slot->pending_data = data;
+        slot->pending_size = size;
+        slot->pending_offset = offset;
+        return;
+      }
+      if (result != -EAGAIN && result != -EBUSY && result != -ENOMEM) {
+        break;
+      }
+      sched_yield();
+    }
+
+    // Without SQPOLL the kernel only reads the queue in io_uring_enter(), so
+    // the entry can be taken back.
+    std::atomic_ref<unsigned>(*sq_tail_).store(tail,
+                                               std::memory_order_release);
+    pwrite_all(data, size, offset);
+  }
+
+  void pwrite_all(const char* data, std::size_t size, uint64_t offset) {
+    while (size > 0) {
+      const ssize_t written =
+          pwrite(fd_, data, size, static_cast<off_t>(offset));
+      if (written <= 0) {
+        return;
+      }
+      data += written;
+      size -= static_cast<std::size_t>(written);
+      offset += static_cast<uint64_t>(written);
+    }
+  }
+
+  inline void wait_for(Slot* slot) {
+    while (slot->in_flight) {
+      reap_completions(true);
+    }
+  }
+
+  // Marks the buffers whose writes completed as free, waiting for at least
+  // one completion if `wait`.
+  void reap_completions(bool wait) {
+    unsigned head = *cq_head_;
+    unsigned tail =
+        std::atomic_ref<unsigned>(*cq_tail_).load(std::memory_order_acquire);
+    while (head == tail) {
+      if (!wait) {
+        return;
+      }
+      enter(0, 1, IORING_ENTER_GETEVENTS);
+      tail =
+          std::atomic_ref<unsigned>(*cq_tail_).load(std::memory_order_acquire);
+    }
+
+    for (; head != tail; ++head) {
+      const io_uring_cqe& cqe = cqes_[head & *cq_mask_];
+      Slot& slot = slots_[cqe.user_data];
+      slot.in_flight = false;
+      const std::size_t written = cqe.res > 0 ? cqe.res : 0;
+      // Writes are dropped on errors, as by the other sinks.
+      if (written > 0 && written < slot.pending_size) [[unlikely]] {
+        std::atomic_ref<unsigned>(*cq_head_).store(head + 1,
+                                                   std::memory_order_release);
+        write_at(&slot, slot.pending_data + written,
+                 slot.pending_size - written, slot.pending_offset + written);
+      }
+    }
+    std::atomic_ref<unsigned>(*cq_head_).store(head, std::memory_order_release);
+  }
+
+  // Returns the number of entries submitted, or the negated error.
+  inline int enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+    while (true) {
+      const long result = syscall(__NR_io_uring_enter, ring_fd_, to_submit,
+                                  min_complete, flags, nullptr, 0);
+      if (result >= 0) {
+        return static_cast<int>(result);
+      }
+      if (errno != EINTR) {
+        return -errno;
+      }
+    }
+  }
+
+  void setup_ring(unsigned entries) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    const int ring_fd =
+        static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (ring_fd < 0) {
+      // Disabled or unsupported; write on the backend thread instead.
+      return;
+    }
+    // Added along with IORING_OP_WRITE in Linux 5.6.
+    if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+      close(ring_fd);
+      return;
+    }
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ =
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+      sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    cq_ring_ = single_mmap
+                   ? sq_ring_
+                   : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, ring_fd,
+                          IORING_OFF_CQ_RING);
+    void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+    ring_fd_ = ring_fd;
+    if (sq_ring_ == MAP_FAILED || cq_ring_ == MAP_FAILED ||
+        sqes == MAP_FAILED) [[unlikely]] {
+      sqes_ = static_cast<io_uring_sqe*>(sqes);
+      teardown_ring();
+      return;
+    }
+
+    char* sq = static_cast<char*>(sq_ring_);
+    char* cq = static_cast<char*>(cq_ring_);
+    sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+  }
+
+  void teardown_ring() {
+    if (ring_fd_ < 0) {
+      return;
+    }
+    if (sqes_ && sqes_ != MAP_FAILED) {
+      munmap(sqes_, sqes_size_);
+    }
+    if (cq_ring_ != sq_ring_ && cq_ring_ && cq_ring_ != MAP_FAILED) {
+      munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_ && sq_ring_ != MAP_FAILED) {
+      munmap(sq_ring_, sq_ring_size_);
+    }
+    close(ring_fd_);
+    ring_fd_ = -1;
+  }
+
+  static constexpr std::size_t kBlockSize = 4096;
+  static constexpr std::size_t kNoSlot = static_cast<std::size_t>(-1);
+  static constexpr int kSubmitAttempts = 4;
+
+  int fd_ = -1;
+  bool direct_io_ = false;
+  // Empty if the path was claimed by another sink.
+  std::string claimed_path_;
+
+  std::vector<Slot> slots_;
+  // The buffer lines are appended to; submitted once it holds buffer_size_
+  // bytes or more.
+  std::size_t current_ = 0;
+  std::size_t buffer_size_;
+  std::size_t direct_writes_in_flight_;
+
+  // Where the next buffer is written. With O_DIRECT, the buffer being filled
+  // starts with the `carried_size_` bytes of an unfinished block, which the
+  // buffer of `tail_slot_` wrote padded if it was flushed.
+  uint64_t offset_ = 0;
+  uint64_t file_size_ = 0;
+  std::size_t carried_size_ = 0;
+  bool carried_written_ = true;
+  std::size_t tail_slot_ = kNoSlot;
+
+  int ring_fd_ = -1;
+  void* sq_ring_ = nullptr;
+  void* cq_ring_ = nullptr;
+  std::size_t sq_ring_size_ = 0;
+  std::size_t cq_ring_size_ = 0;
+  std::size_t sqes_size_ = 0;
+  unsigned* sq_head_ = nullptr;
+  unsigned* sq_tail_ = nullptr;
+  unsigned* sq_mask_ = nullptr;
+  unsigned* sq_array_ = nullptr;
+  io_uring_sqe* sqes_ = nullptr;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  unsigned* cq_mask_ = nullptr;
+  io_uring_cqe* cqes_ = nullptr;
+};
+
+}  // namespace femtolog
+
+#endif  // FEMTOLOG_HAS_IO_URING
+
+#endif  // INCLUDE_FEMTOLOG_SINKS_IO_URING_FILE_SINK_H_
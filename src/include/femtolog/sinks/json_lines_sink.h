@@ -5,85 +5,30 @@
 #ifndef INCLUDE_FEMTOLOG_SINKS_JSON_LINES_SINK_H_
 #define INCLUDE_FEMTOLOG_SINKS_JSON_LINES_SINK_H_
 
-#include <fcntl.h>
-
 #include <memory>
 #include <string>
 
 #include "femtolog/base/log_entry.h"
-#include "femtolog/base/log_level.h"
-#include "femtolog/build/build_flag.h"
 #include "femtolog/core/base/file_util.h"
+#include "femtolog/sinks/layout.h"
+#include "femtolog/sinks/shared_file.h"
 #include "femtolog/sinks/sink_base.h"
 
-#if FEMTOLOG_IS_WINDOWS
-#include <io.h>
-#include <windows.h>
-#else
-#include <sys/uio.h>
-#include <unistd.h>
-#endif
-
 namespace femtolog {
 
 template <bool enable_buffering = true>
 class JsonLinesSink final : public SinkBase {
  public:
-  explicit JsonLinesSink(const std::string& file_path) : file_path_(file_path) {
-    std::string parent_dir = core::parent_dir(file_path_);
-    if (!core::dir_exists(parent_dir.c_str())) {
-      core::create_directories(parent_dir.c_str());
-    }
-
-    if (core::file_exists(file_path_.c_str())) {
-      constexpr std::size_t kTimestampBufSize = 32;
-      char timestamp_buf[kTimestampBufSize];
-      std::size_t timestamp_size =
-          format_timestamp<TimeZone::kLocal, "{:%Y-%m-%d_%H-%M-%S}">(
-              timestamp_ns(), timestamp_buf, kTimestampBufSize);
-      std::string base_timestamp_name(timestamp_buf, timestamp_size);
-
-      std::string original_file_name_without_ext =
-          core::file_name_without_extension(file_path_);
-      std::string original_extension = core::file_extension(file_path_);
-
-      int counter = 0;
-      std::string compressed_file_name;
-      std::string dest_path;
-
-      do {
-        compressed_file_name = original_file_name_without_ext;
-        compressed_file_name.append("_");
-        compressed_file_name.append(base_timestamp_name);
-
-        if (counter > 0) {
-          compressed_file_name.append("-");
-          compressed_file_name.append(std::to_string(counter));
-        }
-
-        compressed_file_name.append(".");
-        compressed_file_name.append(original_extension);
-        compressed_file_name.append(".gz");
-
-        dest_path = core::join_path(parent_dir, compressed_file_name);
-        counter++;
-      } while (core::file_exists(dest_path.c_str()));
-
-      core::compress(file_path_.c_str(), dest_path.c_str(), true);
-    }
-    core::create_file(file_path_.c_str());
-
-#if FEMTOLOG_IS_WINDOWS
-    fd_ =
-        _open(file_path_.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY,
-              _S_IREAD | _S_IWRITE);
-#else
-    fd_ = open(file_path_.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
-#endif
-
-    if constexpr (enable_buffering) {
-      buffer_ = std::make_unique<char[]>(kBufferCapacity);
-    }
+  using DefaultLayout =
+      Layout<R"({{"timestamp": {time_ns}, "level": "{level}", )"
+             R"("message": "{msg:json}"}})"
+             "\n">;
+
+  explicit JsonLinesSink(
+      const std::string& file_path,
+      const LayoutFunctions* layout = DefaultLayout::functions())
+      : file_(SharedFile::open(file_path)) {
+    set_layout(layout);
   }
 
   JsonLinesSink()
@@ -91,87 +36,41 @@ class JsonLinesSink final : public SinkBase {
             core::join_path(core::exe_dir(), "logs", "jsonl", "latest.jsonl")) {
   }
 
-  ~JsonLinesSink() override {
-    if constexpr (enable_buffering) {
-      flush();
-    }
-
-    if (fd_ >= 0) {
-#if FEMTOLOG_IS_WINDOWS
-      _close(fd_);
-#else
-      close(fd_);
-#endif
-    }
-  }
+  ~JsonLinesSink() override { flush(); }
 
-  inline void on_log(const LogEntry& entry,
+  inline void on_log(const LogEntry&,
                      const char* content,
                      std::size_t len) override {
-    // Pre-format JSON line
-    char line[kMaxJsonLineSize];
-    const char* level_str = log_level_to_lower_str(entry.level);
-    std::string encoded = core::encode_escape(content, len);
-    auto result = fmt::format_to_n(
-        line, kMaxJsonLineSize,
-        R"({{"timestamp": {}, "level": "{}", "message": "{}"}})"
-        "\n",
-        entry.timestamp_ns, level_str, fmt::string_view(encoded));
-    std::size_t line_len = result.size;
-
+    file_->append(content, len);
     if constexpr (!enable_buffering) {
-      write_raw(line, line_len);
-      return;
-    }
-
-    if (cursor_ + line_len > kBufferCapacity) {
       flush();
     }
+  }
 
-    if (line_len > kBufferCapacity) {
-      write_raw(line, line_len);
-      return;
-    }
-
-    std::memcpy(buffer_.get() + cursor_, line, line_len);
-    cursor_ += line_len;
+  [[nodiscard]] inline bool has_log_buffer() const noexcept override {
+    return true;
   }
 
- private:
-  inline void flush() {
-    if constexpr (enable_buffering) {
-      if (cursor_ == 0 || !buffer_ || fd_ < 0) {
-        return;
-      }
-#if FEMTOLOG_IS_WINDOWS
-      _write(fd_, buffer_.get(), static_cast<uint32_t>(cursor_));
-#else
-      const auto _ = write(fd_, buffer_.get(), cursor_);
-#endif
-      cursor_ = 0;
-    }
+  // Lines are laid out straight into the buffer of the file, which stays
+  // locked until end_log().
+  inline fmt::memory_buffer* begin_log(const LogEntry&) override {
+    return file_->begin_append();
   }
 
-  inline void write_raw(const char* data, std::size_t size) {
-    if (fd_ < 0) {
-      return;
+  // Unbuffered sinks write every line as it is logged.
+  inline void end_log(const LogEntry&) override {
+    file_->end_append();
+    if constexpr (!enable_buffering) {
+      flush();
     }
-
-#if FEMTOLOG_IS_WINDOWS
-    _write(fd_, data, static_cast<uint32_t>(size));
-#else
-    const auto _ = write(fd_, data, size);
-#endif
   }
 
-  int fd_ = -1;
-
-  std::string file_path_;
-  std::unique_ptr<char[]> buffer_;
-  std::size_t cursor_ = 0;
+  inline void flush() override { file_->flush(); }
 
-  static constexpr std::size_t kBufferCapacity = 8192;
-  static constexpr std::size_t kMaxJsonLineSize = 2048;
+ private:
+  // Shared with every other sink writing to the same path, which buffers the
+  // lines of all of them.
+  std::shared_ptr<SharedFile> file_;
 };
 
 }  // namespace femtolog
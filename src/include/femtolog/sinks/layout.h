@@ -0,0 +1,518 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#ifndef INCLUDE_FEMTOLOG_SINKS_LAYOUT_H_
+#define INCLUDE_FEMTOLOG_SINKS_LAYOUT_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <string_view>
+#include <utility>
+
+#include "femtolog/base/format_util.h"
+#include "femtolog/base/log_entry.h"
+#include "femtolog/base/log_level.h"
+#include "femtolog/build/build_flag.h"
+#include "femtolog/core/base/string_util.h"
+#include "fmt/format.h"
+
+namespace femtolog {
+
+enum class TimeZone : uint8_t {
+  kUtc = 0,
+  kLocal = 1,
+};
+
+struct LayoutOptions {
+  TimeZone time_zone = TimeZone::kLocal;
+  // Whether {level:color} writes ANSI colour sequences around the level.
+  bool color = false;
+  // Whether entries logged at LogLevel::kRaw are written as the bare message.
+  bool bare_raw = false;
+};
+
+// A Layout with its type erased, for the backend. Sinks of the same layout
+// share the same instance, so the backend renders their lines once.
+struct LayoutFunctions {
+  using FormatFunction = void (*)(const LogEntry&, fmt::memory_buffer*);
+  using EscapeFunction = void (*)(const char*,
+                                  std::size_t,
+                                  fmt::memory_buffer*);
+
+  // Append what goes before and after the message.
+  FormatFunction format_prefix;
+  FormatFunction format_suffix;
+  // Appends the message escaped, or null if it goes in verbatim.
+  EscapeFunction escape_message;
+
+  // Appends the whole line for the message `content` of `entry` to `out`.
+  inline void format_line(const LogEntry& entry,
+                          const char* content,
+                          std::size_t len,
+                          fmt::memory_buffer* out) const {
+    format_prefix(entry, out);
+    if (escape_message) {
+      escape_message(content, len, out);
+    } else {
+      out->append(content, content + len);
+    }
+    format_suffix(entry, out);
+  }
+};
+
+// Appends `content` escaped for a JSON string.
+inline void append_json_escaped(const char* content,
+                                std::size_t len,
+                                fmt::memory_buffer* out) {
+  constexpr char kHexDigits[] = "0123456789abcdef";
+  const char* end = content + len;
+  const char* run = content;
+  for (const char* pos = content; pos != end; ++pos) {
+    const unsigned char c = static_cast<unsigned char>(*pos);
+    if (c >= 0x20 && c != '"' && c != '\\') [[likely]] {
+      continue;
+    }
+    out->append(run, pos);
+    run = pos + 1;
+    switch (c) {
+      case '"': out->append(std::string_view("\\\"")); break;
+      case '\\': out->append(std::string_view("\\\\")); break;
+      case '\n': out->append(std::string_view("\\n")); break;
+      case '\r': out->append(std::string_view("\\r")); break;
+      case '\t': out->append(std::string_view("\\t")); break;
+      default: {
+        const char escaped[] = {'\\', 'u', '0', '0', kHexDigits[c >> 4],
+                                kHexDigits[c & 0xf]};
+        out->append(escaped, escaped + sizeof(escaped));
+        break;
+      }
+    }
+  }
+  out->append(run, end);
+}
+
+enum class LayoutStepKind : uint8_t {
+  kText,
+  kYear,
+  kMonth,
+  kDay,
+  kHour,
+  kMinute,
+  kSecond,
+  // `size` digits of the fraction of the second.
+  kFraction,
+  kTimeNs,
+  kLevel,
+  kLevelColor,
+  kThreadId,
+  kMessage,
+  kJsonMessage,
+  // A run of calendar and text steps, which only change once a second.
+  // `offset` is the first of them in ParsedLayout::calendar_steps and `size`
+  // their count.
+  kCalendar,
+};
+
+constexpr bool is_calendar_step(LayoutStepKind kind) {
+  switch (kind) {
+    case LayoutStepKind::kYear:
+    case LayoutStepKind::kMonth:
+    case LayoutStepKind::kDay:
+    case LayoutStepKind::kHour:
+    case LayoutStepKind::kMinute:
+    case LayoutStepKind::kSecond: return true;
+    default: return false;
+  }
+}
+
+struct LayoutStep {
+  LayoutStepKind kind = LayoutStepKind::kText;
+  // The text of kText steps, in ParsedLayout::text.
+  uint16_t offset = 0;
+  uint16_t size = 0;
+};
+
+template <std::size_t N>
+struct ParsedLayout {
+  // Steps and text take at most a character of the pattern each, but for
+  // those of the default time spec.
+  static constexpr std::size_t kCapacity = N + 8;
+
+  std::array<LayoutStep, kCapacity> steps{};
+  std::size_t step_count = 0;
+  // Literal text with the braces unescaped.
+  std::array<char, kCapacity> text{};
+  std::size_t text_size = 0;
+  std::size_t message_step = 0;
+  bool has_message = false;
+  // The steps of kCalendar runs.
+  std::array<LayoutStep, kCapacity> calendar_steps{};
+  std::size_t calendar_step_count = 0;
+
+  consteval void add_text(char c) {
+    if (step_count == 0 ||
+        steps[step_count - 1].kind != LayoutStepKind::kText) {
+      steps[step_count++] = {LayoutStepKind::kText,
+                             static_cast<uint16_t>(text_size), 0};
+    }
+    text[text_size++] = c;
+    steps[step_count - 1].size++;
+  }
+
+  consteval void add_step(LayoutStepKind kind, uint16_t size = 0) {
+    if (kind == LayoutStepKind::kMessage ||
+        kind == LayoutStepKind::kJsonMessage) {
+      if (has_message) {
+        throw "a layout can only contain {msg} once.";
+      }
+      has_message = true;
+      message_step = step_count;
+    }
+    steps[step_count++] = {kind, 0, size};
+  }
+
+  // strftime-like: %Y %m %d %H %M %S, %3 %6 %9 for the fraction of the second
+  // and %% for '%'.
+  consteval void parse_time_spec(std::string_view spec) {
+    for (std::size_t i = 0; i < spec.size(); ++i) {
+      if (spec[i] != '%') {
+        add_text(spec[i]);
+        continue;
+      }
+      if (++i == spec.size()) {
+        throw "a time spec ends with '%'.";
+      }
+      switch (spec[i]) {
+        case 'Y': add_step(LayoutStepKind::kYear); break;
+        case 'm': add_step(LayoutStepKind::kMonth); break;
+        case 'd': add_step(LayoutStepKind::kDay); break;
+        case 'H': add_step(LayoutStepKind::kHour); break;
+        case 'M': add_step(LayoutStepKind::kMinute); break;
+        case 'S': add_step(LayoutStepKind::kSecond); break;
+        case '3': add_step(LayoutStepKind::kFraction, 3); break;
+        case '6': add_step(LayoutStepKind::kFraction, 6); break;
+        case '9': add_step(LayoutStepKind::kFraction, 9); break;
+        case '%': add_text('%'); break;
+        default: throw "unsupported conversion in a time spec.";
+      }
+    }
+  }
+
+  // Replaces each calendar step and the text and calendar steps after it with
+  // a kCalendar step.
+  consteval void group_calendar_runs() {
+    std::array<LayoutStep, kCapacity> grouped{};
+    std::size_t grouped_count = 0;
+    for (std::size_t i = 0; i < step_count;) {
+      if (!is_calendar_step(steps[i].kind)) {
+        if (i == message_step) {
+          message_step = grouped_count;
+        }
+        grouped[grouped_count++] = steps[i++];
+        continue;
+      }
+      LayoutStep run = {LayoutStepKind::kCalendar,
+                        static_cast<uint16_t>(calendar_step_count), 0};
+      while (i < step_count && (is_calendar_step(steps[i].kind) ||
+                                steps[i].kind == LayoutStepKind::kText)) {
+        calendar_steps[calendar_step_count++] = steps[i++];
+        run.size++;
+      }
+      grouped[grouped_count++] = run;
+    }
+    steps = grouped;
+    step_count = grouped_count;
+  }
+
+  // Characters the kCalendar step `run` renders.
+  consteval std::size_t calendar_size(const LayoutStep& run) const {
+    std::size_t size = 0;
+    for (std::size_t i = run.offset; i < run.offset + run.size; ++i) {
+      const LayoutStep& step = calendar_steps[i];
+      size += step.kind == LayoutStepKind::kText   ? step.size
+              : step.kind == LayoutStepKind::kYear ? 4
+                                                   : 2;
+    }
+    return size;
+  }
+
+  consteval void parse_field(std::string_view field) {
+    if (field == "time") {
+      parse_time_spec("%H:%M:%S.%9");
+    } else if (field.starts_with("time:")) {
+      parse_time_spec(field.substr(5));
+    } else if (field == "time_ns") {
+      add_step(LayoutStepKind::kTimeNs);
+    } else if (field == "level") {
+      add_step(LayoutStepKind::kLevel);
+    } else if (field == "level:color") {
+      add_step(LayoutStepKind::kLevelColor);
+    } else if (field == "tid") {
+      add_step(LayoutStepKind::kThreadId);
+    } else if (field == "msg") {
+      add_step(LayoutStepKind::kMessage);
+    } else if (field == "msg:json") {
+      add_step(LayoutStepKind::kJsonMessage);
+    } else {
+      throw "unknown layout field.";
+    }
+  }
+};
+
+// Parses a layout pattern at compile time. Fields are written in braces, and
+// "{{" and "}}" stand for literal braces:
+//
+//   {time} or {time:<spec>}  the timestamp, "%H:%M:%S.%9" by default
+//   {time_ns}                nanoseconds since the epoch
+//   {level}, {level:color}   the level, optionally in its colour
+//   {tid}                    the id of the logging thread
+//   {msg}, {msg:json}        the message, optionally escaped for JSON
+template <std::size_t N>
+consteval ParsedLayout<N> parse_layout(const FixedString<N>& pattern) {
+  ParsedLayout<N> parsed;
+  const std::string_view view(pattern.data, pattern.size);
+  for (std::size_t i = 0; i < view.size(); ++i) {
+    const char c = view[i];
+    if (c == '{' && i + 1 < view.size() && view[i + 1] == '{') {
+      parsed.add_text('{');
+      ++i;
+    } else if (c == '}' && i + 1 < view.size() && view[i + 1] == '}') {
+      parsed.add_text('}');
+      ++i;
+    } else if (c == '{') {
+      const std::size_t end = view.find('}', i);
+      if (end == std::string_view::npos) {
+        throw "unterminated layout field.";
+      }
+      parsed.parse_field(view.substr(i + 1, end - i - 1));
+      i = end;
+    } else if (c == '}') {
+      throw "unmatched '}' in a layout.";
+    } else {
+      parsed.add_text(c);
+    }
+  }
+  if (!parsed.has_message) {
+    throw "a layout must contain {msg}.";
+  }
+  parsed.group_calendar_runs();
+  return parsed;
+}
+
+// Two-digit strings "00" to "99", back to back.
+inline constexpr std::array<char, 200> kDigitPairs = []() {
+  std::array<char, 200> pairs{};
+  for (std::size_t i = 0; i < 100; ++i) {
+    pairs[i * 2] = static_cast<char>('0' + i / 10);
+    pairs[i * 2 + 1] = static_cast<char>('0' + i % 10);
+  }
+  return pairs;
+}();
+
+// Writes the `width` low decimal digits of `value` to `dst`, zero-padded. The
+// width is known at compile time, so this unrolls into a fixed sequence of
+// divisions by constants and copies from kDigitPairs, without a branch on the
+// value. Groups of four digits are independent of each other.
+template <std::size_t width>
+[[gnu::always_inline]] inline void write_digits(char* dst, uint64_t value) {
+  if constexpr (width > 4) {
+    write_digits<width - 4>(dst, value / 10000);
+    write_digits<4>(dst + width - 4, value % 10000);
+  } else {
+    if constexpr (width >= 2) {
+      std::memcpy(dst + width - 2, &kDigitPairs[value % 100 * 2], 2);
+    }
+    if constexpr (width == 4) {
+      std::memcpy(dst, &kDigitPairs[value / 100 % 100 * 2], 2);
+    } else if constexpr (width == 3) {
+      dst[0] = static_cast<char>('0' + value / 100 % 10);
+    } else if constexpr (width == 1) {
+      dst[0] = static_cast<char>('0' + value % 10);
+    }
+  }
+}
+
+// Lays out log lines after `pattern`, e.g.
+//
+//   Layout<"[{time:%H:%M:%S.%9}] {level} {tid}: {msg}">
+//
+// The pattern is parsed at compile time into the fixed sequence of copies and
+// renderers that make up the text before and after the message, so nothing
+// is parsed or looked up per entry. Calendar fields and the text between them
+// are cached per thread for the current second. Sinks take a layout as
+// functions().
+template <FixedString pattern, LayoutOptions options = LayoutOptions{}>
+class Layout {
+ public:
+  static void format_prefix(const LogEntry& entry, fmt::memory_buffer* out) {
+    format_steps<0>(entry, out,
+                    std::make_index_sequence<kParsed.message_step>());
+  }
+
+  static void format_suffix(const LogEntry& entry, fmt::memory_buffer* out) {
+    format_steps<kParsed.message_step + 1>(
+        entry, out,
+        std::make_index_sequence<kParsed.step_count - kParsed.message_step -
+                                 1>());
+  }
+
+  [[nodiscard]] static constexpr const LayoutFunctions* functions() noexcept {
+    return &kFunctions;
+  }
+
+ private:
+  static constexpr ParsedLayout<pattern.size> kParsed = parse_layout(pattern);
+
+  static constexpr LayoutFunctions kFunctions = {
+      &format_prefix,
+      &format_suffix,
+      kParsed.steps[kParsed.message_step].kind == LayoutStepKind::kJsonMessage
+          ? &append_json_escaped
+          : nullptr,
+  };
+
+  // The text of a kCalendar run as of `second`.
+  template <std::size_t size>
+  struct CalendarCache {
+    uint64_t second = ~uint64_t{0};
+    std::array<char, size> text;
+  };
+
+  template <std::size_t begin, std::size_t... i>
+  static void format_steps(const LogEntry& entry,
+                           [[maybe_unused]] fmt::memory_buffer* out,
+                           std::index_sequence<i...>) {
+    if constexpr (options.bare_raw) {
+      if (entry.level == LogLevel::kRaw) {
+        return;
+      }
+    }
+    (format_step<kParsed.steps[begin + i]>(entry, out), ...);
+  }
+
+  // Appends `size` bytes written by `write` to `out`.
+  template <std::size_t size, typename Write>
+  [[gnu::always_inline]] static inline void append_fixed(
+      fmt::memory_buffer* out,
+      Write write) {
+    const std::size_t begin = out->size();
+    out->resize(begin + size);
+    write(out->data() + begin);
+  }
+
+  template <LayoutStep step>
+  [[gnu::always_inline]] static inline void format_step(
+      const LogEntry& entry,
+      fmt::memory_buffer* out) {
+    using enum LayoutStepKind;
+    if constexpr (step.kind == kText) {
+      append_fixed<step.size>(out, [](char* dst) {
+        std::memcpy(dst, kParsed.text.data() + step.offset, step.size);
+      });
+    } else if constexpr (step.kind == kCalendar) {
+      // Calendar fields are rendered once a second and copied until then,
+      // which also keeps localtime_r() and its lock off the per-entry path.
+      constexpr std::size_t kSize = kParsed.calendar_size(step);
+      static thread_local CalendarCache<kSize> cache;
+      const uint64_t second = entry.timestamp_ns / 1'000'000'000;
+      if (second != cache.second) [[unlikely]] {
+        render_calendar<step>(second, cache.text.data(),
+                              std::make_index_sequence<step.size>());
+        cache.second = second;
+      }
+      append_fixed<kSize>(out, [](char* dst) {
+        std::memcpy(dst, cache.text.data(), kSize);
+      });
+    } else if constexpr (step.kind == kFraction) {
+      constexpr uint64_t kDivisor = step.size == 3   ? 1'000'000
+                                    : step.size == 6 ? 1'000
+                                                     : 1;
+      const uint64_t fraction = entry.timestamp_ns % 1'000'000'000 / kDivisor;
+      append_fixed<step.size>(out, [fraction](char* dst) {
+        write_digits<step.size>(dst, fraction);
+      });
+    } else if constexpr (step.kind == kTimeNs) {
+      const fmt::format_int digits(entry.timestamp_ns);
+      out->append(digits.data(), digits.data() + digits.size());
+    } else if constexpr (step.kind == kLevel ||
+                         (step.kind == kLevelColor && !options.color)) {
+      const char* level = log_level_to_lower_str(entry.level);
+      out->append(level, level + level_len(entry.level));
+    } else if constexpr (step.kind == kLevelColor) {
+      const std::string_view bold(core::kBold);
+      const std::string_view reset(core::kReset);
+      const char* color = log_level_to_ansi_color(entry.level);
+      const char* level = log_level_to_lower_str(entry.level);
+      out->append(bold);
+      out->append(color, color + level_ansi_len(entry.level));
+      out->append(level, level + level_len(entry.level));
+      out->append(reset);
+    } else if constexpr (step.kind == kThreadId) {
+      const fmt::format_int digits(entry.thread_id);
+      out->append(digits.data(), digits.data() + digits.size());
+    } else {
+      static_assert(step.kind == kText, "the message is not in a part.");
+    }
+  }
+
+  template <LayoutStep run, std::size_t... i>
+  FEMTOLOG_NO_INLINE static void render_calendar(uint64_t second,
+                                                 char* dst,
+                                                 std::index_sequence<i...>) {
+    const time_t seconds = static_cast<time_t>(second);
+    std::tm tm;
+    if constexpr (options.time_zone == TimeZone::kUtc) {
+#if FEMTOLOG_IS_WINDOWS
+      gmtime_s(&tm, &seconds);
+#else
+      gmtime_r(&seconds, &tm);
+#endif
+    } else {
+#if FEMTOLOG_IS_WINDOWS
+      localtime_s(&tm, &seconds);
+#else
+      localtime_r(&seconds, &tm);
+#endif
+    }
+    (render_calendar_step<kParsed.calendar_steps[run.offset + i]>(tm, &dst),
+     ...);
+  }
+
+  template <LayoutStep step>
+  [[gnu::always_inline]] static inline void render_calendar_step(
+      const std::tm& tm,
+      char** dst) {
+    using enum LayoutStepKind;
+    if constexpr (step.kind == kText) {
+      std::memcpy(*dst, kParsed.text.data() + step.offset, step.size);
+      *dst += step.size;
+    } else if constexpr (step.kind == kYear) {
+      write_digits<4>(*dst, static_cast<uint64_t>(tm.tm_year + 1900));
+      *dst += 4;
+    } else {
+      int value;
+      if constexpr (step.kind == kMonth) {
+        value = tm.tm_mon + 1;
+      } else if constexpr (step.kind == kDay) {
+        value = tm.tm_mday;
+      } else if constexpr (step.kind == kHour) {
+        value = tm.tm_hour;
+      } else if constexpr (step.kind == kMinute) {
+        value = tm.tm_min;
+      } else {
+        static_assert(step.kind == kSecond, "not a calendar step.");
+        value = tm.tm_sec;
+      }
+      write_digits<2>(*dst, static_cast<uint64_t>(value));
+      *dst += 2;
+    }
+  }
+};
+
+}  // namespace femtolog
+
+#endif  // INCLUDE_FEMTOLOG_SINKS_LAYOUT_H_
@@ -0,0 +1,348 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#ifndef INCLUDE_FEMTOLOG_SINKS_SHARED_FILE_H_
+#define INCLUDE_FEMTOLOG_SINKS_SHARED_FILE_H_
+
+#include <fcntl.h>
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "femtolog/base/format_util.h"
+#include "femtolog/build/build_flag.h"
+#include "femtolog/core/base/file_util.h"
+#include "femtolog/core/check.h"
+#include "femtolog/sinks/sink_base.h"
+#include "fmt/format.h"
+
+#if FEMTOLOG_IS_WINDOWS
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace femtolog {
+
+// A log file opened once per path and shared by every sink writing to it,
+// including the sinks of other threads' loggers. The first time a path is
+// opened in the process, the file a previous run left there is rotated into a
+// gzip archive; sinks opening it later get the same instance, or append to it
+// once it has been closed.
+//
+// Sinks append whole lines to one buffer of the file, so lines of different
+// backends never interleave, and every backend's lines are written together.
+// One backend at a time writes the buffer out; the others keep appending to a
+// second buffer meanwhile, and only wait for it once that one grows past
+// kMaxBufferSize.
+//
+// Sinks writing a file through their own descriptor claim its path instead,
+// which fails while it is open or claimed by any other sink.
+//
+// Paths are compared as given, so a file must be named the same way by every
+// sink that shares it. The file is closed with the last sink holding it, and
+// the lines still buffered are written then.
+class SharedFile {
+ public:
+  SharedFile(const SharedFile&) = delete;
+  SharedFile& operator=(const SharedFile&) = delete;
+
+  SharedFile(SharedFile&&) noexcept = delete;
+  SharedFile& operator=(SharedFile&&) noexcept = delete;
+
+  ~SharedFile() {
+    {
+      Registry& files = registry();
+      std::lock_guard<std::mutex> lock(files.mutex);
+      const auto it = files.open_files.find(path_);
+      // A sink may have reopened the path since the last reference was
+      // dropped.
+      if (it != files.open_files.end() && it->second.expired()) {
+        files.open_files.erase(it);
+      }
+    }
+
+    if (fd_ >= 0) {
+      write_all(appending_->data(), appending_->size());
+#if FEMTOLOG_IS_WINDOWS
+      _close(fd_);
+#else
+      close(fd_);
+#endif
+    }
+  }
+
+  // Returns the file at `path`, opening it if no sink holds it yet. If the
+  // path is claimed, returns a file that writes nothing.
+  static std::shared_ptr<SharedFile> open(const std::string& path) {
+    Registry& files = registry();
+    {
+      std::lock_guard<std::mutex> lock(files.mutex);
+      if (std::shared_ptr<SharedFile> file = files.open_files[path].lock()) {
+        return file;
+      }
+      if (files.claimed_paths.contains(path)) [[unlikely]] {
+        return claimed_file(path);
+      }
+    }
+
+    // Outside the lock, so that sinks of other paths do not wait for the
+    // compression.
+    rotate(path);
+
+    std::lock_guard<std::mutex> lock(files.mutex);
+    std::weak_ptr<SharedFile>& entry = files.open_files[path];
+    // Another thread may have opened or claimed it in the meantime.
+    if (std::shared_ptr<SharedFile> file = entry.lock()) {
+      return file;
+    }
+    if (files.claimed_paths.contains(path)) [[unlikely]] {
+      return claimed_file(path);
+    }
+    std::shared_ptr<SharedFile> file(new SharedFile(path, true));
+    entry = file;
+    return file;
+  }
+
+  // Locks the buffer lines are appended to and returns it. end_append()
+  // unlocks it, and writes it out once it holds kBufferCapacity bytes.
+  inline fmt::memory_buffer* begin_append() {
+    buffer_mutex_.lock();
+    return appending_;
+  }
+
+  inline void end_append() {
+    const std::size_t size = appending_->size();
+    buffer_mutex_.unlock();
+    if (size >= kBufferCapacity) [[unlikely]] {
+      flush(size >= kMaxBufferSize);
+    }
+  }
+
+  // Appends `size` bytes at `data` to the file in one piece.
+  inline void append(const char* data, std::size_t size) {
+    begin_append()->append(data, data + size);
+    end_append();
+  }
+
+  // Writes out the lines appended by every sink of the file. If another
+  // thread is writing already, returns at once and leaves them to it, unless
+  // `wait`.
+  void flush(bool wait = false) {
+    while (true) {
+      std::unique_lock<std::mutex> writer(write_mutex_, std::defer_lock);
+      if (wait) {
+        writer.lock();
+      } else if (!writer.try_lock()) {
+        return;
+      }
+
+      while (true) {
+        {
+          std::lock_guard<std::mutex> lock(buffer_mutex_);
+          if (appending_->size() == 0) {
+            break;
+          }
+          std::swap(appending_, writing_);
+        }
+        write_all(writing_->data(), writing_->size());
+        writing_->clear();
+      }
+      writer.unlock();
+
+      // Lines appended after the buffer was found empty, by a thread that
+      // left them to this one, are written by another round.
+      std::lock_guard<std::mutex> lock(buffer_mutex_);
+      if (appending_->size() == 0) {
+        return;
+      }
+      wait = false;
+    }
+  }
+
+  [[nodiscard]] inline const std::string& path() const noexcept {
+    return path_;
+  }
+
+  // Claims `path` for a sink that writes it through its own descriptor, and
+  // rotates it like open(). Returns false if the path is open or claimed
+  // already, and the sink must then write nothing.
+  [[nodiscard]] static bool claim(const std::string& path) {
+    {
+      Registry& files = registry();
+      std::lock_guard<std::mutex> lock(files.mutex);
+      const auto it = files.open_files.find(path);
+      if ((it != files.open_files.end() && !it->second.expired()) ||
+          !files.claimed_paths.insert(path).second) {
+        return false;
+      }
+    }
+    rotate(path);
+    return true;
+  }
+
+  // Gives up a claim of claim() once the sink has closed its descriptor.
+  static void release(const std::string& path) {
+    Registry& files = registry();
+    std::lock_guard<std::mutex> lock(files.mutex);
+    files.claimed_paths.erase(path);
+  }
+
+  // Compresses the file at `path`, if any, into a gzip archive named after
+  // the current time next to it, and creates an empty file in its place,
+  // unless the path has been rotated before in this process. Returns whether
+  // it was rotated. Sinks that open their file on their own call it first.
+  static bool rotate(const std::string& path) {
+    std::once_flag* rotation;
+    {
+      Registry& files = registry();
+      std::lock_guard<std::mutex> lock(files.mutex);
+      rotation = &files.rotations[path];
+    }
+    // Others rotating the same path wait for the first one to finish.
+    bool rotated = false;
+    std::call_once(*rotation, [&path, &rotated]() {
+      rotate_file(path);
+      rotated = true;
+    });
+    return rotated;
+  }
+
+  // Lines the buffer collects before it is written out.
+  static constexpr std::size_t kBufferCapacity = 64 * 1024;
+  // Size past which sinks appending lines wait for the buffer to be written,
+  // rather than let it grow while another thread's write stalls.
+  static constexpr std::size_t kMaxBufferSize = 16 * kBufferCapacity;
+
+ private:
+  struct Registry {
+    std::mutex mutex;
+    std::unordered_map<std::string, std::weak_ptr<SharedFile>> open_files;
+    // Rotation of each path opened so far; done once, after which the path
+    // is appended to.
+    std::unordered_map<std::string, std::once_flag> rotations;
+    // Paths of sinks that write them on their own.
+    std::unordered_set<std::string> claimed_paths;
+  };
+
+  // Opens the file at `path` for appending, or writes nothing if not
+  // `open_file`.
+  SharedFile(const std::string& path, bool open_file) : path_(path) {
+    if (!open_file) {
+      return;
+    }
+#if FEMTOLOG_IS_WINDOWS
+    fd_ = _open(path_.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY,
+                _S_IREAD | _S_IWRITE);
+#else
+    fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+#endif
+
+    // Room for a full buffer and the line that fills it, so that lines up to
+    // kBufferCapacity never make it grow.
+    for (fmt::memory_buffer& buffer : buffers_) {
+      buffer.reserve(kBufferCapacity * 2);
+    }
+  }
+
+  static std::shared_ptr<SharedFile> claimed_file(const std::string& path) {
+    FEMTOLOG_DCHECK(false) << "another sink writes " << path
+                           << " on its own.";
+    return std::shared_ptr<SharedFile>(new SharedFile(path, false));
+  }
+
+  // Writes `size` bytes at `data`, dropping them on errors as the other sinks
+  // do.
+  inline void write_all(const char* data, std::size_t size) {
+    if (fd_ < 0) [[unlikely]] {
+      return;
+    }
+    while (size > 0) {
+#if FEMTOLOG_IS_WINDOWS
+      const int written =
+          _write(fd_, data, static_cast<unsigned int>(size));
+#else
+      const ssize_t written = ::write(fd_, data, size);
+#endif
+      if (written <= 0) [[unlikely]] {
+        return;
+      }
+      data += written;
+      size -= static_cast<std::size_t>(written);
+    }
+  }
+
+  static void rotate_file(const std::string& path) {
+    const std::string parent_dir = core::parent_dir(path);
+    if (!core::dir_exists(parent_dir.c_str())) {
+      core::create_directories(parent_dir.c_str());
+    }
+    if (!core::file_exists(path.c_str())) {
+      core::create_file(path.c_str());
+      return;
+    }
+
+    char base_timestamp_name[32];
+    SinkBase::format_timestamp<TimeZone::kLocal, "{:%Y-%m-%d_%H-%M-%S}">(
+        timestamp_ns(), base_timestamp_name, sizeof(base_timestamp_name));
+
+    const std::string original_file_name_without_ext =
+        core::file_name_without_extension(path);
+    const std::string original_extension = core::file_extension(path);
+
+    int counter = 0;
+    std::string compressed_file_name;
+    std::string dest_path;
+
+    do {
+      compressed_file_name = original_file_name_without_ext;
+      compressed_file_name.append("_");
+      compressed_file_name.append(base_timestamp_name);
+
+      if (counter > 0) {
+        compressed_file_name.append("-");
+        compressed_file_name.append(std::to_string(counter));
+      }
+
+      compressed_file_name.append(".");
+      compressed_file_name.append(original_extension);
+      compressed_file_name.append(".gz");
+
+      dest_path = core::join_path(parent_dir, compressed_file_name);
+      counter++;
+    } while (core::file_exists(dest_path.c_str()));
+
+    core::compress(path.c_str(), dest_path.c_str(), true);
+    core::create_file(path.c_str());
+  }
+
+  static Registry& registry() {
+    // Intentionally leaked: sinks of loggers with thread storage duration may
+    // close their files after function-local statics have been destroyed.
+    static Registry* registry = new Registry();
+    return *registry;
+  }
+
+  int fd_ = -1;
+  std::string path_;
+
+  // Sinks append lines to `appending_` while the writer writes `writing_`
+  // out; the two are swapped once the writer is done.
+  std::mutex buffer_mutex_;
+  fmt::memory_buffer buffers_[2];
+  fmt::memory_buffer* appending_ = &buffers_[0];
+  fmt::memory_buffer* writing_ = &buffers_[1];
+  // Held by the one thread writing out the buffer.
+  std::mutex write_mutex_;
+};
+
+}  // namespace femtolog
+
+#endif  // INCLUDE_FEMTOLOG_SINKS_SHARED_FILE_H_
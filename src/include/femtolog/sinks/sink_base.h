@@ -12,6 +12,8 @@
 #include "femtolog/base/log_entry.h"
 #include "femtolog/build/build_flag.h"
 #include "femtolog/core/check.h"
+#include "femtolog/sinks/layout.h"
+#include "fmt/chrono.h"
 #include "fmt/format.h"
 
 #if FEMTOLOG_IS_WINDOWS
@@ -23,10 +25,7 @@
 
 namespace femtolog {
 
-enum class TimeZone : uint8_t {
-  kUtc = 0,
-  kLocal = 1,
-};
+class SharedFile;
 
 class SinkBase {
  public:
@@ -43,7 +42,46 @@ class SinkBase {
                              const char* content,
                              std::size_t len) = 0;
 
+  // Writes out whatever the sink has buffered. The backend calls it once its
+  // queues are drained, when lines have waited for the flush latency, and on
+  // Logger::flush().
+  virtual inline void flush() {}
+
+  // The layout of the sink's lines, or null if on_log() lays them out itself.
+  // With a layout, on_log() is given whole lines, which the backend renders
+  // once for all the sinks of the same layout.
+  [[nodiscard]] inline const LayoutFunctions* layout() const noexcept {
+    return layout_;
+  }
+
+  // Optional interface of sinks that buffer their output. While such a sink
+  // is the only one of a backend, messages are formatted straight into its
+  // buffer between begin_log() and end_log(), instead of being formatted into
+  // the backend's buffer and copied by on_log().
+  [[nodiscard]] virtual inline bool has_log_buffer() const noexcept {
+    return false;
+  }
+
+  // Returns the buffer the line of `entry` is to be appended to, after writing
+  // the sink's own prefix if it has no layout. Only called if
+  // has_log_buffer().
+  virtual inline fmt::memory_buffer* begin_log(const LogEntry&) {
+    FEMTOLOG_DCHECK(false) << "called on a sink without a log buffer.";
+    return nullptr;
+  }
+
+  // Called once the message has been appended to the buffer of begin_log().
+  virtual inline void end_log(const LogEntry&) {}
+
  protected:
+  // Names rotated files with format_timestamp().
+  friend class SharedFile;
+
+  // Must be called before the sink is registered.
+  inline void set_layout(const LayoutFunctions* layout) noexcept {
+    layout_ = layout;
+  }
+
   template <TimeZone tz = TimeZone::kLocal,
             FixedString fmt = "{:%H:%M:%S}.{:09d} ">
   static std::size_t format_timestamp(uint64_t time_ns,
@@ -82,6 +120,9 @@ class SinkBase {
     buf[result.size] = '\0';
     return result.size;
   }
+
+ private:
+  const LayoutFunctions* layout_ = nullptr;
 };
 
 }  // namespace femtolog
@@ -0,0 +1,200 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+// Built into its own test binary, since it replaces the global allocation
+// functions to count the allocations of the code under test.
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "femtolog/build/build_flag.h"
+#include "femtolog/logging/impl/args_deserializer.h"
+#include "femtolog/logging/impl/args_serializer.h"
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+// Counts the allocations of the current thread while set.
+thread_local bool count_allocations = false;
+thread_local std::size_t allocation_count = 0;
+
+void* allocate(std::size_t size, std::size_t alignment) noexcept {
+  if (count_allocations) {
+    allocation_count++;
+  }
+  if (size == 0) {
+    size = 1;
+  }
+  void* ptr = nullptr;
+  if (alignment <= alignof(std::max_align_t)) {
+    ptr = std::malloc(size);
+  } else {
+    // aligned_alloc() wants the size to be a multiple of the alignment.
+    ptr = std::aligned_alloc(alignment,
+                             (size + alignment - 1) / alignment * alignment);
+  }
+  return ptr;
+}
+
+void* allocate_or_abort(std::size_t size, std::size_t alignment) {
+  void* ptr = allocate(size, alignment);
+  if (!ptr) [[unlikely]] {
+    std::abort();
+  }
+  return ptr;
+}
+
+}  // namespace
+
+// Not inlined, so that the compiler does not pair the free() calls below with
+// new-expressions of the callers.
+FEMTOLOG_NO_INLINE void* operator new(std::size_t size) {
+  return allocate_or_abort(size, alignof(std::max_align_t));
+}
+FEMTOLOG_NO_INLINE void* operator new[](std::size_t size) {
+  return allocate_or_abort(size, alignof(std::max_align_t));
+}
+FEMTOLOG_NO_INLINE void* operator new(std::size_t size,
+                                      std::align_val_t al) {
+  return allocate_or_abort(size, static_cast<std::size_t>(al));
+}
+FEMTOLOG_NO_INLINE void* operator new[](std::size_t size,
+                                        std::align_val_t al) {
+  return allocate_or_abort(size, static_cast<std::size_t>(al));
+}
+FEMTOLOG_NO_INLINE void* operator new(std::size_t size,
+                                      const std::nothrow_t&) noexcept {
+  return allocate(size, alignof(std::max_align_t));
+}
+FEMTOLOG_NO_INLINE void* operator new[](std::size_t size,
+                                        const std::nothrow_t&) noexcept {
+  return allocate(size, alignof(std::max_align_t));
+}
+FEMTOLOG_NO_INLINE void* operator new(std::size_t size,
+                                      std::align_val_t al,
+                                      const std::nothrow_t&) noexcept {
+  return allocate(size, static_cast<std::size_t>(al));
+}
+FEMTOLOG_NO_INLINE void* operator new[](std::size_t size,
+                                        std::align_val_t al,
+                                        const std::nothrow_t&) noexcept {
+  return allocate(size, static_cast<std::size_t>(al));
+}
+
+FEMTOLOG_NO_INLINE void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+FEMTOLOG_NO_INLINE void operator delete[](void* ptr) noexcept {
+  std::free(ptr);
+}
+FEMTOLOG_NO_INLINE void operator delete(void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+FEMTOLOG_NO_INLINE void operator delete[](void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+FEMTOLOG_NO_INLINE void operator delete(void* ptr,
+                                        std::align_val_t) noexcept {
+  std::free(ptr);
+}
+FEMTOLOG_NO_INLINE void operator delete[](void* ptr,
+                                          std::align_val_t) noexcept {
+  std::free(ptr);
+}
+FEMTOLOG_NO_INLINE void operator delete(void* ptr,
+                                        std::size_t,
+                                        std::align_val_t) noexcept {
+  std::free(ptr);
+}
+FEMTOLOG_NO_INLINE void operator delete[](void* ptr,
+                                          std::size_t,
+                                          std::align_val_t) noexcept {
+  std::free(ptr);
+}
+FEMTOLOG_NO_INLINE void operator delete(void* ptr,
+                                        const std::nothrow_t&) noexcept {
+  std::free(ptr);
+}
+FEMTOLOG_NO_INLINE void operator delete[](void* ptr,
+                                          const std::nothrow_t&) noexcept {
+  std::free(ptr);
+}
+FEMTOLOG_NO_INLINE void operator delete(void* ptr,
+                                        std::align_val_t,
+                                        const std::nothrow_t&) noexcept {
+  std::free(ptr);
+}
+FEMTOLOG_NO_INLINE void operator delete[](void* ptr,
+                                          std::align_val_t,
+                                          const std::nothrow_t&) noexcept {
+  std::free(ptr);
+}
+
+namespace femtolog::logging {
+
+namespace {
+
+template <std::size_t kCapacity>
+std::string_view deserialize_and_format(const SerializedArgs<kCapacity>& args,
+                                        fmt::memory_buffer* buffer) {
+  const SerializedArgsHeader* header =
+      reinterpret_cast<const SerializedArgsHeader*>(args.data());
+  buffer->clear();
+  const std::size_t size = header->deserialize_and_format_func(
+      buffer, header->format_func, args.data() + sizeof(*header));
+  return std::string_view(buffer->data(), size);
+}
+
+TEST(ArgsDeserializerAllocationTest, FormattingDoesNotAllocate) {
+  const std::string copied(64, 's');
+  const std::string referenced = "referenced";
+  const std::vector<double> levels = {1.5, 2.5, 3.5};
+
+  ArgsSerializer<512> copy_serializer;
+  auto& copy_args = copy_serializer.serialize<"{} {} {} {} {} {}", false>(
+      copied, std::string_view(copied), StaticString("static"), 42, levels,
+      0.5);
+  ArgsSerializer<512> ref_serializer;
+  auto& ref_args = ref_serializer.serialize<"{} {}", true>(referenced, levels);
+
+  fmt::memory_buffer buffer;
+  buffer.reserve(1024);
+  allocation_count = 0;
+  count_allocations = true;
+  std::string_view formatted = deserialize_and_format(copy_args, &buffer);
+  count_allocations = false;
+  EXPECT_EQ(allocation_count, 0u);
+  EXPECT_EQ(formatted,
+            copied + " " + copied + " static 42 [1.5, 2.5, 3.5] 0.5");
+
+  allocation_count = 0;
+  count_allocations = true;
+  formatted = deserialize_and_format(ref_args, &buffer);
+  count_allocations = false;
+  EXPECT_EQ(allocation_count, 0u);
+  EXPECT_EQ(formatted, "referenced [1.5, 2.5, 3.5]");
+}
+
+TEST(ArgsDeserializerAllocationTest, CountsEveryAllocationForm) {
+  constexpr std::align_val_t kAlignment{64};
+  allocation_count = 0;
+  count_allocations = true;
+  ::operator delete(::operator new(8));
+  ::operator delete[](::operator new[](8));
+  ::operator delete(::operator new(8, kAlignment), kAlignment);
+  ::operator delete[](::operator new[](8, kAlignment), kAlignment);
+  ::operator delete(::operator new(8, std::nothrow));
+  ::operator delete[](::operator new[](8, std::nothrow));
+  count_allocations = false;
+  EXPECT_EQ(allocation_count, 6u);
+}
+
+}  // namespace
+
+}  // namespace femtolog::logging
@@ -3,6 +3,7 @@
 // which can be found in the LICENSE file.
 
 #include <string>
+#include <vector>
 
 #include "benchmark/benchmark.h"
 #include "femtolog/logging/impl/args_deserializer.h"
@@ -28,6 +29,7 @@ void args_deserializer_deserialize_and_format(benchmark::State& state) {
   fmt::memory_buffer buf;
   buf.reserve(1024);
   for (auto _ : state) {
+    buf.clear();
     std::size_t n =
         header->deserialize_and_format_func(&buf, header->format_func, payload);
     // benchmark::DoNotOptimize(buf.data());
@@ -37,6 +39,81 @@ void args_deserializer_deserialize_and_format(benchmark::State& state) {
 
 BENCHMARK(args_deserializer_deserialize_and_format);
 
+void args_deserializer_format_strings(benchmark::State& state) {
+  std::string a = "order-book-snapshot";
+  std::string b = "venue-XNAS-primary";
+
+  ArgsSerializer<256> serializer;
+  auto& args = serializer.serialize<"a={}, b={}", false>(a, b);
+
+  const SerializedArgsHeader* header =
+      reinterpret_cast<const SerializedArgsHeader*>(args.data());
+  const char* payload =
+      reinterpret_cast<const char*>(args.data() + sizeof(*header));
+
+  fmt::memory_buffer buf;
+  buf.reserve(1024);
+  for (auto _ : state) {
+    buf.clear();
+    std::size_t n =
+        header->deserialize_and_format_func(&buf, header->format_func, payload);
+    benchmark::DoNotOptimize(n);
+  }
+}
+
+BENCHMARK(args_deserializer_format_strings);
+
+void args_deserializer_format_many(benchmark::State& state) {
+  std::string venue = "XNAS";
+  std::string symbol = "ACME";
+
+  ArgsSerializer<256> serializer;
+  auto& args = serializer.serialize<"{} {} {} {} {} {} {} {}", false>(
+      1, venue, 2, symbol, 3, 4u, int64_t{5}, 'c');
+
+  const SerializedArgsHeader* header =
+      reinterpret_cast<const SerializedArgsHeader*>(args.data());
+  const char* payload =
+      reinterpret_cast<const char*>(args.data() + sizeof(*header));
+
+  fmt::memory_buffer buf;
+  buf.reserve(1024);
+  for (auto _ : state) {
+    buf.clear();
+    std::size_t n =
+        header->deserialize_and_format_func(&buf, header->format_func, payload);
+    benchmark::DoNotOptimize(n);
+  }
+}
+
+BENCHMARK(args_deserializer_format_many);
+
+void args_deserializer_format_range(benchmark::State& state) {
+  std::vector<double> levels(state.range(0));
+  for (std::size_t i = 0; i < levels.size(); ++i) {
+    levels[i] = 100.0 + 0.25 * static_cast<double>(i);
+  }
+
+  ArgsSerializer<1024> serializer;
+  auto& args = serializer.serialize<"levels={}", false>(levels);
+
+  const SerializedArgsHeader* header =
+      reinterpret_cast<const SerializedArgsHeader*>(args.data());
+  const char* payload =
+      reinterpret_cast<const char*>(args.data() + sizeof(*header));
+
+  fmt::memory_buffer buf;
+  buf.reserve(4096);
+  for (auto _ : state) {
+    buf.clear();
+    std::size_t n =
+        header->deserialize_and_format_func(&buf, header->format_func, payload);
+    benchmark::DoNotOptimize(n);
+  }
+}
+
+BENCHMARK(args_deserializer_format_range)->Arg(4)->Arg(32);
+
 }  // namespace
 
 }  // namespace femtolog::logging
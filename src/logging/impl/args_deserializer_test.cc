@@ -5,6 +5,8 @@
 #include "femtolog/logging/impl/args_deserializer.h"
 
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "femtolog/logging/impl/args_serializer.h"
 #include "fmt/format.h"
@@ -14,6 +16,17 @@ namespace femtolog::logging {
 
 namespace {
 
+template <std::size_t kCapacity>
+std::string_view deserialize_and_format(const SerializedArgs<kCapacity>& args,
+                                        fmt::memory_buffer* buffer) {
+  const SerializedArgsHeader* header =
+      reinterpret_cast<const SerializedArgsHeader*>(args.data());
+  buffer->clear();
+  const std::size_t size = header->deserialize_and_format_func(
+      buffer, header->format_func, args.data() + sizeof(*header));
+  return std::string_view(buffer->data(), size);
+}
+
 TEST(ArgsDeserializerTest, DeserializeAndFormatWorks) {
   StringRegistry registry;
 
@@ -36,6 +49,32 @@ TEST(ArgsDeserializerTest, DeserializeAndFormatWorks) {
   EXPECT_EQ(formatted, "i=42, s=example, d=3.14");
 }
 
+TEST(ArgsDeserializerTest, DecodesAnyNumberOfArgumentsInOrder) {
+  const std::string a = "alpha";
+  const std::string_view b = "beta";
+  const std::vector<int> c = {1, 2};
+
+  ArgsSerializer<512> serializer;
+  auto& args = serializer.serialize<"{} {} {} {} {} {} {} {}", false>(
+      1, a, 2.5, b, 'x', c, uint64_t{1} << 40, "gamma");
+
+  fmt::memory_buffer buffer;
+  EXPECT_EQ(deserialize_and_format(args, &buffer),
+            "1 alpha 2.5 beta x [1, 2] 1099511627776 gamma");
+}
+
+TEST(ArgsDeserializerTest, CompiledFormatGrowsTheBuffer) {
+  const std::string payload(2000, 'p');
+
+  ArgsSerializer<4096> serializer;
+  auto& args = serializer.serialize<"payload={:>2010}", false>(payload);
+
+  fmt::memory_buffer buffer;
+  ASSERT_LT(buffer.capacity(), 2018u);
+  EXPECT_EQ(deserialize_and_format(args, &buffer),
+            "payload=          " + payload);
+}
+
 }  // namespace
 
 }  // namespace femtolog::logging
@@ -3,6 +3,7 @@
 // which can be found in the LICENSE file.
 
 #include <string>
+#include <vector>
 
 #include "benchmark/benchmark.h"
 #include "femtolog/logging/impl/args_serializer.h"
@@ -39,6 +40,15 @@ void args_serializer_serialize_mixed(benchmark::State& state) {
 }
 BENCHMARK(args_serializer_serialize_mixed);
 
+void args_serializer_serialize_range(benchmark::State& state) {
+  ArgsSerializer serializer;
+  const std::vector<double> levels(32, 100.25);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(serializer.serialize<"", false>(levels));
+  }
+}
+BENCHMARK(args_serializer_serialize_range);
+
 }  // namespace
 
 }  // namespace femtolog::logging
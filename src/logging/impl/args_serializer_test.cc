@@ -4,13 +4,65 @@
 
 #include "femtolog/logging/impl/args_serializer.h"
 
+#include <array>
 #include <cstdint>
 #include <cstring>
+#include <span>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include "gtest/gtest.h"
 
+namespace {
+
+// Neither a string nor trivially copyable; logged through a codec.
+struct Order {
+  std::string symbol;
+  std::vector<int> fills;
+};
+
+struct OrderView {
+  std::string_view symbol;
+  int filled;
+};
+
+}  // namespace
+
+template <>
+struct femtolog::codec<Order> {
+  static std::size_t size(const Order& order) {
+    return order.symbol.size() + sizeof(int);
+  }
+
+  // Only the sum of the fills is kept.
+  static char* encode(char* dst, const Order& order) {
+    int filled = 0;
+    for (int fill : order.fills) {
+      filled += fill;
+    }
+    std::memcpy(dst, order.symbol.data(), order.symbol.size());
+    dst += order.symbol.size();
+    std::memcpy(dst, &filled, sizeof(filled));
+    return dst + sizeof(filled);
+  }
+
+  static OrderView decode(const char* src, std::size_t size) {
+    OrderView view;
+    view.symbol = std::string_view(src, size - sizeof(int));
+    std::memcpy(&view.filled, src + view.symbol.size(), sizeof(int));
+    return view;
+  }
+};
+
+template <>
+struct fmt::formatter<OrderView> : fmt::formatter<std::string_view> {
+  template <typename FormatContext>
+  auto format(const OrderView& view, FormatContext& ctx) const {
+    return fmt::format_to(ctx.out(), "{}:{}", view.symbol, view.filled);
+  }
+};
+
 namespace femtolog::logging {
 
 namespace {
@@ -74,6 +126,132 @@ TEST(ArgsSerializerTest, OutOfScope) {
   EXPECT_EQ(std::string_view(formatted_str, n), "int=42, cstr=test");
 }
 
+static_assert(is_static_string_v<StaticString>);
+static_assert(is_static_string_v<const StaticString&>);
+static_assert(!is_static_string_v<const char (&)[6]>);
+static_assert(!is_static_string_v<char (&)[6]>);
+static_assert(!is_static_string_v<const char*>);
+static_assert(!is_static_string_v<std::string_view>);
+
+TEST(ArgsSerializerTest, StaticStringsArePassedByPointer) {
+  static constexpr std::string_view kKind = "interactive";
+  char storage[16] = "local";
+  const char(&local)[16] = storage;
+  char buffer[16] = "mutable";
+
+  ArgsSerializer<256> serializer;
+  auto& args = serializer.serialize<"op={} kind={} local={} buf={}", false>(
+      StaticString("login"), StaticString(kKind), local, buffer);
+
+  // Static strings take a pointer and a length varint; char arrays, const or
+  // not, are copied.
+  EXPECT_EQ(args.size(), sizeof(SerializedArgsHeader) +
+                             2 * (sizeof(uintptr_t) + 1) +
+                             2 * sizeof(std::size_t) + strlen(local) +
+                             strlen(buffer));
+  uintptr_t kind_ptr;
+  std::memcpy(&kind_ptr,
+              args.data() + sizeof(SerializedArgsHeader) + sizeof(uintptr_t) +
+                  1,
+              sizeof(kind_ptr));
+  EXPECT_EQ(kind_ptr, reinterpret_cast<uintptr_t>(kKind.data()));
+
+  std::strcpy(storage, "gone");
+  std::strcpy(buffer, "changed");
+
+  auto header = reinterpret_cast<const SerializedArgsHeader*>(args.data());
+  fmt::memory_buffer buf;
+  std::size_t n = header->deserialize_and_format_func(
+      &buf, header->format_func, args.data() + sizeof(SerializedArgsHeader));
+  EXPECT_EQ(std::string_view(buf.data(), n),
+            "op=login kind=interactive local=local buf=mutable");
+}
+
+static_assert(is_codec_encoded_v<Order>);
+static_assert(!is_codec_encoded_v<std::string>);
+static_assert(std::is_same_v<deserialized_arg_type_t<false, Order>, OrderView>);
+
+TEST(ArgsSerializerTest, CodecEncodesArgumentsOnTheLoggingThread) {
+  for (bool ref_mode : {false, true}) {
+    ArgsSerializer<256> serializer;
+    SerializedArgs<256>* args = nullptr;
+    {
+      const Order order{"ACME", {3, 4}};
+      const int id = 7;
+      args = ref_mode
+                 ? &serializer.serialize<"id={} order={}", true>(id, order)
+                 : &serializer.serialize<"id={} order={}", false>(id, order);
+      EXPECT_EQ(args->size(), sizeof(SerializedArgsHeader) + sizeof(id) +
+                                  sizeof(uint32_t) + order.symbol.size() +
+                                  sizeof(int));
+    }
+
+    // The order is gone; its encoding is not.
+    auto header = reinterpret_cast<const SerializedArgsHeader*>(args->data());
+    fmt::memory_buffer buf;
+    std::size_t n = header->deserialize_and_format_func(
+        &buf, header->format_func, args->data() + sizeof(SerializedArgsHeader));
+    EXPECT_EQ(std::string_view(buf.data(), n), "id=7 order=ACME:7");
+  }
+}
+
+static_assert(is_trivial_range_v<std::vector<int>>);
+static_assert(is_trivial_range_v<std::array<double, 3>>);
+static_assert(is_trivial_range_v<std::span<const uint64_t>>);
+static_assert(!is_trivial_range_v<std::string>);
+static_assert(!is_trivial_range_v<std::vector<std::string>>);
+
+TEST(ArgsSerializerTest, RangesAreCopiedElementWise) {
+  std::vector<int> levels = {100, 101, 102};
+  const std::array<double, 2> prices = {1.25, 2.5};
+  const uint64_t raw_ids[] = {7, 8, 9, 10};
+  const std::span<const uint64_t> ids(raw_ids);
+  const std::vector<int> empty;
+
+  ArgsSerializer<256> serializer;
+  auto& args =
+      serializer.serialize<"levels={} prices={:.1f} ids={} empty={}", false>(
+          levels, prices, ids, empty);
+
+  // A one-byte count and the elements each.
+  const std::size_t elements_size =
+      sizeof(int) * levels.size() + sizeof(prices) + sizeof(raw_ids);
+  EXPECT_EQ(args.size(), sizeof(SerializedArgsHeader) + 4 + elements_size);
+
+  levels[0] = 0;
+
+  auto header = reinterpret_cast<const SerializedArgsHeader*>(args.data());
+  fmt::memory_buffer buf;
+  std::size_t n = header->deserialize_and_format_func(
+      &buf, header->format_func, args.data() + sizeof(SerializedArgsHeader));
+  EXPECT_EQ(std::string_view(buf.data(), n),
+            "levels=[100, 101, 102] prices=[1.2, 2.5] ids=[7, 8, 9, 10] "
+            "empty=[]");
+}
+
+TEST(ArgsSerializerTest, RangesArePassedByPointerInRefMode) {
+  std::vector<int> levels = {100, 101, 102};
+
+  ArgsSerializer<256> serializer;
+  auto& args = serializer.serialize<"levels={}", true>(levels);
+  EXPECT_EQ(args.size(), sizeof(SerializedArgsHeader) + sizeof(uintptr_t) +
+                             sizeof(std::size_t));
+
+  levels[0] = 0;
+
+  auto header = reinterpret_cast<const SerializedArgsHeader*>(args.data());
+  fmt::memory_buffer buf;
+  std::size_t n = header->deserialize_and_format_func(
+      &buf, header->format_func, args.data() + sizeof(SerializedArgsHeader));
+  EXPECT_EQ(std::string_view(buf.data(), n), "levels=[0, 101, 102]");
+}
+
+TEST(ArgsSerializerTest, RefModeCountsStaticStringLengths) {
+  const int i = 1;
+  EXPECT_EQ(serialized_args_size<true>(StaticString("literal"), i),
+            sizeof(uintptr_t) + 1 + sizeof(i));
+}
+
 }  // namespace
 
 }  // namespace femtolog::logging
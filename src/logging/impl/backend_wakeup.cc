@@ -0,0 +1,66 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#include "femtolog/logging/impl/backend_wakeup.h"
+
+#include "femtolog/build/build_flag.h"
+
+#if FEMTOLOG_IS_LINUX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace femtolog::logging {
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+              "the futex word must be a plain 32-bit integer");
+
+void BackendWakeup::wake() noexcept {
+  epoch_.fetch_add(1, std::memory_order_release);
+#if FEMTOLOG_IS_LINUX
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_), FUTEX_WAKE_PRIVATE,
+          1, nullptr, nullptr, 0);
+#else
+  std::lock_guard<std::mutex> lock(mutex_);
+  cv_.notify_one();
+#endif
+}
+
+uint32_t BackendWakeup::prepare_park() noexcept {
+  parked_.store(1, std::memory_order_relaxed);
+  // Pairs with the producers' release stores of their queue tails: either a
+  // producer sees the flag, or the backend's final check sees its entry
+  // (modulo the unfenced producer side, see the class comment).
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  return epoch_.load(std::memory_order_acquire);
+}
+
+void BackendWakeup::cancel_park() noexcept {
+  parked_.store(0, std::memory_order_relaxed);
+}
+
+void BackendWakeup::park(uint32_t epoch,
+                         std::chrono::microseconds timeout) noexcept {
+#if FEMTOLOG_IS_LINUX
+  const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+  timespec ts;
+  ts.tv_sec = static_cast<time_t>(seconds.count());
+  ts.tv_nsec = static_cast<long>(  // NOLINT(runtime/int)
+      std::chrono::duration_cast<std::chrono::nanoseconds>(timeout - seconds)
+          .count());
+  // Returns right away if a wake() bumped the epoch since prepare_park().
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_), FUTEX_WAIT_PRIVATE,
+          epoch, &ts, nullptr, 0);
+#else
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait_for(lock, timeout, [this, epoch]() {
+    return epoch_.load(std::memory_order_acquire) != epoch;
+  });
+#endif
+  parked_.store(0, std::memory_order_relaxed);
+}
+
+}  // namespace femtolog::logging
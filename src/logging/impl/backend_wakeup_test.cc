@@ -0,0 +1,74 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#include "femtolog/logging/impl/backend_wakeup.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+namespace femtolog::logging {
+
+namespace {
+
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+TEST(BackendWakeupTest, NotifyWakesParkedBackend) {
+  BackendWakeup wakeup;
+  std::atomic<bool> woken = false;
+
+  std::thread backend([&]() {
+    const uint32_t epoch = wakeup.prepare_park();
+    wakeup.park(epoch, std::chrono::seconds(10));
+    woken.store(true);
+  });
+
+  const auto begin = steady_clock::now();
+  while (!wakeup.parked()) {
+    std::this_thread::yield();
+  }
+  std::this_thread::sleep_for(milliseconds(10));
+  EXPECT_FALSE(woken.load());
+
+  wakeup.notify();
+  backend.join();
+  EXPECT_TRUE(woken.load());
+  EXPECT_FALSE(wakeup.parked());
+  EXPECT_LT(steady_clock::now() - begin, std::chrono::seconds(5));
+}
+
+TEST(BackendWakeupTest, WakeBeforeParkIsNotLost) {
+  BackendWakeup wakeup;
+  const uint32_t epoch = wakeup.prepare_park();
+  wakeup.wake();
+
+  const auto begin = steady_clock::now();
+  wakeup.park(epoch, std::chrono::seconds(10));
+  EXPECT_LT(steady_clock::now() - begin, std::chrono::seconds(5));
+}
+
+TEST(BackendWakeupTest, ParkTimesOut) {
+  BackendWakeup wakeup;
+  const uint32_t epoch = wakeup.prepare_park();
+
+  const auto begin = steady_clock::now();
+  wakeup.park(epoch, std::chrono::microseconds(20000));
+  EXPECT_GE(steady_clock::now() - begin, milliseconds(15));
+  EXPECT_FALSE(wakeup.parked());
+}
+
+TEST(BackendWakeupTest, CancelPark) {
+  BackendWakeup wakeup;
+  static_cast<void>(wakeup.prepare_park());
+  EXPECT_TRUE(wakeup.parked());
+  wakeup.cancel_park();
+  EXPECT_FALSE(wakeup.parked());
+}
+
+}  // namespace
+
+}  // namespace femtolog::logging
@@ -4,18 +4,27 @@
 
 #include "femtolog/logging/impl/backend_worker.h"
 
+#include <algorithm>
+#include <cstring>
+#include <functional>
 #include <iostream>
 #include <limits>
+#include <span>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 #include "femtolog/base/log_level.h"
 #include "femtolog/base/string_registry.h"
 #include "femtolog/build/build_flag.h"
+#include "femtolog/core/base/memory_util.h"
 #include "femtolog/core/check.h"
 #include "femtolog/femtolog.h"
 #include "femtolog/logging/impl/args_deserializer.h"
+#include "femtolog/logging/impl/args_serializer.h"
 #include "femtolog/logging/impl/internal_logger.h"
+#include "femtolog/logging/impl/large_message_pool.h"
+#include "femtolog/logging/impl/rate_limiter.h"
 #include "femtolog/options.h"
 #include "fmt/args.h"
 #include "fmt/core.h"
@@ -34,6 +43,31 @@
 
 namespace femtolog::logging {
 
+namespace {
+
+constexpr const std::size_t kMaxEntriesPerVisit = 256;
+
+// Consumed entries are handed back to the producer in batches of this size.
+constexpr const std::size_t kEntriesPerRelease = 32;
+
+constexpr const std::string_view kTruncationMarker = " [truncated]";
+
+// Appends kTruncationMarker to the `size` bytes of message at `data`, before
+// the trailing newline if there is one, and returns the new size. Room for the
+// marker must have been made.
+std::size_t append_truncation_marker(char* data, std::size_t size) {
+  const bool has_newline = size > 0 && data[size - 1] == '\n';
+  char* pos = data + size - (has_newline ? 1 : 0);
+  std::memcpy(pos, kTruncationMarker.data(), kTruncationMarker.size());
+  pos += kTruncationMarker.size();
+  if (has_newline) {
+    *pos++ = '\n';
+  }
+  return static_cast<std::size_t>(pos - data);
+}
+
+}  // namespace
+
 BackendWorker::BackendWorker() = default;
 
 BackendWorker::~BackendWorker() {
@@ -43,18 +77,33 @@ BackendWorker::~BackendWorker() {
 }
 
 void BackendWorker::init(SpscQueue* queue, const FemtologOptions& options) {
+  FEMTOLOG_DCHECK(queue);
+  init(options);
+  attach_queue(queue);
+}
+
+void BackendWorker::init(const FemtologOptions& options) {
   FEMTOLOG_DCHECK_EQ(status_, BackendWorkerStatus::kUninitialized);
   FEMTOLOG_DCHECK_GT(options.backend_dequeue_buffer_size, 0);
   FEMTOLOG_DCHECK_GT(options.backend_format_buffer_size, 0);
-  FEMTOLOG_DCHECK(queue);
 
-  queue_ = queue;
   status_ = BackendWorkerStatus::kIdling;
-  dequeue_buffer_.reserve(options.backend_dequeue_buffer_size);
-  dequeue_buffer_.resize(options.backend_dequeue_buffer_size);
+  // Only entries that wrap around the end of a queue are copied out, and
+  // those can be as large as the largest entry.
+  const std::size_t dequeue_buffer_size =
+      std::max(options.backend_dequeue_buffer_size,
+               QueuedEntryHeader::kMaxSize + kMaxPayloadSize);
+  dequeue_buffer_.reserve(dequeue_buffer_size);
+  dequeue_buffer_.resize(dequeue_buffer_size);
   format_buffer_.reserve(options.backend_format_buffer_size);
+  line_buffer_.reserve(options.backend_format_buffer_size);
   dequeue_buffer_ptr_ = dequeue_buffer_.data();
   worker_thread_cpu_affinity_ = options.backend_worker_cpu_affinity;
+  wait_strategy_ = options.backend_wait_strategy;
+  spin_iterations_ = options.backend_spin_iterations;
+  park_timeout_ = std::chrono::microseconds(options.backend_park_timeout_us);
+  sink_flush_latency_ =
+      std::chrono::microseconds(options.sink_flush_latency_us);
 }
 
 // Using std::jthread for automatic joining in C++20 is preferred,
@@ -63,6 +112,14 @@ void BackendWorker::start() {
   FEMTOLOG_DCHECK_EQ(status_, BackendWorkerStatus::kIdling);
   FEMTOLOG_DCHECK_GT(sinks_.size(), 0);
   FEMTOLOG_DCHECK(dequeue_buffer_ptr_);
+  shutdown_required_.store(false, std::memory_order_relaxed);
+  idle_iterations_ = 0;
+  sync_queues();
+  // Everything was drained by the previous stop(), and the producers may have
+  // released their grown queues since.
+  for (QueueCursor& cursor : queues_) {
+    cursor.current = cursor.head;
+  }
   worker_thread_ = std::thread(&BackendWorker::run_loop, this);
 
   set_cpu_affinity();
@@ -75,6 +132,7 @@ void BackendWorker::stop() {
     return;
   }
   shutdown_required_.store(true, std::memory_order_release);
+  wakeup_.notify_fenced();
   if (worker_thread_.joinable()) {
     worker_thread_.join();
   }
@@ -87,6 +145,7 @@ void BackendWorker::flush() {
   }
   const uint64_t seq =
       flush_requested_seq_.fetch_add(1, std::memory_order_acq_rel) + 1;
+  wakeup_.notify_fenced();
 
   while (flush_completed_seq_.load(std::memory_order_acquire) < seq) {
 #if FEMTOLOG_ENABLE_AVX2
@@ -97,13 +156,62 @@ void BackendWorker::flush() {
   }
 }
 
+void BackendWorker::attach_queue(SpscQueue* queue) {
+  FEMTOLOG_DCHECK(queue);
+  std::lock_guard<std::mutex> lock(queues_mutex_);
+  FEMTOLOG_DCHECK(std::find(pending_queues_.begin(), pending_queues_.end(),
+                            queue) == pending_queues_.end())
+      << "attempted to attach the same queue twice.";
+  pending_queues_.push_back(queue);
+  queues_version_.fetch_add(1, std::memory_order_release);
+  wakeup_.notify_fenced();
+}
+
+void BackendWorker::detach_queue(SpscQueue* queue) {
+  uint64_t version;
+  {
+    std::lock_guard<std::mutex> lock(queues_mutex_);
+    const auto it =
+        std::find(pending_queues_.begin(), pending_queues_.end(), queue);
+    if (it == pending_queues_.end()) [[unlikely]] {
+      return;
+    }
+    pending_queues_.erase(it);
+    detached_queues_.push_back(queue);
+    version = queues_version_.fetch_add(1, std::memory_order_release) + 1;
+  }
+  wakeup_.notify_fenced();
+
+  if (status_ != BackendWorkerStatus::kRunning) {
+    // The backend thread is not touching `queues_`; apply directly.
+    sync_queues();
+    return;
+  }
+
+  // Wait until the backend thread has drained the queue and dropped it from
+  // its working set, so the caller may release the queue right after.
+  while (queues_applied_version_.load(std::memory_order_acquire) < version) {
+    std::this_thread::yield();
+  }
+}
+
+std::size_t BackendWorker::queue_count() const {
+  std::lock_guard<std::mutex> lock(queues_mutex_);
+  return pending_queues_.size();
+}
+
 void BackendWorker::register_sink(std::unique_ptr<SinkBase> sink) {
+  register_shared_sink(std::shared_ptr<SinkBase>(std::move(sink)));
+}
+
+void BackendWorker::register_shared_sink(std::shared_ptr<SinkBase> sink) {
   FEMTOLOG_DCHECK_NE(status_, BackendWorkerStatus::kRunning)
       << "attempted to register new sink while running.";
   FEMTOLOG_DCHECK_EQ(status_, BackendWorkerStatus::kIdling);
   FEMTOLOG_DCHECK(sink);
 
   sinks_.push_back(std::move(sink));
+  update_sinks();
 }
 
 void BackendWorker::clear_sinks() {
@@ -111,6 +219,25 @@ void BackendWorker::clear_sinks() {
       << "attempted to clear all sinks while running.";
   FEMTOLOG_DCHECK_EQ(status_, BackendWorkerStatus::kIdling);
   sinks_.clear();
+  update_sinks();
+}
+
+void BackendWorker::update_sinks() {
+  std::stable_sort(sinks_.begin(), sinks_.end(),
+                   [](const std::shared_ptr<SinkBase>& lhs,
+                      const std::shared_ptr<SinkBase>& rhs) {
+                     return std::less<const LayoutFunctions*>()(
+                         lhs->layout(), rhs->layout());
+                   });
+  log_buffer_sink_ = sinks_.size() == 1 && sinks_.front()->has_log_buffer()
+                         ? sinks_.front().get()
+                         : nullptr;
+}
+
+void BackendWorker::set_sink_mutex(std::mutex* mutex) {
+  FEMTOLOG_DCHECK_NE(status_, BackendWorkerStatus::kRunning)
+      << "attempted to change the sink mutex while running.";
+  sink_mutex_ = mutex;
 }
 
 void BackendWorker::set_cpu_affinity() {
@@ -140,24 +267,133 @@ void BackendWorker::set_cpu_affinity() {
 #endif
 }
 
-inline bool BackendWorker::read_and_process_one() {
-  uint16_t payload_len;
-  if (queue_->peek_bytes(&payload_len, sizeof(payload_len)) !=
-      SpscQueueStatus::kOk) {
+inline bool BackendWorker::read_and_process_one(QueueCursor* cursor) {
+  SpscQueue* queue = cursor->current;
+  QueueMetadata& metadata = cursor->head->metadata();
+  const std::span<std::byte> readable = queue->readable_span();
+  // Entries are decoded and formatted where they sit in the ring.
+  const char* data = reinterpret_cast<const char*>(readable.data());
+  QueuedEntryHeader header;
+  const std::size_t header_size =
+      header.decode(data, readable.size(), metadata.frontend_timestamps);
+  if (header_size != 0) [[likely]] {
+    const std::size_t entry_size = header_size + header.payload_len;
+    if (readable.size() >= entry_size) [[likely]] {
+      if (readable.size() > entry_size) {
+        core::prefetch_for_read(data + entry_size);
+      }
+      process_log_entry(&metadata, header, data + header_size);
+      queue->consume(entry_size);
+      return true;
+    }
+  }
+  if (readable.empty()) {
     return false;
   }
+  return read_wrapped_entry(cursor);
+}
 
-  const std::size_t total_size = sizeof(LogEntry) + payload_len;
-  FEMTOLOG_DCHECK_GE(queue_->size(), total_size);
-  if (queue_->dequeue_bytes(dequeue_buffer_ptr_, total_size) !=
+bool BackendWorker::read_wrapped_entry(QueueCursor* cursor) {
+  SpscQueue* queue = cursor->current;
+  QueueMetadata& metadata = cursor->head->metadata();
+  // Entries are published whole, so the header is complete in the queue.
+  const std::size_t peek_size =
+      std::min(queue->size(), QueuedEntryHeader::kMaxSize);
+  if (queue->peek_bytes(dequeue_buffer_ptr_, peek_size) !=
+      SpscQueueStatus::kOk) {
+    return false;
+  }
+  QueuedEntryHeader header;
+  const std::size_t header_size =
+      header.decode(reinterpret_cast<const char*>(dequeue_buffer_ptr_),
+                    peek_size, metadata.frontend_timestamps);
+  FEMTOLOG_DCHECK_GT(header_size, 0u);
+
+  const std::size_t total_size = header_size + header.payload_len;
+  FEMTOLOG_DCHECK_GE(queue->size(), total_size);
+  if (queue->dequeue_bytes(dequeue_buffer_ptr_, total_size) !=
       SpscQueueStatus::kOk) {
     return false;
   }
-  LogEntry* entry = reinterpret_cast<LogEntry*>(dequeue_buffer_ptr_);
-  process_log_entry(entry);
+  process_log_entry(
+      &metadata, header,
+      reinterpret_cast<const char*>(dequeue_buffer_ptr_) + header_size);
   return true;
 }
 
+inline bool BackendWorker::drain_queue(QueueCursor* cursor,
+                                       std::size_t max_entries) {
+  std::size_t processed = 0;
+  while (processed < max_entries) {
+    if (read_and_process_one(cursor)) [[likely]] {
+      processed++;
+      if (processed % kEntriesPerRelease == 0) [[unlikely]] {
+        cursor->current->release_read();
+      }
+      continue;
+    }
+
+    SpscQueue* successor = cursor->current->successor();
+    if (!successor) [[likely]] {
+      break;
+    }
+    // The successor is published after the producer's last write to the
+    // current queue, so one more read settles whether it is exhausted.
+    if (read_and_process_one(cursor)) {
+      processed++;
+      continue;
+    }
+    cursor->current->release_read();
+    cursor->current = successor;
+  }
+  // Hand the consumed entries back to the producer with one head update.
+  cursor->current->release_read();
+  return processed > 0;
+}
+
+inline void BackendWorker::sync_queues() {
+  const uint64_t version = queues_version_.load(std::memory_order_acquire);
+  if (version == queues_applied_version_.load(std::memory_order_relaxed))
+      [[likely]] {
+    return;
+  }
+
+  std::vector<SpscQueue*> attached;
+  std::vector<SpscQueue*> detached;
+  {
+    std::lock_guard<std::mutex> lock(queues_mutex_);
+    attached = pending_queues_;
+    detached.swap(detached_queues_);
+  }
+
+  auto cursor_for = [this](SpscQueue* head) {
+    for (const QueueCursor& cursor : queues_) {
+      if (cursor.head == head) {
+        return cursor;
+      }
+    }
+    return QueueCursor{head, head};
+  };
+
+  // Drain the detached queues before forgetting them so that no entry
+  // enqueued before the detach request is lost.
+  for (SpscQueue* queue : detached) {
+    QueueCursor cursor = cursor_for(queue);
+    while (drain_queue(&cursor, std::numeric_limits<std::size_t>::max())) {
+    }
+    report_suppressed_calls(queue->metadata());
+  }
+
+  std::vector<QueueCursor> next;
+  next.reserve(attached.size());
+  for (SpscQueue* queue : attached) {
+    next.push_back(cursor_for(queue));
+  }
+  queues_ = std::move(next);
+
+  queues_applied_version_.store(version, std::memory_order_release);
+}
+
 inline void BackendWorker::apply_polling_strategy(bool data_dequeued) {
   // Reset counter on successful dequeue
   if (data_dequeued) {
@@ -167,6 +403,15 @@ inline void BackendWorker::apply_polling_strategy(bool data_dequeued) {
 
   idle_iterations_++;
 
+  if (wait_strategy_ == BackendWaitStrategy::kEventDriven) {
+    if (idle_iterations_ > spin_iterations_) [[unlikely]] {
+      park();
+      // Stay parked after a timeout; only new data restarts the spin phase.
+      idle_iterations_ = spin_iterations_;
+    }
+    return;
+  }
+
   // Tiered backoff strategy
   if (idle_iterations_ <= 2048) {
     // Tier 1: Busy loop
@@ -214,49 +459,216 @@ inline void BackendWorker::apply_polling_strategy(bool data_dequeued) {
   }
 }
 
+void BackendWorker::park() {
+  const uint32_t epoch = wakeup_.prepare_park();
+  // Producers that published before the flag became visible did not signal,
+  // so look at the queues once more before going to sleep.
+  if (has_pending_work()) {
+    wakeup_.cancel_park();
+    return;
+  }
+  wakeup_.park(epoch, park_timeout_);
+}
+
+bool BackendWorker::has_pending_work() {
+  if (shutdown_required_.load(std::memory_order_acquire)) {
+    return true;
+  }
+  if (flush_requested_seq_.load(std::memory_order_acquire) >
+      flush_completed_seq_.load(std::memory_order_relaxed)) {
+    return true;
+  }
+  if (queues_version_.load(std::memory_order_acquire) !=
+      queues_applied_version_.load(std::memory_order_relaxed)) {
+    return true;
+  }
+  for (const QueueCursor& cursor : queues_) {
+    if (!cursor.current->readable_span().empty() ||
+        cursor.current->successor()) {
+      return true;
+    }
+  }
+  return false;
+}
+
 void BackendWorker::flush_impl() {
-  while (true) {
-    if (!read_and_process_one()) {
-      break;
+  bool dequeued = true;
+  while (dequeued) {
+    dequeued = false;
+    for (QueueCursor& cursor : queues_) {
+      dequeued |=
+          drain_queue(&cursor, std::numeric_limits<std::size_t>::max());
     }
   }
+  report_suppressed_calls();
+  flush_sinks();
+}
+
+void BackendWorker::flush_sinks() {
+  std::unique_lock<std::mutex> lock;
+  if (sink_mutex_) [[unlikely]] {
+    lock = std::unique_lock<std::mutex>(*sink_mutex_);
+  }
+  for (const auto& sink : sinks_) {
+    sink->flush();
+  }
+  sinks_dirty_ = false;
 }
 
-void BackendWorker::process_log_entry(LogEntry* entry) {
-  FEMTOLOG_DCHECK(!!entry);
-  entry->timestamp_ns = timestamp_ns();
+void BackendWorker::process_log_entry(QueueMetadata* metadata,
+                                      const QueuedEntryHeader& header,
+                                      const char* payload) {
+  // Entries stamped on the frontend carry raw ticks relative to the previous
+  // entry; the rest are stamped at dequeue time.
+  uint64_t entry_timestamp_ns;
+  if (metadata->frontend_timestamps) {
+    metadata->last_timestamp += header.timestamp_delta;
+    entry_timestamp_ns = tsc_clock_.to_ns(metadata->last_timestamp);
+  } else {
+    entry_timestamp_ns = timestamp_ns();
+  }
+  process_log_entry(entry_timestamp_ns, metadata->thread_id, header, payload);
+}
 
-  const uint16_t format_id = entry->format_id;
+void BackendWorker::process_log_entry(uint64_t entry_timestamp_ns,
+                                      uint32_t thread_id,
+                                      const QueuedEntryHeader& header,
+                                      const char* payload) {
+  const CallSite& call_site =
+      CallSiteRegistry::instance().get(header.call_site_index);
+
+  LogEntry entry;
+  entry.timestamp_ns = entry_timestamp_ns;
+  entry.call_site = &call_site;
+  entry.thread_id = thread_id;
+  entry.payload_len = header.payload_len;
+  entry.format_id = call_site.format_id;
+  entry.level = call_site.level;
+
+  LargeMessagePool::Buffer* large_buffer = nullptr;
+  if (header.flags & QueuedEntryHeader::kOutOfLinePayload) [[unlikely]] {
+    std::memcpy(&large_buffer, payload, sizeof(large_buffer));
+    payload = large_buffer->data();
+    entry.payload_len = static_cast<uint32_t>(large_buffer->size);
+  }
 
-  if (format_id == kLiteralLogStringId) {
-    constexpr const std::size_t kBufSize = kMaxPayloadSize;
-    char buf[kBufSize];
-    const std::size_t n = entry->copy_raw_payload(buf, kBufSize);
-    buf[n] = '\0';
-    for (const auto& sink : sinks_) {
-      FEMTOLOG_DCHECK(sink);
-      sink->on_log(*entry, buf, n);
+  if (log_buffer_sink_) {
+    // Format straight into the buffer of the only sink.
+    std::unique_lock<std::mutex> lock;
+    if (sink_mutex_) [[unlikely]] {
+      lock = std::unique_lock<std::mutex>(*sink_mutex_);
+    }
+    fmt::memory_buffer* out = log_buffer_sink_->begin_log(entry);
+    const LayoutFunctions* layout = log_buffer_sink_->layout();
+    if (!layout) {
+      format_message(out, call_site, header, payload);
+    } else if (!layout->escape_message) [[likely]] {
+      layout->format_prefix(entry, out);
+      format_message(out, call_site, header, payload);
+      layout->format_suffix(entry, out);
+    } else {
+      // The message has to be escaped on its way into the line.
+      format_buffer_.clear();
+      const std::size_t size =
+          format_message(&format_buffer_, call_site, header, payload);
+      layout->format_line(entry, format_buffer_.data(), size, out);
     }
+    log_buffer_sink_->end_log(entry);
+  } else if (call_site.is_literal()) {
+    dispatch_to_sinks(entry, call_site.format.data(), call_site.format.size());
   } else {
     format_buffer_.clear();
+    const std::size_t size =
+        format_message(&format_buffer_, call_site, header, payload);
+    dispatch_to_sinks(entry, format_buffer_.data(), size);
+  }
 
-    const auto header =
-        reinterpret_cast<const SerializedArgsHeader*>(entry->payload());
+  if (large_buffer) [[unlikely]] {
+    LargeMessagePool::release(large_buffer);
+  }
+}
 
-    // NOLINTNEXTLINE
-    if (!header->deserialize_and_format_func || !header->format_func)
-        [[unlikely]] {
-      return;
+bool BackendWorker::report_suppressed_calls(const QueueMetadata& metadata) {
+  bool reported = false;
+  for (SuppressedCalls* calls =
+           metadata.suppressed_calls.load(std::memory_order_acquire);
+       calls; calls = calls->next) {
+    const uint64_t count = calls->count.load(std::memory_order_relaxed);
+    if (count == calls->reported || calls->summary_call_site == 0) {
+      continue;
     }
+    uint64_t suppressed = count - calls->reported;
+    calls->reported = count;
+
+    // Laid out like the arguments of a log call, for the deserializer of the
+    // kSuppressedCallsFormat call site.
+    QueuedEntryHeader header;
+    header.call_site_index = calls->summary_call_site;
+    const std::size_t payload_len =
+        serialized_args_size<false>(suppressed, calls->format);
+    header.payload_len = static_cast<uint32_t>(payload_len);
+    fmt::memory_buffer payload;
+    payload.resize(payload_len);
+    serialize_args_to<false>(payload.data(), suppressed, calls->format);
+    process_log_entry(timestamp_ns(), metadata.thread_id, header,
+                      payload.data());
+    reported = true;
+  }
+  return reported;
+}
+
+bool BackendWorker::report_suppressed_calls() {
+  suppressed_calls_reported_ns_ = core::coarse_monotonic_ns();
+  bool reported = false;
+  for (const QueueCursor& cursor : queues_) {
+    reported |= report_suppressed_calls(cursor.head->metadata());
+  }
+  return reported;
+}
+
+std::size_t BackendWorker::format_message(fmt::memory_buffer* out,
+                                          const CallSite& call_site,
+                                          const QueuedEntryHeader& header,
+                                          const char* payload) {
+  if (call_site.is_literal()) {
+    out->append(call_site.format.data(),
+                call_site.format.data() + call_site.format.size());
+    return call_site.format.size();
+  }
+
+  const std::size_t begin = out->size();
+  std::size_t size = call_site.deserialize_and_format_func(
+      out, call_site.format_func, payload);
+  if (header.flags & QueuedEntryHeader::kTruncated) [[unlikely]] {
+    out->resize(begin + size + kTruncationMarker.size());
+    size = append_truncation_marker(out->data() + begin, size);
+  }
+  return size;
+}
 
-    const std::size_t size = header->deserialize_and_format_func(
-        &format_buffer_, header->format_func,
-        entry->payload() + sizeof(*header));
+inline void BackendWorker::dispatch_to_sinks(const LogEntry& entry,
+                                             const char* content,
+                                             std::size_t len) {
+  std::unique_lock<std::mutex> lock;
+  if (sink_mutex_) [[unlikely]] {
+    lock = std::unique_lock<std::mutex>(*sink_mutex_);
+  }
 
-    for (const auto& sink : sinks_) {
-      FEMTOLOG_DCHECK(sink);
-      sink->on_log(*entry, format_buffer_.data(), size);
+  // Sinks of the same layout are next to each other and share its line.
+  const LayoutFunctions* line_layout = nullptr;
+  for (const auto& sink : sinks_) {
+    FEMTOLOG_DCHECK(sink);
+    const LayoutFunctions* layout = sink->layout();
+    if (!layout) {
+      sink->on_log(entry, content, len);
+      continue;
+    }
+    if (layout != line_layout) {
+      line_buffer_.clear();
+      layout->format_line(entry, content, len, &line_buffer_);
+      line_layout = layout;
     }
+    sink->on_log(entry, line_buffer_.data(), line_buffer_.size());
   }
 }
 
@@ -272,9 +684,37 @@ void BackendWorker::run_loop() {
       flush_impl();
       flush_completed_seq_.store(req, std::memory_order_release);
     }
-    const bool data_dequeued_this_iteration = read_and_process_one();
+    sync_queues();
+
+    // Visit every attached queue in turn. The per-visit budget keeps one busy
+    // producer from starving the others.
+    bool data_dequeued_this_iteration = false;
+    for (QueueCursor& cursor : queues_) {
+      data_dequeued_this_iteration |= drain_queue(&cursor, kMaxEntriesPerVisit);
+    }
+    // Suppressed calls are reported once a window, whether or not their call
+    // sites log again.
+    if (core::coarse_monotonic_ns() - suppressed_calls_reported_ns_ >=
+        kRateLimitWindowNs) [[unlikely]] {
+      data_dequeued_this_iteration |= report_suppressed_calls();
+    }
+
+    // Batch writes while entries keep coming, but flush once the queues are
+    // drained or the oldest unflushed line reaches the latency bound.
+    if (data_dequeued_this_iteration) {
+      const auto now = std::chrono::steady_clock::now();
+      if (!sinks_dirty_) {
+        sinks_dirty_ = true;
+        sinks_dirty_since_ = now;
+      } else if (now - sinks_dirty_since_ >= sink_flush_latency_) [[unlikely]] {
+        flush_sinks();
+      }
+    } else if (sinks_dirty_) {
+      flush_sinks();
+    }
     apply_polling_strategy(data_dequeued_this_iteration);
   }
+  sync_queues();
   flush_impl();
   const uint64_t req = flush_requested_seq_.load(std::memory_order_acquire);
   flush_completed_seq_.store(req, std::memory_order_release);
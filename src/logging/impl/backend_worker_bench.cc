@@ -2,12 +2,18 @@
 // This source code is licensed under the Apache License, Version 2.0
 // which can be found in the LICENSE file.
 
+#include <array>
+#include <cstdio>
 #include <limits>
 #include <memory>
+#include <string_view>
 #include <utility>
 
 #include "benchmark/benchmark.h"
+#include "femtolog/base/call_site.h"
+#include "femtolog/logging/impl/args_serializer.h"
 #include "femtolog/logging/impl/backend_worker.h"
+#include "femtolog/sinks/file_sink.h"
 #include "femtolog/sinks/null_sink.h"
 
 namespace femtolog::logging {
@@ -34,6 +40,110 @@ void backend_worker_run_loop(benchmark::State& state) {
 
 BENCHMARK(backend_worker_run_loop);
 
+// Measures how fast the backend drains pre-filled entries formatting a
+// `kPayloadLen`-character string, with the timestamp either taken at dequeue
+// time or decoded from frontend tick deltas. With `to_file`, messages go to a
+// FileSink, which the backend formats them into directly. With
+// `extra_null_sink`, a NullSink next to it makes the backend format each
+// message into its own buffer, lay out the line and hand it to on_log()
+// instead, as it did before sinks exposed their buffer.
+template <bool frontend_timestamp,
+          std::size_t kPayloadLen = 7,
+          bool to_file = false,
+          bool extra_null_sink = false>
+void backend_worker_drain_entries(benchmark::State& state) {
+  constexpr std::size_t kEntries = 1024;
+  constexpr DeserializeAndFormatFunction kDeserialize =
+      DeserializeDispatcher<false, std::string_view>::function();
+
+  BackendWorker worker;
+  FemtologOptions options;
+  options.backend_worker_cpu_affinity = std::numeric_limits<std::size_t>::max();
+
+  std::array<char, kPayloadLen> text;
+  text.fill('x');
+  const std::string_view arg(text.data(), text.size());
+
+  QueuedEntryHeader header;
+  header.call_site_index =
+      static_call_site_registration<LogLevel::kInfo, "{}", kDeserialize>
+          .index();
+  header.payload_len =
+      static_cast<uint32_t>(serialized_args_size<false>(arg));
+  char buffer[QueuedEntryHeader::kMaxSize + sizeof(std::size_t) + kPayloadLen];
+
+  SpscQueue queue;
+  queue.reserve(kEntries * sizeof(buffer));
+  queue.metadata().frontend_timestamps = frontend_timestamp;
+  worker.init(&queue, options);
+  if (to_file) {
+    constexpr const char* kPath = "/tmp/femtolog_bench/drain_entries.log";
+    std::remove(kPath);
+    worker.register_sink(std::make_unique<FileSink>(kPath));
+    if (extra_null_sink) {
+      worker.register_sink(std::make_unique<NullSink>());
+    }
+  } else {
+    worker.register_sink(std::make_unique<NullSink>());
+  }
+  worker.start();
+
+  uint64_t last_ticks = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    for (std::size_t i = 0; i < kEntries; ++i) {
+      if (frontend_timestamp) {
+        const uint64_t ticks = core::tsc_ticks();
+        header.timestamp_delta = ticks - last_ticks;
+        last_ticks = ticks;
+      }
+      serialize_args_to<false>(header.encode(buffer, frontend_timestamp), arg);
+      queue.enqueue_bytes(buffer,
+                          header.size(frontend_timestamp) + header.payload_len);
+    }
+    state.ResumeTiming();
+    worker.flush();
+  }
+  state.SetItemsProcessed(state.iterations() * kEntries);
+
+  worker.stop();
+}
+
+void backend_worker_drain_entries_backend_timestamp(benchmark::State& state) {
+  backend_worker_drain_entries<false>(state);
+}
+BENCHMARK(backend_worker_drain_entries_backend_timestamp);
+
+void backend_worker_drain_entries_frontend_tsc(benchmark::State& state) {
+  backend_worker_drain_entries<true>(state);
+}
+BENCHMARK(backend_worker_drain_entries_frontend_tsc);
+
+void backend_worker_drain_entries_512b_payload(benchmark::State& state) {
+  backend_worker_drain_entries<true, 512>(state);
+}
+BENCHMARK(backend_worker_drain_entries_512b_payload);
+
+void backend_worker_drain_entries_file_sink(benchmark::State& state) {
+  backend_worker_drain_entries<true, 64, true>(state);
+}
+BENCHMARK(backend_worker_drain_entries_file_sink);
+
+// Large messages, where copying each one once more shows. The timestamp
+// prefix is cached per second, so the message dominates the line. The work
+// happens on the backend thread, so these are timed in real time.
+void backend_worker_drain_entries_file_sink_1000b_direct(
+    benchmark::State& state) {
+  backend_worker_drain_entries<true, 1000, true>(state);
+}
+BENCHMARK(backend_worker_drain_entries_file_sink_1000b_direct)->UseRealTime();
+
+void backend_worker_drain_entries_file_sink_1000b_on_log(
+    benchmark::State& state) {
+  backend_worker_drain_entries<true, 1000, true, true>(state);
+}
+BENCHMARK(backend_worker_drain_entries_file_sink_1000b_on_log)->UseRealTime();
+
 }  // namespace
 
 }  // namespace femtolog::logging
@@ -4,15 +4,132 @@
 
 #include "femtolog/logging/impl/backend_worker.h"
 
+#include <atomic>
+#include <chrono>
 #include <limits>
 #include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
 #include <utility>
+#include <vector>
 
+#include "femtolog/base/call_site.h"
+#include "femtolog/core/base/tsc_clock.h"
+#include "femtolog/logging/impl/args_serializer.h"
 #include "femtolog/sinks/null_sink.h"
 #include "gtest/gtest.h"
 
 namespace femtolog::logging {
 
+namespace {
+
+class RecordingSink : public SinkBase {
+ public:
+  explicit RecordingSink(std::vector<std::string>* messages)
+      : messages_(messages) {}
+
+  void on_log(const LogEntry&, const char* content, std::size_t len) override {
+    messages_->emplace_back(content, len);
+  }
+
+ private:
+  std::vector<std::string>* messages_;
+};
+
+// Sink that keeps lines until flushed.
+class FlushRecordingSink : public SinkBase {
+ public:
+  void on_log(const LogEntry&, const char* content, std::size_t len) override {
+    pending_.emplace_back(content, len);
+  }
+
+  void flush() override {
+    for (std::string& line : pending_) {
+      flushed_.push_back(std::move(line));
+    }
+    pending_.clear();
+    flush_count_.fetch_add(1, std::memory_order_release);
+  }
+
+  std::size_t flush_count() const {
+    return flush_count_.load(std::memory_order_acquire);
+  }
+  const std::vector<std::string>& flushed() const { return flushed_; }
+
+ private:
+  std::vector<std::string> pending_;
+  std::vector<std::string> flushed_;
+  std::atomic<std::size_t> flush_count_ = 0;
+};
+
+// Sink whose lines the backend lays out with `layout`.
+class LaidOutSink : public RecordingSink {
+ public:
+  LaidOutSink(std::vector<std::string>* messages,
+              const LayoutFunctions* layout)
+      : RecordingSink(messages) {
+    set_layout(layout);
+  }
+};
+
+// Sink that lets the backend format messages after a prefix of its own.
+class BufferedSink : public SinkBase {
+ public:
+  explicit BufferedSink(std::vector<std::string>* lines) : lines_(lines) {}
+
+  void on_log(const LogEntry&, const char* content, std::size_t len) override {
+    lines_->push_back("on_log: " + std::string(content, len));
+  }
+
+  bool has_log_buffer() const noexcept override { return true; }
+
+  fmt::memory_buffer* begin_log(const LogEntry&) override {
+    buffer_.append(std::string_view("> "));
+    return &buffer_;
+  }
+
+  void end_log(const LogEntry&) override {
+    lines_->emplace_back(buffer_.data(), buffer_.size());
+    buffer_.clear();
+  }
+
+ private:
+  std::vector<std::string>* lines_;
+  fmt::memory_buffer buffer_;
+};
+
+// Encodes an entry of the `fmt` call site the way InternalLogger does, with
+// `timestamp_delta` only written to queues with frontend timestamps, and
+// returns its size.
+template <FixedString fmt, typename... Args>
+std::size_t enqueue_entry(SpscQueue* queue,
+                          uint64_t timestamp_delta,
+                          const Args&... args) {
+  constexpr DeserializeAndFormatFunction deserialize =
+      sizeof...(Args) == 0
+          ? nullptr
+          : DeserializeDispatcher<false,
+                                  serialized_arg_t<const Args&>...>::function();
+  QueuedEntryHeader header;
+  header.call_site_index =
+      static_call_site_registration<LogLevel::kInfo, fmt, deserialize>.index();
+  header.payload_len = static_cast<uint32_t>(
+      serialized_args_size<false, const Args&...>(args...));
+  header.timestamp_delta = timestamp_delta;
+
+  const bool has_timestamp = queue->metadata().frontend_timestamps;
+  char buffer[QueuedEntryHeader::kMaxSize + 64];
+  serialize_args_to<false, const Args&...>(
+      header.encode(buffer, has_timestamp), args...);
+  const std::size_t size = header.size(has_timestamp) + header.payload_len;
+  EXPECT_EQ(queue->wait_for_space(size), SpscQueueStatus::kOk);
+  EXPECT_EQ(queue->enqueue_bytes(buffer, size), SpscQueueStatus::kOk);
+  return size;
+}
+
+}  // namespace
+
 TEST(BackendWorkerTest, RegisterAndClearSinks) {
   BackendWorker worker;
   auto sink = std::make_unique<NullSink>();
@@ -37,4 +154,215 @@ TEST(BackendWorkerTest, CPUAffinityNoCrash) {
   worker.stop();
 }
 
+TEST(BackendWorkerTest, DrainsMultipleQueues) {
+  BackendWorker worker;
+  FemtologOptions options;
+  options.backend_worker_cpu_affinity = std::numeric_limits<std::size_t>::max();
+  worker.init(options);
+  worker.register_sink(std::make_unique<NullSink>());
+
+  SpscQueue first;
+  SpscQueue second;
+  first.reserve(1024);
+  second.reserve(1024);
+  worker.attach_queue(&first);
+  worker.attach_queue(&second);
+  EXPECT_EQ(worker.queue_count(), 2);
+
+  // Restarting must keep draining the attached queues.
+  for (int round = 0; round < 2; ++round) {
+    worker.start();
+    for (SpscQueue* queue : {&first, &second}) {
+      enqueue_entry<"message">(queue, 0);
+    }
+    worker.flush();
+    EXPECT_TRUE(first.empty());
+    EXPECT_TRUE(second.empty());
+    worker.stop();
+  }
+
+  worker.detach_queue(&first);
+  EXPECT_EQ(worker.queue_count(), 1);
+}
+
+TEST(BackendWorkerTest, ConsumesEntriesInPlaceAndAcrossWrap) {
+  BackendWorker worker;
+  FemtologOptions options;
+  options.backend_worker_cpu_affinity = std::numeric_limits<std::size_t>::max();
+  std::vector<std::string> messages;
+  worker.init(options);
+  worker.register_sink(std::make_unique<RecordingSink>(&messages));
+
+  // 26-byte entries in a 32-byte ring: all but the first wrap around the end.
+  SpscQueue queue;
+  queue.reserve(32);
+  worker.attach_queue(&queue);
+  worker.start();
+
+  constexpr std::string_view kMessages[] = {"message #0000", "message #0001",
+                                            "message #0002", "message #0003"};
+  for (std::string_view message : kMessages) {
+    ASSERT_EQ(enqueue_entry<"{}">(&queue, 0, message), 26u);
+  }
+  worker.flush();
+  worker.stop();
+
+  ASSERT_EQ(messages.size(), std::size(kMessages));
+  for (std::size_t i = 0; i < messages.size(); ++i) {
+    EXPECT_EQ(messages[i], kMessages[i]);
+  }
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(BackendWorkerTest, ResolvesCallSitesAndQueueMetadata) {
+  BackendWorker worker;
+  FemtologOptions options;
+  options.backend_worker_cpu_affinity = std::numeric_limits<std::size_t>::max();
+  worker.init(options);
+
+  struct Record {
+    std::string message;
+    uint32_t thread_id;
+    uint64_t timestamp_ns;
+    LogLevel level;
+  };
+  class MetadataSink : public SinkBase {
+   public:
+    explicit MetadataSink(std::vector<Record>* records) : records_(records) {}
+    void on_log(const LogEntry& entry,
+                const char* content,
+                std::size_t len) override {
+      records_->push_back({std::string(content, len), entry.thread_id,
+                           entry.timestamp_ns, entry.level});
+    }
+
+   private:
+    std::vector<Record>* records_;
+  };
+  std::vector<Record> records;
+  worker.register_sink(std::make_unique<MetadataSink>(&records));
+
+  SpscQueue queue;
+  queue.reserve(1024);
+  queue.metadata().thread_id = 42;
+  queue.metadata().frontend_timestamps = true;
+  worker.attach_queue(&queue);
+  worker.start();
+
+  // Timestamps are deltas against the previous entry of the queue.
+  const uint64_t first_ticks = core::tsc_ticks();
+  EXPECT_EQ(enqueue_entry<"literal message">(&queue, first_ticks),
+            5u + varint_size(first_ticks));
+  enqueue_entry<"value {}">(&queue, 1000000, 7);
+  worker.flush();
+  worker.stop();
+
+  ASSERT_EQ(records.size(), 2u);
+  EXPECT_EQ(records[0].message, "literal message");
+  EXPECT_EQ(records[1].message, "value 7");
+  for (const Record& record : records) {
+    EXPECT_EQ(record.thread_id, 42u);
+    EXPECT_EQ(record.level, LogLevel::kInfo);
+  }
+  EXPECT_GT(records[1].timestamp_ns, records[0].timestamp_ns);
+}
+
+TEST(BackendWorkerTest, FormatsIntoTheBufferOfASingleSink) {
+  BackendWorker worker;
+  FemtologOptions options;
+  options.backend_worker_cpu_affinity = std::numeric_limits<std::size_t>::max();
+  std::vector<std::string> lines;
+  worker.init(options);
+  worker.register_sink(std::make_unique<BufferedSink>(&lines));
+
+  SpscQueue queue;
+  queue.reserve(1024);
+  worker.attach_queue(&queue);
+  worker.start();
+  enqueue_entry<"literal message">(&queue, 0);
+  enqueue_entry<"value {}">(&queue, 0, 7);
+  worker.flush();
+  worker.stop();
+
+  // With a second sink, every sink gets the message through on_log().
+  std::vector<std::string> others;
+  worker.register_sink(std::make_unique<RecordingSink>(&others));
+  worker.start();
+  enqueue_entry<"value {}">(&queue, 0, 8);
+  worker.flush();
+  worker.stop();
+
+  EXPECT_EQ(lines, (std::vector<std::string>{"> literal message", "> value 7",
+                                             "on_log: value 8"}));
+  EXPECT_EQ(others, std::vector<std::string>{"value 8"});
+}
+
+TEST(BackendWorkerTest, SharesLinesBetweenSinksOfALayout) {
+  static int prefixes = 0;
+  static constexpr LayoutFunctions kLayout = {
+      [](const LogEntry&, fmt::memory_buffer* out) {
+        prefixes++;
+        out->append(std::string_view("<"));
+      },
+      [](const LogEntry&, fmt::memory_buffer* out) {
+        out->append(std::string_view(">"));
+      },
+      nullptr,
+  };
+
+  BackendWorker worker;
+  FemtologOptions options;
+  options.backend_worker_cpu_affinity = std::numeric_limits<std::size_t>::max();
+  std::vector<std::string> first;
+  std::vector<std::string> plain;
+  std::vector<std::string> second;
+  worker.init(options);
+  worker.register_sink(std::make_unique<LaidOutSink>(&first, &kLayout));
+  worker.register_sink(std::make_unique<RecordingSink>(&plain));
+  worker.register_sink(std::make_unique<LaidOutSink>(&second, &kLayout));
+
+  SpscQueue queue;
+  queue.reserve(1024);
+  worker.attach_queue(&queue);
+  worker.start();
+  enqueue_entry<"value {}">(&queue, 0, 7);
+  worker.flush();
+  worker.stop();
+
+  EXPECT_EQ(prefixes, 1);
+  EXPECT_EQ(first, std::vector<std::string>{"<value 7>"});
+  EXPECT_EQ(second, std::vector<std::string>{"<value 7>"});
+  EXPECT_EQ(plain, std::vector<std::string>{"value 7"});
+}
+
+TEST(BackendWorkerTest, FlushesSinksOnceQueuesAreDrained) {
+  BackendWorker worker;
+  FemtologOptions options;
+  options.backend_worker_cpu_affinity = std::numeric_limits<std::size_t>::max();
+  // Far beyond the test, so only the drained queue can trigger the flush.
+  options.sink_flush_latency_us = 60 * 1000 * 1000;
+  worker.init(options);
+  auto sink = std::make_shared<FlushRecordingSink>();
+  worker.register_shared_sink(sink);
+
+  SpscQueue queue;
+  queue.reserve(1024);
+  worker.attach_queue(&queue);
+  worker.start();
+  enqueue_entry<"value {}">(&queue, 0, 7);
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (sink->flush_count() == 0 &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_GT(sink->flush_count(), 0u);
+
+  // Logger::flush() leaves nothing in the sinks either.
+  enqueue_entry<"value {}">(&queue, 0, 8);
+  worker.flush();
+  EXPECT_EQ(sink->flushed(), (std::vector<std::string>{"value 7", "value 8"}));
+  worker.stop();
+}
+
 }  // namespace femtolog::logging
@@ -4,47 +4,272 @@
 
 #include "femtolog/logging/impl/internal_logger.h"
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
 #include <utility>
 
 #include "femtolog/logging/impl/backend_worker.h"
+#include "femtolog/logging/impl/shared_backend.h"
 #include "femtolog/options.h"
 
+#if FEMTOLOG_ENABLE_AVX2
+#include <immintrin.h>
+#endif
+
 namespace femtolog::logging {
 
-InternalLogger::InternalLogger() : thread_id_(current_thread_id()) {}
+namespace {
+
+std::atomic<uint64_t> next_logger_id = 1;
+
+}  // namespace
+
+InternalLogger::InternalLogger()
+    : active_queue_(&queue_),
+      thread_id_(current_thread_id()),
+      id_(next_logger_id.fetch_add(1, std::memory_order_relaxed)) {}
 
 InternalLogger::~InternalLogger() {
-  if (backend_worker_.status() == BackendWorkerStatus::kRunning) {
+  if (running_) {
     stop_worker();
   }
 }
 
 void InternalLogger::init(const FemtologOptions& options) {
   FEMTOLOG_DCHECK_GT(options.spsc_queue_size, 0);
-  queue_.reserve(options.spsc_queue_size);
+  FEMTOLOG_DCHECK(!running_) << "attempted to re-initialize while running.";
+  queue_.reserve(options.spsc_queue_size,
+                 options.queue_memory == QueueMemory::kMirrored);
   FEMTOLOG_DCHECK_GE(queue_.capacity(), options.spsc_queue_size);
 
-  if (backend_worker_.status() == BackendWorkerStatus::kUninitialized)
+  backend_mode_ = options.backend_mode;
+  if (backend_mode_ == BackendMode::kShared) {
+    SharedBackend::instance().init(options);
+  } else if (backend_worker_.status() == BackendWorkerStatus::kUninitialized)
       [[likely]] {
     backend_worker_.init(&queue_, options);
   }
   terminate_on_fatal_ = options.terminate_on_fatal;
+  timestamp_source_ = options.timestamp_source;
+  overflow_policy_ = options.overflow_policy == OverflowPolicy::kDefault
+                         ? OverflowPolicy::kDrop
+                         : options.overflow_policy;
+  overflow_spin_iterations_ = options.overflow_spin_iterations;
+  overflow_grow_max_size_ = options.overflow_grow_max_size;
+  max_message_size_ = options.max_message_size;
+  oversize_policy_ = options.oversize_policy;
+  large_message_pool_.set_max_size(options.large_message_pool_size);
 }
 
 void InternalLogger::register_sink(std::unique_ptr<SinkBase> sink) {
+  // The sinks of the shared backend are common to every shared-mode logger,
+  // so letting each thread register its own would duplicate them.
+  FEMTOLOG_DCHECK(backend_mode_ != BackendMode::kShared)
+      << "sinks of shared-mode loggers must be registered with "
+         "Logger::register_shared_sink().";
+  if (backend_mode_ == BackendMode::kShared) [[unlikely]] {
+    return;
+  }
   backend_worker_.register_sink(std::move(sink));
 }
 
 void InternalLogger::clear_sinks() {
+  FEMTOLOG_DCHECK(backend_mode_ != BackendMode::kShared)
+      << "sinks of shared-mode loggers must be cleared with "
+         "Logger::clear_shared_sinks().";
+  if (backend_mode_ == BackendMode::kShared) [[unlikely]] {
+    return;
+  }
   backend_worker_.clear_sinks();
 }
 
 void InternalLogger::start_worker() {
-  backend_worker_.start();
+  if (running_) [[unlikely]] {
+    return;
+  }
+  // No backend reads the queue yet, so its metadata can be reset along with
+  // the timestamp base of the producer.
+  QueueMetadata& metadata = queue_.metadata();
+  metadata.thread_id = thread_id_;
+  metadata.frontend_timestamps =
+      timestamp_source_ == TimestampSource::kFrontendTsc;
+  metadata.last_timestamp = 0;
+  last_timestamp_ = 0;
+
+  if (backend_mode_ == BackendMode::kShared) {
+    backend_wakeup_ = SharedBackend::instance().attach(&queue_);
+  } else {
+    backend_worker_.start();
+    backend_wakeup_ = backend_worker_.wakeup();
+  }
+  running_ = true;
 }
 
 void InternalLogger::stop_worker() {
-  backend_worker_.stop();
+  if (!running_) [[unlikely]] {
+    return;
+  }
+  running_ = false;
+  if (backend_mode_ == BackendMode::kShared) {
+    SharedBackend::instance().detach(&queue_);
+  } else {
+    backend_worker_.stop();
+  }
+
+  // Everything has been drained. Keep the grown capacity but fold the queue
+  // chain back into `queue_`.
+  if (active_queue_ != &queue_) {
+    queue_.reserve(active_queue_->capacity(), active_queue_->mirrored());
+    active_queue_ = &queue_;
+    grown_queues_.clear();
+  }
+}
+
+SuppressedCalls* InternalLogger::add_suppressed_calls(
+    uint32_t summary_call_site,
+    std::string_view format) noexcept {
+  // A thread logging to several loggers in turn finds its counter again.
+  for (const std::unique_ptr<SuppressedCalls>& calls : suppressed_calls_) {
+    if (calls->summary_call_site == summary_call_site &&
+        calls->format == format) {
+      return calls.get();
+    }
+  }
+
+  auto calls = std::make_unique<SuppressedCalls>();
+  calls->summary_call_site = summary_call_site;
+  calls->format = format;
+  std::atomic<SuppressedCalls*>& head = queue_.metadata().suppressed_calls;
+  calls->next = head.load(std::memory_order_relaxed);
+  head.store(calls.get(), std::memory_order_release);
+  suppressed_calls_.push_back(std::move(calls));
+  return suppressed_calls_.back().get();
+}
+
+void InternalLogger::flush() noexcept {
+  if (backend_mode_ == BackendMode::kShared) {
+    SharedBackend::instance().flush();
+  } else {
+    backend_worker_.flush();
+  }
+}
+
+LargeMessagePool::Buffer* InternalLogger::acquire_large_buffer(
+    std::size_t size,
+    OverflowPolicy policy) noexcept {
+  LargeMessagePool::Buffer* buffer = large_message_pool_.acquire(size);
+  if (buffer) [[likely]] {
+    return buffer;
+  }
+  if (policy == OverflowPolicy::kDefault) {
+    policy = overflow_policy_;
+  }
+  if (policy != OverflowPolicy::kBlock) {
+    return nullptr;
+  }
+  // The backend releases buffers as it formats their messages. Check for
+  // buffers in flight before acquiring, or the last ones could be released in
+  // between and never be tried. Taking the release count first makes sure a
+  // release after the failed acquire() does not go unnoticed.
+  for (;;) {
+    const uint32_t releases = large_message_pool_.release_count();
+    const bool in_flight = large_message_pool_.has_buffers_in_flight();
+    buffer = large_message_pool_.acquire(size);
+    if (buffer || !in_flight) {
+      return buffer;
+    }
+    backend_wakeup_->notify();
+    large_message_pool_.wait_for_release(releases);
+  }
+}
+
+bool InternalLogger::should_stage_entry(std::size_t entry_size,
+                                        OverflowPolicy policy) noexcept {
+  if (policy == OverflowPolicy::kDefault) {
+    policy = overflow_policy_;
+  }
+  return policy != OverflowPolicy::kDrop ||
+         active_queue_->writable_bytes() >= entry_size;
+}
+
+bool InternalLogger::enqueue_staged(const void* entry,
+                                    std::size_t entry_size,
+                                    OverflowPolicy policy) noexcept {
+  if (active_queue_->enqueue_bytes(entry, entry_size) == SpscQueueStatus::kOk)
+      [[likely]] {
+    return true;
+  }
+  return enqueue_on_overflow(entry, entry_size, policy);
+}
+
+bool InternalLogger::enqueue_on_overflow(const void* entry,
+                                         std::size_t entry_size,
+                                         OverflowPolicy policy) noexcept {
+  if (policy == OverflowPolicy::kDefault) {
+    policy = overflow_policy_;
+  }
+
+  switch (policy) {
+    case OverflowPolicy::kBlock:
+      while (true) {
+        if (active_queue_->wait_for_space(entry_size) !=
+            SpscQueueStatus::kOk) [[unlikely]] {
+          return false;
+        }
+        if (active_queue_->enqueue_bytes(entry, entry_size) ==
+            SpscQueueStatus::kOk) [[likely]] {
+          return true;
+        }
+      }
+
+    case OverflowPolicy::kSpinThenDrop:
+      for (std::size_t i = 0; i < overflow_spin_iterations_; ++i) {
+#if FEMTOLOG_ENABLE_AVX2
+        _mm_pause();
+#else
+        std::this_thread::yield();
+#endif
+        if (active_queue_->enqueue_bytes(entry, entry_size) ==
+            SpscQueueStatus::kOk) {
+          return true;
+        }
+      }
+      return false;
+
+    case OverflowPolicy::kGrow:
+      if (!grow_queue(entry_size)) {
+        return false;
+      }
+      return active_queue_->enqueue_bytes(entry, entry_size) ==
+             SpscQueueStatus::kOk;
+
+    case OverflowPolicy::kDefault:
+    case OverflowPolicy::kDrop:
+    default:
+      return false;
+  }
+}
+
+bool InternalLogger::grow_queue(std::size_t entry_size) noexcept {
+  const std::size_t new_capacity =
+      std::max(active_queue_->capacity() * 2, entry_size * 2);
+  if (new_capacity > overflow_grow_max_size_) {
+    return false;
+  }
+
+  auto next = std::make_unique<SpscQueue>();
+  next->reserve(new_capacity, active_queue_->mirrored());
+  if (next->capacity() == 0) [[unlikely]] {
+    return false;
+  }
+
+  // From here on the producer only writes to `next`; the backend switches
+  // over once it has drained the current queue.
+  active_queue_->set_successor(next.get());
+  active_queue_ = next.get();
+  grown_queues_.push_back(std::move(next));
+  return true;
 }
 
 // static
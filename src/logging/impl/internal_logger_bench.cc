@@ -2,6 +2,9 @@
 // This source code is licensed under the Apache License, Version 2.0
 // which can be found in the LICENSE file.
 
+#include <string>
+#include <string_view>
+
 #include "benchmark/benchmark.h"
 #include "femtolog/logging/impl/internal_logger.h"
 #include "femtolog/sinks/null_sink.h"
@@ -24,6 +27,24 @@ void internal_logger_literal_log(benchmark::State& state) {
 }
 BENCHMARK(internal_logger_literal_log);
 
+void internal_logger_long_literal_log(benchmark::State& state) {
+  InternalLogger logger;
+  logger.init();
+  logger.register_sink(std::make_unique<NullSink>());
+  logger.start_worker();
+
+  for (auto _ : state) {
+    logger.log<LogLevel::kInfo,
+               "Benchmark literal that is long enough to make copying its "
+               "text into the queue the dominant cost of the call, as with "
+               "the startup banners and state dumps of real services\n",
+               false>();
+  }
+
+  logger.stop_worker();
+}
+BENCHMARK(internal_logger_long_literal_log);
+
 void internal_logger_formatted_log(benchmark::State& state) {
   InternalLogger logger;
   logger.init();
@@ -36,10 +57,126 @@ void internal_logger_formatted_log(benchmark::State& state) {
     logger.log<LogLevel::kInfo, "Benchmark {} {}", false>(42, str);
   }
 
+  state.counters["enqueued count"] = logger.enqueued_count();
+  state.counters["dropped count"] = logger.dropped_count();
   logger.stop_worker();
 }
 BENCHMARK(internal_logger_formatted_log);
 
+// The same string, passed as a StaticString and as a copied std::string_view.
+template <bool literal>
+void internal_logger_string_arg(benchmark::State& state) {
+  InternalLogger logger;
+  logger.init();
+  logger.register_sink(std::make_unique<NullSink>());
+  logger.start_worker();
+
+  const std::string_view view = "authentication request";
+
+  for (auto _ : state) {
+    if constexpr (literal) {
+      logger.log<LogLevel::kInfo, "op={}", false>(
+          StaticString("authentication request"));
+    } else {
+      logger.log<LogLevel::kInfo, "op={}", false>(view);
+    }
+  }
+
+  state.counters["enqueued count"] = logger.enqueued_count();
+  logger.stop_worker();
+}
+
+void internal_logger_string_literal_arg(benchmark::State& state) {
+  internal_logger_string_arg<true>(state);
+}
+BENCHMARK(internal_logger_string_literal_arg);
+
+void internal_logger_string_view_arg(benchmark::State& state) {
+  internal_logger_string_arg<false>(state);
+}
+BENCHMARK(internal_logger_string_view_arg);
+
+// Arguments too large for a queue entry, serialized into pooled buffers.
+void internal_logger_large_message_log(benchmark::State& state) {
+  InternalLogger logger;
+  logger.init();
+  logger.register_sink(std::make_unique<NullSink>());
+  logger.start_worker();
+
+  const std::string body(static_cast<std::size_t>(state.range(0)), 'b');
+
+  for (auto _ : state) {
+    logger.log<LogLevel::kInfo, "body={}", false>(body);
+  }
+
+  state.SetBytesProcessed(static_cast<int64_t>(logger.enqueued_count()) *
+                          state.range(0));
+  state.counters["enqueued count"] = logger.enqueued_count();
+  state.counters["dropped count"] = logger.dropped_count();
+  logger.stop_worker();
+}
+BENCHMARK(internal_logger_large_message_log)->Arg(4 * 1024)->Arg(60 * 1024);
+
+void internal_logger_formatted_log_frontend_tsc(benchmark::State& state) {
+  FemtologOptions options;
+  options.timestamp_source = TimestampSource::kFrontendTsc;
+  InternalLogger logger;
+  logger.init(options);
+  logger.register_sink(std::make_unique<NullSink>());
+  logger.start_worker();
+
+  const char* str = "times";
+
+  for (auto _ : state) {
+    logger.log<LogLevel::kInfo, "Benchmark {} {}", false>(42, str);
+  }
+
+  logger.stop_worker();
+}
+BENCHMARK(internal_logger_formatted_log_frontend_tsc);
+
+// The backend cannot keep up with a 1KiB queue, so most calls overflow.
+template <OverflowPolicy policy>
+void internal_logger_overflow(benchmark::State& state) {
+  FemtologOptions options;
+  options.spsc_queue_size = 1024;
+  options.overflow_policy = policy;
+  options.overflow_spin_iterations = 64;
+  options.overflow_grow_max_size = 1024 * 1024;
+  InternalLogger logger;
+  logger.init(options);
+  logger.register_sink(std::make_unique<NullSink>());
+  logger.start_worker();
+
+  for (auto _ : state) {
+    logger.log<LogLevel::kInfo, "Benchmark {} {}", false>(42, "times");
+  }
+
+  state.counters["enqueued count"] = logger.enqueued_count();
+  state.counters["dropped count"] = logger.dropped_count();
+  logger.stop_worker();
+}
+
+void internal_logger_overflow_drop(benchmark::State& state) {
+  internal_logger_overflow<OverflowPolicy::kDrop>(state);
+}
+BENCHMARK(internal_logger_overflow_drop);
+
+void internal_logger_overflow_spin_then_drop(benchmark::State& state) {
+  internal_logger_overflow<OverflowPolicy::kSpinThenDrop>(state);
+}
+BENCHMARK(internal_logger_overflow_spin_then_drop);
+
+void internal_logger_overflow_block(benchmark::State& state) {
+  internal_logger_overflow<OverflowPolicy::kBlock>(state);
+}
+BENCHMARK(internal_logger_overflow_block);
+
+void internal_logger_overflow_grow(benchmark::State& state) {
+  internal_logger_overflow<OverflowPolicy::kGrow>(state);
+}
+BENCHMARK(internal_logger_overflow_grow);
+
 }  // namespace
 
 }  // namespace femtolog::logging
@@ -4,17 +4,22 @@
 
 #include "femtolog/logging/impl/internal_logger.h"
 
+#include <atomic>
 #include <chrono>
+#include <cstring>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <utility>
 #include <vector>
 
 #include "femtolog/base/log_entry.h"
 #include "femtolog/base/log_level.h"
+#include "femtolog/build/build_flag.h"
 #include "femtolog/options.h"
 #include "femtolog/sinks/sink_base.h"
+#include "fmt/format.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -23,6 +28,29 @@ using ::testing::_;
 using ::testing::AtLeast;
 using ::testing::StrictMock;
 
+// Sink that holds the backend until opened, so the queue fills up.
+class GatedSink : public SinkBase {
+ public:
+  struct State {
+    std::atomic<bool> open = false;
+    std::atomic<std::size_t> delivered = 0;
+    std::vector<std::string> messages;
+  };
+
+  explicit GatedSink(State* state) : state_(state) {}
+
+  void on_log(const LogEntry&, const char* content, std::size_t len) override {
+    while (!state_->open.load(std::memory_order_acquire)) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    state_->messages.emplace_back(content, len);
+    state_->delivered.fetch_add(1, std::memory_order_release);
+  }
+
+ private:
+  State* state_;
+};
+
 // Mock Sink class for testing
 class MockSink : public SinkBase {
  public:
@@ -157,6 +185,80 @@ TEST_F(InternalLoggerTest, LiteralStringLogging) {
   EXPECT_EQ(log_data.thread_id, logger_->thread_id());
 }
 
+TEST_F(InternalLoggerTest, LiteralsAreEnqueuedAsHeaderOnly) {
+  logger_->init();
+
+  std::size_t payload_len = 1;
+  const CallSite* call_site = nullptr;
+  EXPECT_CALL(*mock_sink_ptr_, on_log(_, _, _))
+      .WillOnce([&](const LogEntry& entry, const char* content,
+                    std::size_t len) {
+        payload_len = entry.payload_len;
+        call_site = entry.call_site;
+        mock_sink_ptr_->capture_log(entry, content, len);
+      });
+
+  logger_->register_sink(std::move(mock_sink_));
+  logger_->start_worker();
+  logger_->log<LogLevel::kInfo, "Header only message\n", false>();
+  logger_->stop_worker();
+
+  ASSERT_EQ(mock_sink_ptr_->captured_logs.size(), 1);
+  EXPECT_EQ(mock_sink_ptr_->captured_logs[0].message, "Header only message\n");
+  EXPECT_EQ(payload_len, 0u);
+  ASSERT_NE(call_site, nullptr);
+  EXPECT_TRUE(call_site->is_literal());
+  EXPECT_EQ(call_site->format, "Header only message\n");
+}
+
+TEST_F(InternalLoggerTest, StaticStringArgumentsAreNotCopied) {
+  logger_->init();
+
+  std::size_t payload_len = 0;
+  EXPECT_CALL(*mock_sink_ptr_, on_log(_, _, _))
+      .WillOnce([&](const LogEntry& entry, const char* content,
+                    std::size_t len) {
+        payload_len = entry.payload_len;
+        mock_sink_ptr_->capture_log(entry, content, len);
+      });
+
+  logger_->register_sink(std::move(mock_sink_));
+  logger_->start_worker();
+  static constexpr std::string_view kKind = "interactive session";
+  logger_->log<LogLevel::kInfo, "op={} kind={}\n", false>(
+      StaticString("authentication request"), StaticString(kKind));
+  logger_->stop_worker();
+
+  ASSERT_EQ(mock_sink_ptr_->captured_logs.size(), 1);
+  EXPECT_EQ(mock_sink_ptr_->captured_logs[0].message,
+            "op=authentication request kind=interactive session\n");
+  // A pointer and a one-byte length each.
+  EXPECT_EQ(payload_len, 2 * (sizeof(uintptr_t) + 1));
+}
+
+TEST_F(InternalLoggerTest, ConstCharArraysAreCopied) {
+  GatedSink::State state;
+  logger_->init();
+  logger_->register_sink(std::make_unique<GatedSink>(&state));
+  logger_->start_worker();
+
+  // The backend blocks in the sink on the first entry, so the second one is
+  // only formatted after its argument has been overwritten, like a local
+  // buffer whose frame is gone.
+  char storage[32] = "stack contents";
+  const char(&local)[32] = storage;
+  logger_->log<LogLevel::kInfo, "held", false>();
+  logger_->log<LogLevel::kInfo, "local={}", false>(local);
+  std::strcpy(storage, "overwritten");
+
+  state.open.store(true, std::memory_order_release);
+  logger_->flush();
+  logger_->stop_worker();
+
+  ASSERT_EQ(state.messages.size(), 2);
+  EXPECT_EQ(state.messages[1], "local=stack contents");
+}
+
 // Test parameterized logging
 TEST_F(InternalLoggerTest, ParameterizedLogging) {
   logger_->init();
@@ -184,6 +286,76 @@ TEST_F(InternalLoggerTest, ParameterizedLogging) {
   EXPECT_EQ(log_data.thread_id, logger_->thread_id());
 }
 
+// Test that frontend timestamps reflect the call time, not the dequeue time
+TEST_F(InternalLoggerTest, FrontendTscTimestamps) {
+  FemtologOptions options;
+  options.timestamp_source = TimestampSource::kFrontendTsc;
+  logger_->init(options);
+
+  // Stall the backend on the first entry so the second one sits in the queue.
+  EXPECT_CALL(*mock_sink_ptr_, on_log(_, _, _))
+      .Times(2)
+      .WillRepeatedly(
+          [this](const LogEntry& entry, const char* content, std::size_t len) {
+            mock_sink_ptr_->capture_log(entry, content, len);
+            if (mock_sink_ptr_->captured_logs.size() == 1) {
+              std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            }
+          });
+
+  logger_->register_sink(std::move(mock_sink_));
+  logger_->start_worker();
+
+  const uint64_t before = timestamp_ns();
+  logger_->log<LogLevel::kInfo, "first", false>();
+  logger_->log<LogLevel::kInfo, "second {}", false>(2);
+  const uint64_t after = timestamp_ns();
+
+  logger_->stop_worker();
+
+  ASSERT_EQ(mock_sink_ptr_->captured_logs.size(), 2);
+  constexpr uint64_t kToleranceNs = 10000000;
+  for (const auto& log_data : mock_sink_ptr_->captured_logs) {
+    EXPECT_GE(log_data.timestamp_ns, before - kToleranceNs);
+    EXPECT_LE(log_data.timestamp_ns, after + kToleranceNs);
+  }
+  EXPECT_LT(mock_sink_ptr_->captured_logs[1].timestamp_ns -
+                mock_sink_ptr_->captured_logs[0].timestamp_ns,
+            25000000u);
+}
+
+// Timestamps are delta-encoded; restarting must restart the base on both
+// sides of the queue.
+TEST_F(InternalLoggerTest, FrontendTscTimestampsAcrossRestarts) {
+  FemtologOptions options;
+  options.timestamp_source = TimestampSource::kFrontendTsc;
+  logger_->init(options);
+
+  EXPECT_CALL(*mock_sink_ptr_, on_log(_, _, _))
+      .Times(3)
+      .WillRepeatedly(
+          [this](const LogEntry& entry, const char* content, std::size_t len) {
+            mock_sink_ptr_->capture_log(entry, content, len);
+          });
+  logger_->register_sink(std::move(mock_sink_));
+
+  const uint64_t before = timestamp_ns();
+  for (int round = 0; round < 3; ++round) {
+    logger_->start_worker();
+    logger_->log<LogLevel::kInfo, "round {}", false>(round);
+    logger_->stop_worker();
+  }
+  const uint64_t after = timestamp_ns();
+
+  ASSERT_EQ(mock_sink_ptr_->captured_logs.size(), 3);
+  constexpr uint64_t kToleranceNs = 10000000;
+  for (const auto& log_data : mock_sink_ptr_->captured_logs) {
+    EXPECT_GE(log_data.timestamp_ns, before - kToleranceNs);
+    EXPECT_LE(log_data.timestamp_ns, after + kToleranceNs);
+    EXPECT_EQ(log_data.thread_id, logger_->thread_id());
+  }
+}
+
 // Test log level filtering
 TEST_F(InternalLoggerTest, LogLevelFiltering) {
   logger_->init();
@@ -345,6 +517,268 @@ TEST_F(InternalLoggerTest, ThreadIdConsistency) {
   EXPECT_EQ(mock_sink_ptr_->captured_logs[0].thread_id, logger_thread_id);
 }
 
+TEST_F(InternalLoggerTest, EventDrivenBackendWakesUpOnFirstMessage) {
+  GatedSink::State state;
+  state.open.store(true, std::memory_order_relaxed);
+  FemtologOptions options;
+  options.backend_wait_strategy = BackendWaitStrategy::kEventDriven;
+  options.backend_spin_iterations = 16;
+  // Long enough that only a producer signal can deliver in time.
+  options.backend_park_timeout_us = 10 * 1000 * 1000;
+  logger_->init(options);
+  logger_->register_sink(std::make_unique<GatedSink>(&state));
+  logger_->start_worker();
+
+  // Let the backend park.
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  logger_->log<LogLevel::kInfo, "first after idle", false>();
+
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(2);
+  while (state.delivered.load(std::memory_order_acquire) == 0 &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  EXPECT_EQ(state.delivered.load(std::memory_order_acquire), 1);
+
+  logger_->stop_worker();
+  ASSERT_EQ(state.messages.size(), 1);
+  EXPECT_EQ(state.messages[0], "first after idle");
+}
+
+FemtologOptions small_queue_options(OverflowPolicy policy) {
+  FemtologOptions options;
+  options.spsc_queue_size = 1024;
+  options.overflow_policy = policy;
+  return options;
+}
+
+TEST_F(InternalLoggerTest, OverflowDropsByDefault) {
+  GatedSink::State state;
+  logger_->init(small_queue_options(OverflowPolicy::kDrop));
+  logger_->register_sink(std::make_unique<GatedSink>(&state));
+  logger_->start_worker();
+
+  for (int i = 0; i < 200; ++i) {
+    logger_->log<LogLevel::kInfo, "message {}", false>(i);
+  }
+  EXPECT_GT(logger_->dropped_count(), 0);
+  EXPECT_EQ(logger_->enqueued_count() + logger_->dropped_count(), 200);
+
+  state.open.store(true, std::memory_order_release);
+  logger_->stop_worker();
+  EXPECT_EQ(state.messages.size(), logger_->enqueued_count());
+}
+
+TEST_F(InternalLoggerTest, MirroredQueueDeliversWrappedEntriesInOrder) {
+  GatedSink::State state;
+  state.open.store(true, std::memory_order_relaxed);
+  FemtologOptions options = small_queue_options(OverflowPolicy::kBlock);
+  options.queue_memory = QueueMemory::kMirrored;
+  logger_->init(options);
+  logger_->register_sink(std::make_unique<GatedSink>(&state));
+  logger_->start_worker();
+  EXPECT_EQ(logger_->queue().mirrored(), FEMTOLOG_IS_LINUX);
+
+  // Enough data to wrap around the queue many times.
+  constexpr int kMessages = 2000;
+  for (int i = 0; i < kMessages; ++i) {
+    logger_->log<LogLevel::kInfo, "message {} {}", false>(i, "padding");
+  }
+  logger_->stop_worker();
+
+  EXPECT_EQ(logger_->dropped_count(), 0);
+  ASSERT_EQ(state.messages.size(), kMessages);
+  for (int i = 0; i < kMessages; ++i) {
+    EXPECT_EQ(state.messages[i], fmt::format("message {} padding", i));
+  }
+}
+
+TEST_F(InternalLoggerTest, OverflowSpinThenDropIsBounded) {
+  GatedSink::State state;
+  FemtologOptions options = small_queue_options(OverflowPolicy::kSpinThenDrop);
+  options.overflow_spin_iterations = 16;
+  logger_->init(options);
+  logger_->register_sink(std::make_unique<GatedSink>(&state));
+  logger_->start_worker();
+
+  for (int i = 0; i < 200; ++i) {
+    logger_->log<LogLevel::kInfo, "message {}", false>(i);
+  }
+  EXPECT_GT(logger_->dropped_count(), 0);
+
+  state.open.store(true, std::memory_order_release);
+  logger_->stop_worker();
+  EXPECT_EQ(state.messages.size(), logger_->enqueued_count());
+}
+
+TEST_F(InternalLoggerTest, OverflowBlockDeliversEverything) {
+  GatedSink::State state;
+  logger_->init(small_queue_options(OverflowPolicy::kBlock));
+  logger_->register_sink(std::make_unique<GatedSink>(&state));
+  logger_->start_worker();
+
+  std::thread opener([&state]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    state.open.store(true, std::memory_order_release);
+  });
+  for (int i = 0; i < 200; ++i) {
+    logger_->log<LogLevel::kInfo, "message {}", false>(i);
+  }
+  opener.join();
+  logger_->stop_worker();
+
+  EXPECT_EQ(logger_->dropped_count(), 0);
+  ASSERT_EQ(state.messages.size(), 200);
+  EXPECT_EQ(state.messages.front(), "message 0");
+  EXPECT_EQ(state.messages.back(), "message 199");
+}
+
+TEST_F(InternalLoggerTest, OverflowGrowKeepsOrder) {
+  GatedSink::State state;
+  logger_->init(small_queue_options(OverflowPolicy::kGrow));
+  logger_->register_sink(std::make_unique<GatedSink>(&state));
+  logger_->start_worker();
+
+  for (int i = 0; i < 200; ++i) {
+    logger_->log<LogLevel::kInfo, "message {}", false>(i);
+  }
+  EXPECT_EQ(logger_->dropped_count(), 0);
+
+  state.open.store(true, std::memory_order_release);
+  logger_->stop_worker();
+
+  ASSERT_EQ(state.messages.size(), 200);
+  for (int i = 0; i < 200; ++i) {
+    EXPECT_EQ(state.messages[i], "message " + std::to_string(i));
+  }
+  // The grown capacity is kept for the next run.
+  EXPECT_GT(logger_->queue().capacity(), 1024);
+}
+
+TEST_F(InternalLoggerTest, OverflowGrowRespectsMaxSize) {
+  GatedSink::State state;
+  FemtologOptions options = small_queue_options(OverflowPolicy::kGrow);
+  options.overflow_grow_max_size = 2048;
+  logger_->init(options);
+  logger_->register_sink(std::make_unique<GatedSink>(&state));
+  logger_->start_worker();
+
+  // More than 2048 bytes of entries.
+  for (int i = 0; i < 400; ++i) {
+    logger_->log<LogLevel::kInfo, "message {}", false>(i);
+  }
+  EXPECT_GT(logger_->dropped_count(), 0);
+
+  state.open.store(true, std::memory_order_release);
+  logger_->stop_worker();
+  EXPECT_EQ(state.messages.size(), logger_->enqueued_count());
+}
+
+TEST_F(InternalLoggerTest, OverflowPolicyPerCall) {
+  GatedSink::State state;
+  logger_->init(small_queue_options(OverflowPolicy::kDrop));
+  logger_->register_sink(std::make_unique<GatedSink>(&state));
+  logger_->start_worker();
+
+  std::thread opener([&state]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    state.open.store(true, std::memory_order_release);
+  });
+  for (int i = 0; i < 200; ++i) {
+    logger_->log_with_policy<LogLevel::kInfo, "message {}", false,
+                             OverflowPolicy::kBlock>(i);
+  }
+  opener.join();
+  logger_->stop_worker();
+
+  EXPECT_EQ(logger_->dropped_count(), 0);
+  EXPECT_EQ(state.messages.size(), 200);
+}
+
+TEST_F(InternalLoggerTest, LargeMessagesAreTakenOutOfLine) {
+  GatedSink::State state;
+  state.open.store(true);
+  logger_->init(small_queue_options(OverflowPolicy::kDrop));
+  logger_->register_sink(std::make_unique<GatedSink>(&state));
+  logger_->start_worker();
+
+  // Larger than the whole queue.
+  const std::string statement(40 * 1024, 's');
+  for (int i = 0; i < 3; ++i) {
+    logger_->log<LogLevel::kInfo, "sql={} rows={}\n", false>(statement, i);
+    logger_->flush();
+  }
+  logger_->stop_worker();
+
+  EXPECT_EQ(logger_->dropped_count(), 0);
+  ASSERT_EQ(state.messages.size(), 3);
+  EXPECT_EQ(state.messages[2], "sql=" + statement + " rows=2\n");
+}
+
+TEST_F(InternalLoggerTest, OversizedMessagesAreDroppedByDefault) {
+  GatedSink::State state;
+  state.open.store(true);
+  FemtologOptions options;
+  options.max_message_size = 4096;
+  logger_->init(options);
+  logger_->register_sink(std::make_unique<GatedSink>(&state));
+  logger_->start_worker();
+
+  logger_->log<LogLevel::kInfo, "body={}\n", false>(std::string(8192, 'b'));
+  logger_->stop_worker();
+
+  EXPECT_EQ(logger_->dropped_count(), 1);
+  EXPECT_TRUE(state.messages.empty());
+}
+
+TEST_F(InternalLoggerTest, OversizedMessagesAreTruncated) {
+  GatedSink::State state;
+  state.open.store(true);
+  FemtologOptions options;
+  options.max_message_size = 4096;
+  options.oversize_policy = OversizePolicy::kTruncate;
+  logger_->init(options);
+  logger_->register_sink(std::make_unique<GatedSink>(&state));
+  logger_->start_worker();
+
+  logger_->log<LogLevel::kInfo, "tag={} body={} id={}\n", false>(
+      std::string("short"), std::string(8192, 'b'), 7);
+  logger_->stop_worker();
+
+  EXPECT_EQ(logger_->dropped_count(), 0);
+  ASSERT_EQ(state.messages.size(), 1);
+  // Only the longest string is cut, by as much as the message is over.
+  const std::size_t kept = 4096 - (sizeof(std::size_t) + 5) -
+                           sizeof(std::size_t) - sizeof(int);
+  EXPECT_EQ(state.messages[0], "tag=short body=" + std::string(kept, 'b') +
+                                   " id=7 [truncated]\n");
+}
+
+TEST_F(InternalLoggerTest, LargeMessagesWaitForBuffersUnderBlock) {
+  GatedSink::State state;
+  FemtologOptions options = small_queue_options(OverflowPolicy::kBlock);
+  options.large_message_pool_size = 16 * 1024;
+  logger_->init(options);
+  logger_->register_sink(std::make_unique<GatedSink>(&state));
+  logger_->start_worker();
+
+  std::thread opener([&state]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    state.open.store(true, std::memory_order_release);
+  });
+  const std::string body(6000, 'b');
+  for (int i = 0; i < 20; ++i) {
+    logger_->log<LogLevel::kInfo, "{} {}", false>(i, body);
+  }
+  opener.join();
+  logger_->stop_worker();
+
+  EXPECT_EQ(logger_->dropped_count(), 0);
+  ASSERT_EQ(state.messages.size(), 20);
+  EXPECT_EQ(state.messages.back(), "19 " + body);
+}
+
 // Integration test with realistic scenario
 TEST_F(InternalLoggerTest, RealisticLoggingScenario) {
   logger_->init();
@@ -0,0 +1,133 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#include "femtolog/logging/impl/large_message_pool.h"
+
+#include <algorithm>
+#include <bit>
+#include <new>
+
+#include "femtolog/core/check.h"
+
+namespace femtolog::logging {
+
+namespace {
+
+// Small enough messages share one size class, so buffers are reused often.
+constexpr const std::size_t kMinBufferCapacity = 1024 * 4;
+
+}  // namespace
+
+LargeMessagePool::~LargeMessagePool() {
+  reclaim();
+  FEMTOLOG_DCHECK_EQ(allocated_count_, free_count_)
+      << "destroyed a pool whose buffers are still in flight.";
+  while (free_list_) {
+    Buffer* next = free_list_->next;
+    deallocate(free_list_);
+    free_list_ = next;
+  }
+}
+
+LargeMessagePool::Buffer* LargeMessagePool::acquire(std::size_t size) noexcept {
+  auto take_first_fit = [this, size]() -> Buffer* {
+    for (Buffer** link = &free_list_; *link; link = &(*link)->next) {
+      Buffer* buffer = *link;
+      if (buffer->capacity >= size) {
+        *link = buffer->next;
+        free_count_--;
+        return buffer;
+      }
+    }
+    return nullptr;
+  };
+
+  Buffer* buffer = take_first_fit();
+  if (!buffer) {
+    reclaim();
+    buffer = take_first_fit();
+  }
+  if (buffer) {
+    return buffer;
+  }
+
+  const std::size_t capacity =
+      std::max(std::bit_ceil(size), kMinBufferCapacity);
+  // The free buffers are all too small; give their memory back first.
+  while (allocated_size_ + capacity > max_size_ && free_list_) {
+    Buffer* next = free_list_->next;
+    deallocate(free_list_);
+    free_list_ = next;
+    free_count_--;
+  }
+  // A single buffer is allowed to exceed the maximum, so that any message
+  // can eventually get one.
+  if (allocated_size_ != 0 && allocated_size_ + capacity > max_size_) {
+    return nullptr;
+  }
+
+  void* memory = ::operator new(sizeof(Buffer) + capacity, std::nothrow);
+  if (!memory) [[unlikely]] {
+    return nullptr;
+  }
+  buffer = new (memory) Buffer{nullptr, this, capacity, 0};
+  allocated_size_ += capacity;
+  allocated_count_++;
+  return buffer;
+}
+
+bool LargeMessagePool::has_buffers_in_flight() noexcept {
+  reclaim();
+  return allocated_count_ > free_count_;
+}
+
+void LargeMessagePool::wait_for_release(uint32_t seen) noexcept {
+  // Pairs with the fence in release(): either the backend sees the flag, or
+  // this thread sees the new count.
+  producer_waiting_.store(true, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  while (release_count_.load(std::memory_order_acquire) == seen) {
+    release_count_.wait(seen, std::memory_order_acquire);
+  }
+  producer_waiting_.store(false, std::memory_order_relaxed);
+}
+
+// static
+void LargeMessagePool::release(Buffer* buffer) noexcept {
+  FEMTOLOG_DCHECK(buffer);
+  LargeMessagePool* pool = buffer->pool;
+  std::atomic<Buffer*>& released = pool->released_;
+  buffer->next = released.load(std::memory_order_relaxed);
+  while (!released.compare_exchange_weak(buffer->next, buffer,
+                                         std::memory_order_release,
+                                         std::memory_order_relaxed)) {
+  }
+
+  pool->release_count_.fetch_add(1, std::memory_order_release);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (pool->producer_waiting_.load(std::memory_order_relaxed)) [[unlikely]] {
+    pool->release_count_.notify_one();
+  }
+}
+
+void LargeMessagePool::reclaim() noexcept {
+  Buffer* buffer = released_.exchange(nullptr, std::memory_order_acquire);
+  while (buffer) {
+    Buffer* next = buffer->next;
+    buffer->next = free_list_;
+    free_list_ = buffer;
+    free_count_++;
+    buffer = next;
+  }
+}
+
+void LargeMessagePool::deallocate(Buffer* buffer) noexcept {
+  allocated_size_ -= buffer->capacity;
+  allocated_count_--;
+  buffer->~Buffer();
+  ::operator delete(buffer);
+}
+
+}  // namespace femtolog::logging
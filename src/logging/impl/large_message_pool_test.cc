@@ -0,0 +1,121 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#include "femtolog/logging/impl/large_message_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace femtolog::logging {
+
+namespace {
+
+TEST(LargeMessagePoolTest, ReusesReleasedBuffers) {
+  LargeMessagePool pool;
+  pool.set_max_size(1024 * 1024);
+
+  LargeMessagePool::Buffer* buffer = pool.acquire(5000);
+  ASSERT_NE(buffer, nullptr);
+  EXPECT_GE(buffer->capacity, 5000u);
+  EXPECT_TRUE(pool.has_buffers_in_flight());
+  const std::size_t allocated = pool.allocated_size();
+
+  LargeMessagePool::release(buffer);
+  EXPECT_FALSE(pool.has_buffers_in_flight());
+  // A smaller message fits in the same buffer.
+  EXPECT_EQ(pool.acquire(2000), buffer);
+  EXPECT_EQ(pool.allocated_size(), allocated);
+  LargeMessagePool::release(buffer);
+}
+
+TEST(LargeMessagePoolTest, RespectsMaxSize) {
+  LargeMessagePool pool;
+  pool.set_max_size(16 * 1024);
+
+  LargeMessagePool::Buffer* first = pool.acquire(8 * 1024);
+  LargeMessagePool::Buffer* second = pool.acquire(8 * 1024);
+  ASSERT_NE(first, nullptr);
+  ASSERT_NE(second, nullptr);
+  EXPECT_EQ(pool.acquire(8 * 1024), nullptr);
+
+  // Free buffers that are too small make room for a larger one.
+  LargeMessagePool::release(first);
+  LargeMessagePool::release(second);
+  LargeMessagePool::Buffer* large = pool.acquire(16 * 1024);
+  ASSERT_NE(large, nullptr);
+  EXPECT_EQ(pool.allocated_size(), 16u * 1024);
+  LargeMessagePool::release(large);
+}
+
+TEST(LargeMessagePoolTest, AlwaysAllowsOneBuffer) {
+  LargeMessagePool pool;
+  pool.set_max_size(1024);
+
+  LargeMessagePool::Buffer* buffer = pool.acquire(64 * 1024);
+  ASSERT_NE(buffer, nullptr);
+  EXPECT_EQ(pool.acquire(64 * 1024), nullptr);
+  LargeMessagePool::release(buffer);
+}
+
+TEST(LargeMessagePoolTest, BuffersReturnFromAnotherThread) {
+  LargeMessagePool pool;
+  pool.set_max_size(64 * 1024);
+
+  std::vector<LargeMessagePool::Buffer*> buffers;
+  while (LargeMessagePool::Buffer* buffer = pool.acquire(4096)) {
+    buffers.push_back(buffer);
+  }
+  ASSERT_EQ(buffers.size(), 16u);
+
+  std::thread backend([&buffers]() {
+    for (LargeMessagePool::Buffer* buffer : buffers) {
+      LargeMessagePool::release(buffer);
+    }
+  });
+  backend.join();
+
+  EXPECT_FALSE(pool.has_buffers_in_flight());
+  for (std::size_t i = 0; i < buffers.size(); ++i) {
+    EXPECT_NE(pool.acquire(4096), nullptr);
+  }
+  EXPECT_EQ(pool.allocated_size(), 64u * 1024);
+  // Leave them to the destructor, which owns every buffer once released.
+  for (LargeMessagePool::Buffer* buffer : buffers) {
+    LargeMessagePool::release(buffer);
+  }
+}
+
+TEST(LargeMessagePoolTest, WaitForReleaseParksUntilARelease) {
+  LargeMessagePool pool;
+  pool.set_max_size(4096);
+
+  LargeMessagePool::Buffer* buffer = pool.acquire(4096);
+  ASSERT_NE(buffer, nullptr);
+  const uint32_t seen = pool.release_count();
+  ASSERT_EQ(pool.acquire(4096), nullptr);
+
+  std::atomic<bool> released = false;
+  std::thread backend([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    released.store(true, std::memory_order_relaxed);
+    LargeMessagePool::release(buffer);
+  });
+  pool.wait_for_release(seen);
+  EXPECT_TRUE(released.load(std::memory_order_relaxed));
+  EXPECT_NE(pool.release_count(), seen);
+  EXPECT_EQ(pool.acquire(4096), buffer);
+  backend.join();
+
+  // A release the producer already missed does not block.
+  LargeMessagePool::release(buffer);
+  pool.wait_for_release(seen);
+}
+
+}  // namespace
+
+}  // namespace femtolog::logging
@@ -0,0 +1,48 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#include "femtolog/logging/impl/rate_limiter.h"
+
+#include <cstddef>
+
+#include "benchmark/benchmark.h"
+#include "femtolog/core/base/tsc_clock.h"
+
+namespace femtolog::logging {
+
+namespace {
+
+// Cost of the admission check alone, on the suppressing path where it runs
+// most of the time.
+
+void rate_limiter_every_n(benchmark::State& state) {
+  auto& limiter =
+      call_site_limiter<LogLevel::kInfo, "every n\n", EveryNLimiter<1000>>;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(limiter.admit());
+  }
+}
+BENCHMARK(rate_limiter_every_n);
+
+void rate_limiter_at_most(benchmark::State& state) {
+  auto& limiter =
+      call_site_limiter<LogLevel::kInfo, "at most\n", AtMostLimiter<100>>;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(limiter.admit(core::coarse_monotonic_ns()));
+  }
+}
+BENCHMARK(rate_limiter_at_most);
+
+void rate_limiter_sampled(benchmark::State& state) {
+  auto& limiter =
+      call_site_limiter<LogLevel::kInfo, "sampled\n", SampledLimiter<0.01>>;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(limiter.admit());
+  }
+}
+BENCHMARK(rate_limiter_sampled);
+
+}  // namespace
+
+}  // namespace femtolog::logging
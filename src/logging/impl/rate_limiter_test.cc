@@ -0,0 +1,96 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#include "femtolog/logging/impl/rate_limiter.h"
+
+#include <cstddef>
+#include <string_view>
+
+#include "gtest/gtest.h"
+
+namespace femtolog::logging {
+
+namespace {
+
+constexpr uint64_t kSecond = AtMostLimiter<1>::kWindowNs;
+
+TEST(RateLimiterTest, EveryNAdmitsFirstAndEveryNth) {
+  EveryNLimiter<3> limiter;
+  const bool expected[] = {true, false, false, true, false, false, true};
+  for (bool admitted : expected) {
+    EXPECT_EQ(limiter.admit(), admitted);
+  }
+
+  EveryNLimiter<1> every_call;
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(every_call.admit());
+  }
+}
+
+TEST(RateLimiterTest, AtMostLimitsEachWindow) {
+  AtMostLimiter<2> limiter;
+  const uint64_t begin = 5 * kSecond;
+
+  EXPECT_TRUE(limiter.admit(begin));
+  EXPECT_TRUE(limiter.admit(begin + 1));
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_FALSE(limiter.admit(begin + kSecond - 1));
+  }
+
+  EXPECT_TRUE(limiter.admit(begin + kSecond));
+  EXPECT_TRUE(limiter.admit(begin + kSecond + 1));
+  EXPECT_FALSE(limiter.admit(begin + kSecond + 2));
+  EXPECT_TRUE(limiter.admit(begin + 10 * kSecond));
+}
+
+TEST(RateLimiterTest, AtMostKeepsTheSuppressedCallsOfOneLogger) {
+  AtMostLimiter<1> limiter;
+  SuppressedCalls calls;
+  EXPECT_EQ(limiter.suppressed_calls(1), nullptr);
+
+  limiter.set_suppressed_calls(1, &calls);
+  EXPECT_EQ(limiter.suppressed_calls(1), &calls);
+  EXPECT_EQ(limiter.suppressed_calls(2), nullptr);
+
+  calls.add();
+  calls.add();
+  EXPECT_EQ(calls.count.load(), 2u);
+}
+
+TEST(RateLimiterTest, SampledHonorsProbability) {
+  SampledLimiter<0.0> never;
+  SampledLimiter<1.0> always;
+  SampledLimiter<0.25> quarter;
+
+  constexpr int kCalls = 100000;
+  int admitted = 0;
+  for (int i = 0; i < kCalls; ++i) {
+    EXPECT_FALSE(never.admit());
+    EXPECT_TRUE(always.admit());
+    admitted += quarter.admit();
+  }
+  EXPECT_NEAR(static_cast<double>(admitted) / kCalls, 0.25, 0.01);
+}
+
+TEST(RateLimiterTest, CallSiteLimitersAreDistinct) {
+  auto& a = call_site_limiter<LogLevel::kInfo, "a {}\n", EveryNLimiter<2>>;
+  auto& b = call_site_limiter<LogLevel::kInfo, "b {}\n", EveryNLimiter<2>>;
+  auto& a_warn =
+      call_site_limiter<LogLevel::kWarn, "a {}\n", EveryNLimiter<2>>;
+  EXPECT_NE(&a, &b);
+  EXPECT_NE(&a, &a_warn);
+  EXPECT_EQ(&a, (&call_site_limiter<LogLevel::kInfo, "a {}\n",
+                                    EveryNLimiter<2>>));
+}
+
+TEST(RateLimiterTest, FormatWithoutNewline) {
+  EXPECT_EQ(format_without_newline<"value: {}\n">(),
+            std::string_view("value: {}"));
+  EXPECT_EQ(format_without_newline<"value: {}">(),
+            std::string_view("value: {}"));
+}
+
+}  // namespace
+
+}  // namespace femtolog::logging
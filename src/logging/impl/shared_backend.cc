@@ -0,0 +1,148 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#include "femtolog/logging/impl/shared_backend.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include "femtolog/core/check.h"
+
+namespace femtolog::logging {
+
+SharedBackend::SharedBackend() = default;
+
+SharedBackend::~SharedBackend() = default;
+
+// static
+SharedBackend& SharedBackend::instance() {
+  // Intentionally leaked: loggers with static or thread storage duration may
+  // detach from the pool after function-local statics have been destroyed.
+  static SharedBackend* instance = new SharedBackend();
+  return *instance;
+}
+
+void SharedBackend::init(const FemtologOptions& options) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!workers_.empty()) {
+    return;
+  }
+
+  const std::size_t count = std::max<std::size_t>(
+      options.shared_backend_worker_count, static_cast<std::size_t>(1));
+  workers_.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    FemtologOptions worker_options = options;
+    if (options.backend_worker_cpu_affinity !=
+        std::numeric_limits<std::size_t>::max()) {
+      worker_options.backend_worker_cpu_affinity += i;
+    }
+    auto worker = std::make_unique<BackendWorker>();
+    worker->init(worker_options);
+    if (count > 1) {
+      worker->set_sink_mutex(&sink_mutex_);
+    }
+    workers_.push_back(std::move(worker));
+  }
+}
+
+void SharedBackend::register_sink(std::unique_ptr<SinkBase> sink) {
+  FEMTOLOG_DCHECK(sink);
+  std::lock_guard<std::mutex> lock(mutex_);
+  FEMTOLOG_DCHECK(!running_)
+      << "attempted to register new sink while the shared backend is running.";
+  if (running_) [[unlikely]] {
+    return;
+  }
+  sinks_.push_back(std::shared_ptr<SinkBase>(std::move(sink)));
+}
+
+void SharedBackend::clear_sinks() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  FEMTOLOG_DCHECK(!running_)
+      << "attempted to clear all sinks while the shared backend is running.";
+  if (running_) [[unlikely]] {
+    return;
+  }
+  sinks_.clear();
+}
+
+BackendWakeup* SharedBackend::attach(SpscQueue* queue) {
+  FEMTOLOG_DCHECK(queue);
+  std::lock_guard<std::mutex> lock(mutex_);
+  FEMTOLOG_DCHECK(!workers_.empty()) << "shared backend is not initialized.";
+  FEMTOLOG_DCHECK(!assignments_.contains(queue));
+
+  // Hand the queue to the least loaded worker.
+  BackendWorker* target = workers_.front().get();
+  for (const auto& worker : workers_) {
+    if (worker->queue_count() < target->queue_count()) {
+      target = worker.get();
+    }
+  }
+  target->attach_queue(queue);
+  assignments_.emplace(queue, target);
+
+  if (!running_) {
+    start_workers();
+  }
+  return target->wakeup();
+}
+
+void SharedBackend::detach(SpscQueue* queue) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto it = assignments_.find(queue);
+  if (it == assignments_.end()) [[unlikely]] {
+    return;
+  }
+  it->second->detach_queue(queue);
+  assignments_.erase(it);
+
+  if (assignments_.empty() && running_) {
+    stop_workers();
+  }
+}
+
+void SharedBackend::flush() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& worker : workers_) {
+    worker->flush();
+  }
+}
+
+std::size_t SharedBackend::worker_count() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return workers_.size();
+}
+
+std::size_t SharedBackend::attached_count() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return assignments_.size();
+}
+
+bool SharedBackend::running() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return running_;
+}
+
+void SharedBackend::start_workers() {
+  for (const auto& worker : workers_) {
+    worker->clear_sinks();
+    for (const auto& sink : sinks_) {
+      worker->register_shared_sink(sink);
+    }
+    worker->start();
+  }
+  running_ = true;
+}
+
+void SharedBackend::stop_workers() {
+  for (const auto& worker : workers_) {
+    worker->stop();
+  }
+  running_ = false;
+}
+
+}  // namespace femtolog::logging
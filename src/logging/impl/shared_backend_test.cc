@@ -0,0 +1,157 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#include "femtolog/logging/impl/shared_backend.h"
+
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "femtolog/logging/impl/internal_logger.h"
+#include "femtolog/options.h"
+#include "femtolog/sinks/sink_base.h"
+#include "gtest/gtest.h"
+
+namespace femtolog::logging {
+
+namespace {
+
+class CollectingSink : public SinkBase {
+ public:
+  struct State {
+    std::mutex mutex;
+    std::vector<std::string> messages;
+    std::set<uint32_t> thread_ids;
+  };
+
+  explicit CollectingSink(State* state) : state_(state) {}
+  ~CollectingSink() override = default;
+
+  void on_log(const LogEntry& entry,
+              const char* content,
+              std::size_t len) override {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->messages.emplace_back(content, len);
+    state_->thread_ids.insert(entry.thread_id);
+  }
+
+ private:
+  State* state_;
+};
+
+FemtologOptions shared_options() {
+  FemtologOptions options;
+  options.spsc_queue_size = 1024 * 64;
+  options.backend_mode = BackendMode::kShared;
+  return options;
+}
+
+}  // namespace
+
+TEST(SharedBackendTest, DrainsEveryAttachedQueue) {
+  constexpr int kThreads = 8;
+  constexpr int kMessagesPerThread = 200;
+
+  CollectingSink::State state;
+  {
+    InternalLogger owner;
+    owner.init(shared_options());
+    SharedBackend::instance().register_sink(
+        std::make_unique<CollectingSink>(&state));
+    owner.start_worker();
+
+    // Keep every producer alive until all of them have logged so that their
+    // thread ids are distinct.
+    std::latch logged(kThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+      threads.emplace_back([&logged]() {
+        InternalLogger logger;
+        logger.init(shared_options());
+        logger.start_worker();
+        for (int i = 0; i < kMessagesPerThread; ++i) {
+          logger.log<LogLevel::kInfo, "value {}", false>(i);
+        }
+        EXPECT_EQ(logger.dropped_count(), 0);
+        logged.arrive_and_wait();
+        logger.stop_worker();
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    EXPECT_EQ(SharedBackend::instance().attached_count(), 1);
+    owner.stop_worker();
+    EXPECT_FALSE(SharedBackend::instance().running());
+    SharedBackend::instance().clear_sinks();
+  }
+
+  EXPECT_EQ(state.messages.size(), kThreads * kMessagesPerThread);
+  EXPECT_EQ(state.thread_ids.size(), kThreads);
+  EXPECT_EQ(SharedBackend::instance().attached_count(), 0);
+}
+
+TEST(SharedBackendTest, RestartsAfterLastDetach) {
+  CollectingSink::State state;
+  InternalLogger logger;
+  logger.init(shared_options());
+  SharedBackend::instance().register_sink(
+      std::make_unique<CollectingSink>(&state));
+
+  for (int round = 0; round < 3; ++round) {
+    logger.start_worker();
+    EXPECT_TRUE(SharedBackend::instance().running());
+    logger.log<LogLevel::kInfo, "round {}", false>(round);
+    logger.stop_worker();
+    EXPECT_FALSE(SharedBackend::instance().running());
+  }
+  SharedBackend::instance().clear_sinks();
+
+  ASSERT_EQ(state.messages.size(), 3);
+  EXPECT_EQ(state.messages[0], "round 0");
+  EXPECT_EQ(state.messages[2], "round 2");
+}
+
+TEST(SharedBackendTest, ThreadsShareSinksRegisteredOnce) {
+  constexpr int kThreads = 4;
+
+  CollectingSink::State state;
+  SharedBackend::instance().register_sink(
+      std::make_unique<CollectingSink>(&state));
+
+  // Each thread sets up its own logger, and no logger keeps the backend
+  // running in between, so the workers may restart with every thread.
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([t]() {
+      InternalLogger logger;
+      logger.init(shared_options());
+      logger.start_worker();
+      logger.log<LogLevel::kInfo, "thread {}", false>(t);
+      logger.stop_worker();
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_FALSE(SharedBackend::instance().running());
+  SharedBackend::instance().clear_sinks();
+
+  // One line per thread: the sink was not duplicated by any of them.
+  EXPECT_EQ(state.messages.size(), kThreads);
+}
+
+TEST(SharedBackendTest, WorkerCountIsFixed) {
+  InternalLogger logger;
+  logger.init(shared_options());
+  EXPECT_GE(SharedBackend::instance().worker_count(), 1);
+}
+
+}  // namespace femtolog::logging
@@ -4,6 +4,7 @@
 
 #include "femtolog/logging/impl/spmc_queue.h"
 
+#include <algorithm>
 #include <cstring>
 #include <memory>
 #include <new>
@@ -20,21 +21,38 @@ namespace femtolog::logging {
 
 SpmcQueue::SpmcQueue() : buffer_(nullptr), buffer_deleter_(nullptr) {}
 
-void SpmcQueue::reserve(std::size_t capacity_bytes) {
+void SpmcQueue::reserve(std::size_t capacity_bytes, bool mirrored) {
   FEMTOLOG_DCHECK_GT(capacity_bytes, 0);
 
-  const std::size_t capacity = next_power_of_2(capacity_bytes);
-  constexpr std::size_t alignment = core::kCacheSize;
-  const std::size_t alloc_size = capacity + alignment;
+  std::size_t capacity = next_power_of_2(capacity_bytes);
+
+  std::byte* new_buffer = nullptr;
+  std::size_t alloc_size = 0;
+  core::RingBufferDeleter deleter;
+  if (mirrored) {
+    // The mirror is made of whole pages.
+    capacity = std::max(capacity,
+                        next_power_of_2(core::mirrored_alloc_granularity()));
+    new_buffer = static_cast<std::byte*>(core::mirrored_alloc(capacity));
+    if (new_buffer) {
+      alloc_size = capacity * 2;
+      deleter.mirrored_size = capacity;
+    }
+  }
 
-  std::byte* new_buffer = static_cast<std::byte*>(
-      core::aligned_alloc_wrapper(alignment, alloc_size));
+  if (!new_buffer) {
+    constexpr std::size_t alignment = core::kCacheSize;
+    alloc_size = capacity + alignment;
+    new_buffer = static_cast<std::byte*>(
+        core::aligned_alloc_wrapper(alignment, alloc_size));
+  }
 
   if (!new_buffer) [[unlikely]] {
     buffer_deleter_.reset();
     buffer_ = nullptr;
     capacity_ = 0;
     mask_ = 0;
+    contiguous_size_ = 0;
     allocation_size_ = 0;
     head_idx_.store(0, std::memory_order_relaxed);
     tail_idx_.store(0, std::memory_order_relaxed);
@@ -43,9 +61,13 @@ void SpmcQueue::reserve(std::size_t capacity_bytes) {
   }
 
   buffer_ = new_buffer;
-  buffer_deleter_.reset(new_buffer);
+  buffer_deleter_ = std::unique_ptr<std::byte[], core::RingBufferDeleter>(
+      new_buffer, deleter);
   capacity_ = capacity;
   mask_ = capacity - 1;
+  // Accesses up to twice the capacity stay contiguous in a mirrored buffer,
+  // so the wrap-around split below is never taken.
+  contiguous_size_ = deleter.mirrored_size != 0 ? capacity * 2 : capacity;
   allocation_size_ = alloc_size;
 
   head_idx_.store(0, std::memory_order_relaxed);
@@ -74,7 +96,7 @@ SpmcQueueStatus SpmcQueue::enqueue_bytes(const void* data_ptr,
 
   // Copy data to buffer (wrap around handling)
   const std::size_t tail_pos = current_tail & mask_;
-  const std::size_t space_to_end = (mask_ + 1) - tail_pos;
+  const std::size_t space_to_end = contiguous_size_ - tail_pos;
 
   if (data_size <= space_to_end) {
     std::memcpy(buffer_ + tail_pos, data_ptr, data_size);
@@ -114,7 +136,7 @@ SpmcQueueStatus SpmcQueue::dequeue_bytes(void* data_ptr,
 
   // Copy data from buffer (wrap around handling)
   const std::size_t head_pos = ticket & mask_;
-  const std::size_t bytes_to_end = (mask_ + 1) - head_pos;
+  const std::size_t bytes_to_end = contiguous_size_ - head_pos;
 
   if (data_size <= bytes_to_end) {
     std::memcpy(data_ptr, buffer_ + head_pos, data_size);
@@ -157,7 +179,7 @@ SpmcQueueStatus SpmcQueue::peek_bytes(void* data_ptr,
 
   // Copy data from buffer (wrap around handling)
   const std::size_t head_pos = current_commit & mask_;
-  const std::size_t bytes_to_end = (mask_ + 1) - head_pos;
+  const std::size_t bytes_to_end = contiguous_size_ - head_pos;
 
   if (data_size <= bytes_to_end) {
     std::memcpy(data_ptr, buffer_ + head_pos, data_size);
@@ -205,7 +227,7 @@ SpmcQueueStatus SpmcQueue::enqueue_bulk(const void* const* data_ptrs,
   for (std::size_t i = 0; i < count; ++i) {
     const std::size_t data_size = data_sizes[i];
     const std::size_t tail_pos = (current_tail + offset) & mask_;
-    const std::size_t space_to_end = (mask_ + 1) - tail_pos;
+    const std::size_t space_to_end = contiguous_size_ - tail_pos;
 
     if (data_size <= space_to_end) {
       std::memcpy(buffer_ + tail_pos, data_ptrs[i], data_size);
@@ -262,7 +284,7 @@ SpmcQueueStatus SpmcQueue::dequeue_bulk(void* const* data_ptrs,
   for (std::size_t i = 0; i < count; ++i) {
     const std::size_t data_size = data_sizes[i];
     const std::size_t head_pos = (ticket + offset) & mask_;
-    const std::size_t bytes_to_end = (mask_ + 1) - head_pos;
+    const std::size_t bytes_to_end = contiguous_size_ - head_pos;
 
     if (data_size <= bytes_to_end) {
       std::memcpy(data_ptrs[i], buffer_ + head_pos, data_size);
@@ -6,6 +6,7 @@
 
 #include <vector>
 
+#include "femtolog/build/build_flag.h"
 #include "gtest/gtest.h"
 
 namespace femtolog::logging {
@@ -226,6 +227,32 @@ TEST_F(SpmcQueueTest, CustomStructEnqueueDequeue) {
   EXPECT_TRUE(queue.empty());
 }
 
+TEST_F(SpmcQueueTest, MirroredWraparound) {
+  SpmcQueue queue;
+  queue.reserve(64, true);
+  EXPECT_EQ(queue.mirrored(), FEMTOLOG_IS_LINUX);
+  const std::size_t capacity = queue.capacity();
+
+  std::vector<char> filler(capacity - 10, 'A');
+  ASSERT_EQ(queue.enqueue_bytes(filler.data(), filler.size()),
+            SpmcQueueStatus::kOk);
+  ASSERT_EQ(queue.dequeue_bytes(filler.data(), filler.size()),
+            SpmcQueueStatus::kOk);
+
+  std::vector<char> data_in(32);
+  for (std::size_t i = 0; i < data_in.size(); ++i) {
+    data_in[i] = static_cast<char>(i);
+  }
+  ASSERT_EQ(queue.enqueue_bytes(data_in.data(), data_in.size()),
+            SpmcQueueStatus::kOk);
+
+  std::vector<char> data_out(data_in.size());
+  ASSERT_EQ(queue.dequeue_bytes(data_out.data(), data_out.size()),
+            SpmcQueueStatus::kOk);
+  EXPECT_EQ(data_out, data_in);
+  EXPECT_TRUE(queue.empty());
+}
+
 }  // namespace
 
 }  // namespace femtolog::logging
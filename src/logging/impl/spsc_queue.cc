@@ -4,6 +4,7 @@
 
 #include "femtolog/logging/impl/spsc_queue.h"
 
+#include <algorithm>
 #include <cstring>
 #include <memory>
 #include <new>
@@ -16,25 +17,41 @@ namespace femtolog::logging {
 
 SpscQueue::SpscQueue() : buffer_(nullptr), buffer_deleter_(nullptr) {}
 
-void SpscQueue::reserve(std::size_t capacity_bytes) {
+void SpscQueue::reserve(std::size_t capacity_bytes, bool mirrored) {
   FEMTOLOG_DCHECK_GT(capacity_bytes, 0);
 
   // Ensure capacity is power of 2 for efficient bitwise operations
-  const std::size_t capacity = next_power_of_2(capacity_bytes);
-
-  // Allocate cache-line aligned buffer for optimal memory access
-  // Use larger alignment for better performance on modern CPUs
-  constexpr std::size_t alignment = core::kCacheSize;
-  const std::size_t alloc_size = capacity + alignment;
+  std::size_t capacity = next_power_of_2(capacity_bytes);
+
+  std::byte* new_buffer = nullptr;
+  std::size_t alloc_size = 0;
+  core::RingBufferDeleter deleter;
+  if (mirrored) {
+    // The mirror is made of whole pages.
+    capacity = std::max(capacity,
+                        next_power_of_2(core::mirrored_alloc_granularity()));
+    new_buffer = static_cast<std::byte*>(core::mirrored_alloc(capacity));
+    if (new_buffer) {
+      alloc_size = capacity * 2;
+      deleter.mirrored_size = capacity;
+    }
+  }
 
-  std::byte* new_buffer = static_cast<std::byte*>(
-      core::aligned_alloc_wrapper(alignment, alloc_size));
+  if (!new_buffer) {
+    // Allocate cache-line aligned buffer for optimal memory access
+    // Use larger alignment for better performance on modern CPUs
+    constexpr std::size_t alignment = core::kCacheSize;
+    alloc_size = capacity + alignment;
+    new_buffer = static_cast<std::byte*>(
+        core::aligned_alloc_wrapper(alignment, alloc_size));
+  }
 
   if (!new_buffer) [[unlikely]] {
     buffer_deleter_.reset();
     buffer_ = nullptr;
     capacity_ = 0;
     mask_ = 0;
+    contiguous_size_ = 0;
     allocation_size_ = 0;
 
     head_idx_.store(0, std::memory_order_relaxed);
@@ -47,9 +64,13 @@ void SpscQueue::reserve(std::size_t capacity_bytes) {
   }
 
   buffer_ = new_buffer;
-  buffer_deleter_.reset(new_buffer);
+  buffer_deleter_ = std::unique_ptr<std::byte[], core::RingBufferDeleter>(
+      new_buffer, deleter);
   capacity_ = capacity;
   mask_ = capacity - 1;
+  // Accesses up to twice the capacity stay contiguous in a mirrored buffer,
+  // so the wrap-around split below is never taken.
+  contiguous_size_ = deleter.mirrored_size != 0 ? capacity * 2 : capacity;
   allocation_size_ = alloc_size;
 
   head_idx_.store(0, std::memory_order_relaxed);
@@ -58,6 +79,8 @@ void SpscQueue::reserve(std::size_t capacity_bytes) {
   tail_cached_ = 0;
   head_cached_snapshot_ = 0;
   tail_cached_snapshot_ = 0;
+  producer_waiting_.store(false, std::memory_order_relaxed);
+  successor_.store(nullptr, std::memory_order_relaxed);
 }
 
 SpscQueueStatus SpscQueue::enqueue_bytes(const void* data_ptr,
@@ -86,7 +109,7 @@ SpscQueueStatus SpscQueue::enqueue_bytes(const void* data_ptr,
   }
 
   const std::size_t tail_pos = current_tail & mask_;
-  const std::size_t space_to_end = (mask_ + 1) - tail_pos;
+  const std::size_t space_to_end = contiguous_size_ - tail_pos;
 
   if (data_size <= space_to_end) [[likely]] {
     std::memcpy(buffer_ + tail_pos, data_ptr, data_size);
@@ -103,6 +126,39 @@ SpscQueueStatus SpscQueue::enqueue_bytes(const void* data_ptr,
   return SpscQueueStatus::kOk;
 }
 
+SpscQueueStatus SpscQueue::wait_for_space(std::size_t data_size) noexcept {
+  if (!buffer_) [[unlikely]] {
+    return SpscQueueStatus::kUninitialized;
+  }
+  if (data_size > capacity_) [[unlikely]] {
+    return SpscQueueStatus::kOverflow;
+  }
+
+  const std::size_t current_tail = tail_idx_.load(std::memory_order_relaxed);
+
+  // Pairs with the fence in notify_producer_if_waiting(): either the consumer
+  // sees the flag, or this thread sees the consumer's new head.
+  producer_waiting_.store(true, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  std::size_t current_head = head_idx_.load(std::memory_order_acquire);
+  while (capacity_ - (current_tail - current_head) < data_size) {
+    head_idx_.wait(current_head, std::memory_order_acquire);
+    current_head = head_idx_.load(std::memory_order_acquire);
+  }
+
+  producer_waiting_.store(false, std::memory_order_relaxed);
+  head_cached_snapshot_ = current_head;
+  return SpscQueueStatus::kOk;
+}
+
+inline void SpscQueue::notify_producer_if_waiting() noexcept {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (producer_waiting_.load(std::memory_order_relaxed)) [[unlikely]] {
+    head_idx_.notify_one();
+  }
+}
+
 SpscQueueStatus SpscQueue::dequeue_bytes(void* data_ptr,
                                          std::size_t data_size) noexcept {
   if (!buffer_) [[unlikely]] {
@@ -112,7 +168,7 @@ SpscQueueStatus SpscQueue::dequeue_bytes(void* data_ptr,
     return SpscQueueStatus::kSizeIsZero;
   }
 
-  const std::size_t current_head = head_idx_.load(std::memory_order_relaxed);
+  const std::size_t current_head = head_cached_;
 
   // Use cached snapshot to reduce atomic loads
   std::size_t current_tail = tail_cached_snapshot_;
@@ -129,7 +185,7 @@ SpscQueueStatus SpscQueue::dequeue_bytes(void* data_ptr,
   }
 
   const std::size_t head_pos = current_head & mask_;
-  const std::size_t bytes_to_end = (mask_ + 1) - head_pos;
+  const std::size_t bytes_to_end = contiguous_size_ - head_pos;
 
   if (data_size <= bytes_to_end) [[likely]] {
     std::memcpy(data_ptr, buffer_ + head_pos, data_size);
@@ -143,9 +199,18 @@ SpscQueueStatus SpscQueue::dequeue_bytes(void* data_ptr,
   std::atomic_thread_fence(std::memory_order_release);
   head_idx_.store(current_head + data_size, std::memory_order_relaxed);
   head_cached_ = current_head + data_size;
+  notify_producer_if_waiting();
   return SpscQueueStatus::kOk;
 }
 
+void SpscQueue::release_read() noexcept {
+  if (head_idx_.load(std::memory_order_relaxed) == head_cached_) {
+    return;
+  }
+  head_idx_.store(head_cached_, std::memory_order_release);
+  notify_producer_if_waiting();
+}
+
 SpscQueueStatus SpscQueue::peek_bytes(void* data_ptr,
                                       std::size_t data_size) const noexcept {
   if (!buffer_) [[unlikely]] {
@@ -155,7 +220,7 @@ SpscQueueStatus SpscQueue::peek_bytes(void* data_ptr,
     return SpscQueueStatus::kSizeIsZero;
   }
 
-  const std::size_t current_head = head_idx_.load(std::memory_order_relaxed);
+  const std::size_t current_head = head_cached_;
   const std::size_t current_tail = tail_idx_.load(std::memory_order_relaxed);
 
   const std::size_t available_data = current_tail - current_head;
@@ -164,7 +229,7 @@ SpscQueueStatus SpscQueue::peek_bytes(void* data_ptr,
   }
 
   const std::size_t head_pos = current_head & mask_;
-  const std::size_t bytes_to_end = (mask_ + 1) - head_pos;
+  const std::size_t bytes_to_end = contiguous_size_ - head_pos;
 
   if (data_size <= bytes_to_end) [[likely]] {
     std::memcpy(data_ptr, buffer_ + head_pos, data_size);
@@ -217,7 +282,7 @@ SpscQueueStatus SpscQueue::enqueue_bulk(const void* const* data_ptrs,
   for (std::size_t i = 0; i < count; ++i) {
     const std::size_t data_size = data_sizes[i];
     const std::size_t tail_pos = (current_tail + offset) & mask_;
-    const std::size_t space_to_end = (mask_ + 1) - tail_pos;
+    const std::size_t space_to_end = contiguous_size_ - tail_pos;
 
     if (data_size <= space_to_end) [[likely]] {
       std::memcpy(buffer_ + tail_pos, data_ptrs[i], data_size);
@@ -256,7 +321,7 @@ SpscQueueStatus SpscQueue::dequeue_bulk(void* const* data_ptrs,
     return SpscQueueStatus::kSizeIsZero;
   }
 
-  const std::size_t current_head = head_idx_.load(std::memory_order_relaxed);
+  const std::size_t current_head = head_cached_;
   std::size_t current_tail = tail_cached_snapshot_;
   const std::size_t available_data = current_tail - current_head;
 
@@ -275,7 +340,7 @@ SpscQueueStatus SpscQueue::dequeue_bulk(void* const* data_ptrs,
   for (std::size_t i = 0; i < count; ++i) {
     const std::size_t data_size = data_sizes[i];
     const std::size_t head_pos = (current_head + offset) & mask_;
-    const std::size_t bytes_to_end = (mask_ + 1) - head_pos;
+    const std::size_t bytes_to_end = contiguous_size_ - head_pos;
 
     if (data_size <= bytes_to_end) [[likely]] {
       std::memcpy(data_ptrs[i], buffer_ + head_pos, data_size);
@@ -290,6 +355,7 @@ SpscQueueStatus SpscQueue::dequeue_bulk(void* const* data_ptrs,
   std::atomic_thread_fence(std::memory_order_release);
   head_idx_.store(current_head + total_size, std::memory_order_relaxed);
   head_cached_ = current_head + total_size;
+  notify_producer_if_waiting();
   return SpscQueueStatus::kOk;
 }
 
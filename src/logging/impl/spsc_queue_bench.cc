@@ -4,6 +4,8 @@
 
 #include <atomic>
 #include <chrono>
+#include <cstring>
+#include <span>
 #include <thread>
 
 #include "benchmark/benchmark.h"
@@ -292,6 +294,67 @@ void spsc_queue_large_producer_bench_with_busy_consumer(
 }
 BENCHMARK(spsc_queue_large_producer_bench_with_busy_consumer);
 
+// Consuming a 512-byte entry by copying it out (dequeue_bytes) versus reading
+// it where it sits (readable_span / consume) and releasing in batches of 32.
+constexpr std::size_t kEntryBytes = 512;
+
+void spsc_queue_consume_512_bytes_copy(benchmark::State& state) {
+  SpscQueue queue;
+  queue.reserve(kMediumQueueCapacity);
+  alignas(8) uint8_t out[kEntryBytes];
+  for (auto _ : state) {
+    std::byte* slot = queue.reserve_write(kEntryBytes);
+    std::memset(slot, 0xAA, kEntryBytes);
+    queue.commit_write(kEntryBytes);
+
+    queue.dequeue_bytes(out, kEntryBytes);
+    benchmark::DoNotOptimize(out[0]);
+  }
+}
+BENCHMARK(spsc_queue_consume_512_bytes_copy);
+
+void spsc_queue_consume_512_bytes_in_place(benchmark::State& state) {
+  SpscQueue queue;
+  queue.reserve(kMediumQueueCapacity);
+  std::size_t consumed = 0;
+  for (auto _ : state) {
+    std::byte* slot = queue.reserve_write(kEntryBytes);
+    std::memset(slot, 0xAA, kEntryBytes);
+    queue.commit_write(kEntryBytes);
+
+    const std::span<std::byte> readable = queue.readable_span();
+    benchmark::DoNotOptimize(readable[0]);
+    queue.consume(kEntryBytes);
+    if (++consumed % 32 == 0) {
+      queue.release_read();
+    }
+  }
+}
+BENCHMARK(spsc_queue_consume_512_bytes_in_place);
+
+// 3000-byte messages through a 4KiB queue straddle its end most of the time.
+template <bool mirrored>
+void spsc_queue_roundtrip_wrapping_3000_bytes(benchmark::State& state) {
+  SpscQueue queue;
+  queue.reserve(kDefaultQueueCapacity, mirrored);
+  uint8_t data[3000] = {0};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(queue.enqueue_bytes(data, sizeof(data)));
+    benchmark::DoNotOptimize(queue.dequeue_bytes(data, sizeof(data)));
+  }
+}
+
+void spsc_queue_roundtrip_wrapping_3000_bytes_aligned(benchmark::State& state) {
+  spsc_queue_roundtrip_wrapping_3000_bytes<false>(state);
+}
+BENCHMARK(spsc_queue_roundtrip_wrapping_3000_bytes_aligned);
+
+void spsc_queue_roundtrip_wrapping_3000_bytes_mirrored(
+    benchmark::State& state) {
+  spsc_queue_roundtrip_wrapping_3000_bytes<true>(state);
+}
+BENCHMARK(spsc_queue_roundtrip_wrapping_3000_bytes_mirrored);
+
 }  // namespace
 
 }  // namespace femtolog::logging
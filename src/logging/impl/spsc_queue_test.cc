@@ -4,8 +4,15 @@
 
 #include "femtolog/logging/impl/spsc_queue.h"
 
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <span>
+#include <thread>
 #include <vector>
 
+#include "femtolog/build/build_flag.h"
+#include "femtolog/core/base/memory_util.h"
 #include "gtest/gtest.h"
 
 namespace femtolog::logging {
@@ -226,6 +233,166 @@ TEST_F(SpscQueueTest, CustomStructEnqueueDequeue) {
   EXPECT_TRUE(queue.empty());
 }
 
+TEST_F(SpscQueueTest, WaitForSpaceBlocksUntilConsumerReleases) {
+  SpscQueue queue;
+  queue.reserve(64);
+
+  std::vector<char> data(48, 'A');
+  ASSERT_EQ(queue.enqueue_bytes(data.data(), data.size()),
+            SpscQueueStatus::kOk);
+  ASSERT_EQ(queue.enqueue_bytes(data.data(), data.size()),
+            SpscQueueStatus::kOverflow);
+
+  std::atomic<bool> resumed = false;
+  std::thread producer([&]() {
+    EXPECT_EQ(queue.wait_for_space(data.size()), SpscQueueStatus::kOk);
+    resumed.store(true);
+    EXPECT_EQ(queue.enqueue_bytes(data.data(), data.size()),
+              SpscQueueStatus::kOk);
+  });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_FALSE(resumed.load());
+
+  std::vector<char> out(48);
+  ASSERT_EQ(queue.dequeue_bytes(out.data(), out.size()), SpscQueueStatus::kOk);
+  producer.join();
+  EXPECT_TRUE(resumed.load());
+  EXPECT_EQ(queue.size(), 48);
+}
+
+TEST_F(SpscQueueTest, WaitForSpaceRejectsOversizedData) {
+  SpscQueue queue;
+  queue.reserve(64);
+  EXPECT_EQ(queue.wait_for_space(128), SpscQueueStatus::kOverflow);
+}
+
+TEST_F(SpscQueueTest, ReserveAndCommitWrite) {
+  SpscQueue queue;
+  queue.reserve(32);
+
+  std::byte* slot = queue.reserve_write(8);
+  ASSERT_NE(slot, nullptr);
+  const uint64_t value = 0x0123456789abcdefull;
+  std::memcpy(slot, &value, sizeof(value));
+  EXPECT_TRUE(queue.empty());
+
+  queue.commit_write(8);
+  EXPECT_EQ(queue.size(), 8);
+
+  uint64_t out = 0;
+  ASSERT_EQ(queue.dequeue_bytes(&out), SpscQueueStatus::kOk);
+  EXPECT_EQ(out, value);
+}
+
+TEST_F(SpscQueueTest, ReserveWriteRejectsWrapAndFull) {
+  SpscQueue queue;
+  queue.reserve(32);
+
+  ASSERT_NE(queue.reserve_write(24), nullptr);
+  queue.commit_write(24);
+  EXPECT_EQ(queue.writable_bytes(), 8);
+  EXPECT_EQ(queue.reserve_write(16), nullptr);  // Full.
+
+  uint8_t sink[16];
+  ASSERT_EQ(queue.dequeue_bytes(sink, sizeof(sink)), SpscQueueStatus::kOk);
+  EXPECT_EQ(queue.writable_bytes(), 24);
+  EXPECT_EQ(queue.reserve_write(16), nullptr);  // Would wrap.
+  EXPECT_NE(queue.reserve_write(8), nullptr);
+}
+
+TEST_F(SpscQueueTest, ReadableSpanConsumeAndRelease) {
+  SpscQueue queue;
+  queue.reserve(32);
+  EXPECT_TRUE(queue.readable_span().empty());
+
+  const uint64_t values[] = {1, 2, 3};
+  for (const uint64_t& value : values) {
+    ASSERT_EQ(queue.enqueue_bytes(&value), SpscQueueStatus::kOk);
+  }
+  EXPECT_EQ(queue.writable_bytes(), 8);
+
+  std::span<std::byte> readable = queue.readable_span();
+  ASSERT_EQ(readable.size(), 24);
+  uint64_t first = 0;
+  std::memcpy(&first, readable.data(), sizeof(first));
+  EXPECT_EQ(first, 1);
+
+  // Consumed bytes are not handed back until release_read().
+  queue.consume(16);
+  EXPECT_EQ(queue.readable_span().size(), 8);
+  EXPECT_EQ(queue.writable_bytes(), 8);
+  queue.release_read();
+  EXPECT_EQ(queue.writable_bytes(), 24);
+
+  // Only the bytes before the end of the buffer are contiguous.
+  const uint64_t wrapped[] = {4, 5};
+  ASSERT_EQ(queue.enqueue_bytes(wrapped, sizeof(wrapped)),
+            SpscQueueStatus::kOk);
+  queue.consume(queue.readable_span().size());
+  readable = queue.readable_span();
+  ASSERT_EQ(readable.size(), 8);
+  std::memcpy(&first, readable.data(), sizeof(first));
+  EXPECT_EQ(first, 4);
+  queue.consume(8);
+  ASSERT_EQ(queue.readable_span().size(), 8);
+  queue.consume(8);
+  queue.release_read();
+  EXPECT_TRUE(queue.empty());
+  EXPECT_EQ(queue.writable_bytes(), 32);
+}
+
+TEST_F(SpscQueueTest, MirroredBufferKeepsWrappedDataContiguous) {
+  SpscQueue queue;
+  queue.reserve(64, true);
+#if FEMTOLOG_IS_LINUX
+  ASSERT_TRUE(queue.mirrored());
+  EXPECT_EQ(queue.capacity(), core::mirrored_alloc_granularity());
+#else
+  GTEST_SKIP() << "mirrored buffers are Linux only";
+#endif
+  const std::size_t capacity = queue.capacity();
+
+  // Move the read and write positions close to the end of the buffer.
+  std::vector<char> filler(capacity - 16, 'A');
+  ASSERT_EQ(queue.enqueue_bytes(filler.data(), filler.size()),
+            SpscQueueStatus::kOk);
+  ASSERT_EQ(queue.dequeue_bytes(filler.data(), filler.size()),
+            SpscQueueStatus::kOk);
+
+  // A slot running past the end is handed out in one piece...
+  std::byte* slot = queue.reserve_write(64);
+  ASSERT_NE(slot, nullptr);
+  for (std::size_t i = 0; i < 64; ++i) {
+    slot[i] = static_cast<std::byte>(i);
+  }
+  queue.commit_write(64);
+
+  // ...and read back in one piece.
+  const std::span<std::byte> readable = queue.readable_span();
+  ASSERT_EQ(readable.size(), 64);
+  for (std::size_t i = 0; i < 64; ++i) {
+    EXPECT_EQ(readable[i], static_cast<std::byte>(i));
+  }
+  queue.consume(64);
+  queue.release_read();
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST_F(SpscQueueTest, Successor) {
+  SpscQueue queue;
+  queue.reserve(64);
+  EXPECT_EQ(queue.successor(), nullptr);
+
+  SpscQueue next;
+  queue.set_successor(&next);
+  EXPECT_EQ(queue.successor(), &next);
+
+  // Re-reserving starts a fresh queue.
+  queue.reserve(64);
+  EXPECT_EQ(queue.successor(), nullptr);
+}
+
 }  // namespace
 
 }  // namespace femtolog::logging
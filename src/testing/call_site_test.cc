@@ -0,0 +1,66 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#include "femtolog/base/call_site.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace femtolog {
+
+// Never called; referencing the call site is enough to register it.
+void call_site_test_unused_call_site() {
+  static_cast<void>(
+      &static_call_site_registration<LogLevel::kWarn, "static literal\n",
+                                     nullptr>);
+}
+
+namespace {
+
+TEST(CallSiteRegistryTest, EmptyRegistryOwnsNoStorage) {
+  CallSiteRegistry registry;
+  EXPECT_EQ(registry.size(), 0u);
+  EXPECT_EQ(registry.memory_usage(), 0u);
+}
+
+TEST(CallSiteRegistryTest, IndicesResolveAcrossChunks) {
+  CallSiteRegistry registry;
+  std::vector<std::string> texts;
+  for (int i = 0; i < 600; ++i) {
+    texts.push_back("literal " + std::to_string(i));
+  }
+  std::vector<uint32_t> indices;
+  for (const std::string& text : texts) {
+    CallSite site;
+    site.format = text;
+    indices.push_back(registry.register_call_site(site));
+  }
+  EXPECT_EQ(registry.size(), texts.size());
+  for (std::size_t i = 0; i < texts.size(); ++i) {
+    EXPECT_EQ(indices[i], i + 1);
+    EXPECT_EQ(registry.get(indices[i]).format, texts[i]);
+  }
+}
+
+TEST(CallSiteRegistryTest, StaticRegistrationRunsBeforeMain) {
+  auto& registration =
+      static_call_site_registration<LogLevel::kWarn, "static literal\n",
+                                    nullptr>;
+  const uint32_t index = registration.index();
+  ASSERT_NE(index, 0u);
+  // Registered once.
+  EXPECT_EQ(registration.index(), index);
+
+  const CallSite& site = CallSiteRegistry::instance().get(index);
+  EXPECT_EQ(site.format, "static literal\n");
+  EXPECT_EQ(site.level, LogLevel::kWarn);
+  EXPECT_EQ(site.format_id, kLiteralLogStringId);
+  EXPECT_TRUE(site.is_literal());
+}
+
+}  // namespace
+
+}  // namespace femtolog
@@ -3,10 +3,12 @@
 // which can be found in the LICENSE file.
 
 #include <string>
+#include <vector>
 
 #include "femtolog/logger.h"
 #include "femtolog/sinks/file_sink.h"
 #include "femtolog/sinks/json_lines_sink.h"
+#include "femtolog/sinks/null_sink.h"
 #include "femtolog/sinks/stdout_sink.h"
 #include "gtest/gtest.h"
 
@@ -52,6 +54,26 @@ TEST(FemtoLogTest, README_example) {
 
 namespace femtolog {
 
+namespace {
+
+class CollectingSink : public SinkBase {
+ public:
+  explicit CollectingSink(std::vector<std::string>* messages)
+      : messages_(messages) {}
+  ~CollectingSink() override = default;
+
+  void on_log(const LogEntry&,
+              const char* content,
+              std::size_t len) override {
+    messages_->emplace_back(content, len);
+  }
+
+ private:
+  std::vector<std::string>* messages_;
+};
+
+}  // namespace
+
 TEST(FemtoLogTest, BasicLogging) {
   Logger& logger = Logger::global_logger();
 
@@ -100,4 +122,89 @@ TEST(FemtoLogTest, BasicLogging) {
   logger.clear_sinks();
 }
 
+TEST(FemtoLogTest, ActiveLevelMacrosSkipArguments) {
+  Logger logger = Logger::create_logger();
+  logger.init();
+  logger.register_sink<NullSink>();
+  logger.level(LogLevel::kTrace);
+  logger.start_worker();
+
+  int evaluated = 0;
+  auto argument = [&evaluated] { return ++evaluated; };
+
+  FEMTOLOG_INFO(logger, "info {}\n", argument());
+  FEMTOLOG_DEBUG(logger, "debug {}\n", argument());
+  FEMTOLOG_TRACE(logger, "trace {}\n", argument());
+  FEMTOLOG_TRACE(logger, "trace without arguments\n");
+
+  const int expected_evaluated = is_level_active(LogLevel::kInfo) +
+                                 is_level_active(LogLevel::kDebug) +
+                                 is_level_active(LogLevel::kTrace);
+  EXPECT_EQ(evaluated, expected_evaluated);
+  EXPECT_EQ(logger.enqueued_count(),
+            expected_evaluated + is_level_active(LogLevel::kTrace));
+
+  logger.stop_worker();
+  logger.clear_sinks();
+}
+
+TEST(FemtoLogTest, RateLimitedLogging) {
+  Logger logger = Logger::create_logger();
+  logger.init();
+  logger.register_sink<NullSink>();
+  logger.start_worker();
+
+  for (int i = 0; i < 10; ++i) {
+    logger.info_every_n<4, "every 4th: {}\n">(i);
+  }
+  EXPECT_EQ(logger.enqueued_count(), 3u);
+
+  logger.reset_count();
+  for (int i = 0; i < 10; ++i) {
+    logger.info_at_most<2, "at most 2/s: {}\n">(i);
+  }
+  EXPECT_EQ(logger.enqueued_count(), 2u);
+
+  logger.reset_count();
+  for (int i = 0; i < 10; ++i) {
+    logger.info_sampled<0.0, "never: {}\n">(i);
+    logger.info_sampled<1.0, "always: {}\n">(i);
+  }
+  EXPECT_EQ(logger.enqueued_count(), 10u);
+
+  logger.stop_worker();
+  logger.clear_sinks();
+}
+
+TEST(FemtoLogTest, ReportsSuppressedCallsOfQuietCallSites) {
+  Logger logger = Logger::create_logger();
+  logger.init();
+  std::vector<std::string> messages;
+  logger.register_sink<CollectingSink>(&messages);
+  logger.start_worker();
+
+  // The call site goes quiet within its window; flush() reports it anyway,
+  // without another call to the call site.
+  for (int i = 0; i < 10; ++i) {
+    logger.info_at_most<2, "quiet: {}\n">(i);
+  }
+  EXPECT_EQ(logger.enqueued_count(), 2u);
+  logger.flush();
+  EXPECT_EQ(messages, (std::vector<std::string>{
+                          "quiet: 0\n",
+                          "quiet: 1\n",
+                          "suppressed 8 messages: \"quiet: {}\"\n",
+                      }));
+
+  // Calls are reported once, and stopping reports the rest.
+  logger.flush();
+  EXPECT_EQ(messages.size(), 3u);
+  logger.info_at_most<2, "quiet: {}\n">(10);
+  logger.stop_worker();
+  ASSERT_EQ(messages.size(), 4u);
+  EXPECT_EQ(messages.back(), "suppressed 1 messages: \"quiet: {}\"\n");
+
+  logger.clear_sinks();
+}
+
 }  // namespace femtolog
@@ -0,0 +1,123 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#include "femtolog/sinks/file_sink.h"
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "femtolog/base/log_entry.h"
+#include "femtolog/core/base/file_util.h"
+#include "femtolog/sinks/json_lines_sink.h"
+#include "femtolog/sinks/shared_file.h"
+#include "gtest/gtest.h"
+#include "testing/temp_dir_test_util.h"
+
+namespace femtolog {
+
+namespace {
+
+class FileSinkTest : public TempDirTest<> {
+ protected:
+  FileSinkTest() : TempDirTest("file_sink_test_") {}
+};
+
+TEST_F(FileSinkTest, SinksOfAPathShareOneFile) {
+  LogEntry entry;
+  {
+    FileSink first(path_, nullptr);
+    FileSink second(path_, nullptr);
+    EXPECT_EQ(SharedFile::open(path_), SharedFile::open(path_));
+
+    first.on_log(entry, "a\n", 2);
+    second.on_log(entry, "b\n", 2);
+    first.flush();
+    second.flush();
+    first.on_log(entry, "c\n", 2);
+  }
+
+  // The second sink did not rotate away the lines of the first.
+  EXPECT_EQ(core::list_files(dir_).size(), 1u);
+  EXPECT_EQ(core::read_file(path_.c_str()), "a\nb\nc\n");
+}
+
+TEST_F(FileSinkTest, BatchesTheLinesOfEverySink) {
+  LogEntry entry;
+  FileSink first(path_, nullptr);
+  FileSink second(path_, nullptr);
+  first.on_log(entry, "a\n", 2);
+  second.begin_log(entry)->append(std::string_view("b\n"));
+  second.end_log(entry);
+  EXPECT_EQ(core::read_file(path_.c_str()), "");
+
+  // One write for the lines of both sinks.
+  second.flush();
+  EXPECT_EQ(core::read_file(path_.c_str()), "a\nb\n");
+}
+
+TEST_F(FileSinkTest, KeepsTheLinesOfConcurrentBackendsWhole) {
+  constexpr int kThreads = 4;
+  constexpr int kLinesPerThread = 20000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([this, t]() {
+      LogEntry entry;
+      FileSink sink(path_, nullptr);
+      const std::string line = std::string(100, static_cast<char>('a' + t)) +
+                               "\n";
+      for (int i = 0; i < kLinesPerThread; ++i) {
+        sink.on_log(entry, line.data(), line.size());
+        if (i % 100 == 0) {
+          sink.flush();
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  const std::vector<std::string> lines =
+      core::read_lines(core::read_file(path_.c_str()));
+  ASSERT_EQ(lines.size(), static_cast<std::size_t>(kThreads * kLinesPerThread));
+  for (const std::string& line : lines) {
+    ASSERT_EQ(line, std::string(100, line.front()));
+  }
+}
+
+TEST_F(FileSinkTest, RotatesAPathOncePerProcess) {
+  LogEntry entry;
+  {
+    JsonLinesSink<false> sink(path_, nullptr);
+    sink.on_log(entry, "old\n", 4);
+  }
+  {
+    FileSink sink(path_, nullptr);
+    sink.on_log(entry, "new\n", 4);
+  }
+
+  // The second sink appended to the file the first one closed.
+  EXPECT_EQ(core::list_files(dir_).size(), 1u);
+  EXPECT_EQ(core::read_file(path_.c_str()), "old\nnew\n");
+  EXPECT_FALSE(SharedFile::rotate(path_));
+}
+
+TEST_F(FileSinkTest, ClaimsAPathNoOtherSinkWrites) {
+  {
+    FileSink sink(path_, nullptr);
+    EXPECT_FALSE(SharedFile::claim(path_));
+  }
+
+  ASSERT_TRUE(SharedFile::claim(path_));
+  EXPECT_FALSE(SharedFile::claim(path_));
+  SharedFile::release(path_);
+  EXPECT_TRUE(SharedFile::claim(path_));
+  SharedFile::release(path_);
+}
+
+}  // namespace
+
+}  // namespace femtolog
@@ -0,0 +1,117 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#include "femtolog/sinks/io_uring_file_sink.h"
+
+#if FEMTOLOG_HAS_IO_URING
+
+#include <string>
+
+#include "femtolog/base/log_entry.h"
+#include "femtolog/core/base/file_util.h"
+#include "gtest/gtest.h"
+#include "testing/temp_dir_test_util.h"
+
+namespace femtolog {
+
+namespace {
+
+class IoUringFileSinkTest
+    : public TempDirTest<::testing::TestWithParam<bool>> {
+ protected:
+  IoUringFileSinkTest() : TempDirTest("io_uring_file_sink_test_") {
+    options_.buffer_count = 2;
+    options_.buffer_size = 4096;
+    options_.direct_io = GetParam();
+  }
+
+  IoUringFileSinkOptions options_;
+};
+
+TEST_P(IoUringFileSinkTest, WritesLinesInOrder) {
+  LogEntry entry;
+  std::string expected;
+  {
+    IoUringFileSink sink(path_, nullptr, options_);
+    if (!sink.uses_io_uring()) {
+      GTEST_SKIP() << "io_uring is not available";
+    }
+    // Cycles through the buffers many times, with lines crossing blocks.
+    for (int i = 0; i < 10000; ++i) {
+      const std::string line = "line " + std::to_string(i) + "\n";
+      sink.on_log(entry, line.data(), line.size());
+      expected += line;
+      if (i % 1000 == 0) {
+        sink.flush();
+      }
+    }
+  }
+
+  EXPECT_EQ(core::read_file(path_.c_str()), expected);
+}
+
+TEST_P(IoUringFileSinkTest, WritesFlushedLines) {
+  LogEntry entry;
+  IoUringFileSink sink(path_, nullptr, options_);
+  if (!sink.uses_io_uring()) {
+    GTEST_SKIP() << "io_uring is not available";
+  }
+  sink.on_log(entry, "a\n", 2);
+  sink.flush();
+  sink.on_log(entry, "b\n", 2);
+  sink.flush();
+  sink.wait_for_writes();
+
+  // With O_DIRECT, the last block is padded until the sink is destroyed.
+  const std::string content = core::read_file(path_.c_str());
+  ASSERT_GE(content.size(), 4u);
+  EXPECT_EQ(content.substr(0, 4), "a\nb\n");
+  if (!sink.uses_direct_io()) {
+    EXPECT_EQ(content.size(), 4u);
+  }
+}
+
+TEST_P(IoUringFileSinkTest, FallsBackToPwrite) {
+  options_.use_io_uring = false;
+  LogEntry entry;
+  std::string expected;
+  {
+    IoUringFileSink sink(path_, nullptr, options_);
+    EXPECT_FALSE(sink.uses_io_uring());
+    // Flushes often, so that with O_DIRECT padded blocks are carried over to
+    // the next buffer and written again.
+    for (int i = 0; i < 5000; ++i) {
+      const std::string line = "line " + std::to_string(i) + "\n";
+      sink.on_log(entry, line.data(), line.size());
+      expected += line;
+      if (i % 7 == 0) {
+        sink.flush();
+      }
+    }
+    sink.flush();
+
+    const std::string content = core::read_file(path_.c_str());
+    ASSERT_GE(content.size(), expected.size());
+    EXPECT_EQ(content.substr(0, expected.size()), expected);
+    if (sink.uses_direct_io()) {
+      EXPECT_EQ(content.size() % 4096, 0u);
+      EXPECT_EQ(content.find_first_not_of('\0', expected.size()),
+                std::string::npos);
+    } else {
+      EXPECT_EQ(content.size(), expected.size());
+    }
+  }
+
+  EXPECT_EQ(core::read_file(path_.c_str()), expected);
+}
+
+INSTANTIATE_TEST_SUITE_P(BufferedAndDirect,
+                         IoUringFileSinkTest,
+                         ::testing::Bool());
+
+}  // namespace
+
+}  // namespace femtolog
+
+#endif  // FEMTOLOG_HAS_IO_URING
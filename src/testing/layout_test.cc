@@ -0,0 +1,104 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#include "femtolog/sinks/layout.h"
+
+#include <string>
+#include <string_view>
+
+#include "femtolog/base/log_entry.h"
+#include "femtolog/base/log_level.h"
+#include "femtolog/core/base/string_util.h"
+#include "gtest/gtest.h"
+
+namespace femtolog {
+
+namespace {
+
+// 2023-11-14 22:13:20.123456789 UTC
+constexpr uint64_t kTimestampNs = 1'700'000'000'123'456'789;
+
+std::string format_line(const LayoutFunctions* layout,
+                        const LogEntry& entry,
+                        std::string_view message) {
+  fmt::memory_buffer buffer;
+  layout->format_line(entry, message.data(), message.size(), &buffer);
+  return fmt::to_string(buffer);
+}
+
+TEST(LayoutTest, RendersFieldsAroundTheMessage) {
+  using TestLayout =
+      Layout<"[{time:%Y-%m-%d %H:%M:%S.%3}] {level} {tid}: {msg}|",
+             LayoutOptions{.time_zone = TimeZone::kUtc}>;
+  LogEntry entry;
+  entry.timestamp_ns = kTimestampNs;
+  entry.thread_id = 42;
+  entry.level = LogLevel::kWarn;
+
+  EXPECT_EQ(format_line(TestLayout::functions(), entry, "hello"),
+            "[2023-11-14 22:13:20.123] warn 42: hello|");
+
+  using DefaultTime =
+      Layout<"{time} {msg}", LayoutOptions{.time_zone = TimeZone::kUtc}>;
+  EXPECT_EQ(format_line(DefaultTime::functions(), entry, "hello"),
+            "22:13:20.123456789 hello");
+}
+
+TEST(LayoutTest, RendersTheCachedCalendarOfEachSecond) {
+  using TestLayout = Layout<"{time:%H:%M:%S.%6} {msg}",
+                            LayoutOptions{.time_zone = TimeZone::kUtc}>;
+  LogEntry entry;
+  entry.timestamp_ns = kTimestampNs;
+  EXPECT_EQ(format_line(TestLayout::functions(), entry, "a"),
+            "22:13:20.123456 a");
+  entry.timestamp_ns = kTimestampNs + 800'000'000;
+  EXPECT_EQ(format_line(TestLayout::functions(), entry, "b"),
+            "22:13:20.923456 b");
+  entry.timestamp_ns = kTimestampNs + 900'000'000;
+  EXPECT_EQ(format_line(TestLayout::functions(), entry, "c"),
+            "22:13:21.023456 c");
+  // Entries of other queues can be a little older.
+  entry.timestamp_ns = kTimestampNs - 200'000'000;
+  EXPECT_EQ(format_line(TestLayout::functions(), entry, "d"),
+            "22:13:19.923456 d");
+}
+
+TEST(LayoutTest, EscapesBracesAndJsonMessages) {
+  using JsonLayout = Layout<R"({{"ts": {time_ns}, "msg": "{msg:json}"}})">;
+  LogEntry entry;
+  entry.timestamp_ns = kTimestampNs;
+
+  EXPECT_EQ(format_line(JsonLayout::functions(), entry, "a \"b\"\\\x01\n"),
+            R"({"ts": 1700000000123456789, "msg": "a \"b\"\\\u0001\n"})");
+}
+
+TEST(LayoutTest, AppliesOptions) {
+  using ColorLayout =
+      Layout<"{level:color}: {msg}",
+             LayoutOptions{.color = true, .bare_raw = true}>;
+  using PlainLayout = Layout<"{level:color}: {msg}">;
+  LogEntry entry;
+  entry.level = LogLevel::kError;
+
+  EXPECT_EQ(format_line(ColorLayout::functions(), entry, "x"),
+            std::string(core::kBold) + core::kRed + "error" + core::kReset +
+                ": x");
+  EXPECT_EQ(format_line(PlainLayout::functions(), entry, "x"), "error: x");
+
+  entry.level = LogLevel::kRaw;
+  EXPECT_EQ(format_line(ColorLayout::functions(), entry, "x"), "x");
+  EXPECT_EQ(format_line(PlainLayout::functions(), entry, "x"), "raw: x");
+}
+
+TEST(LayoutTest, IsSharedBetweenUses) {
+  using A = Layout<"{level}: {msg}">;
+  using B = Layout<"{level}: {msg}">;
+  using C = Layout<"{level} {msg}">;
+  EXPECT_EQ(A::functions(), B::functions());
+  EXPECT_NE(A::functions(), C::functions());
+}
+
+}  // namespace
+
+}  // namespace femtolog
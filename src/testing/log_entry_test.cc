@@ -0,0 +1,81 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#include "femtolog/base/log_entry.h"
+
+#include <cstdint>
+#include <limits>
+
+#include "gtest/gtest.h"
+
+namespace femtolog {
+
+namespace {
+
+TEST(VarintTest, RoundTripsBoundaries) {
+  constexpr uint64_t kValues[] = {0,
+                                  1,
+                                  127,
+                                  128,
+                                  16383,
+                                  16384,
+                                  uint64_t{1} << 35,
+                                  std::numeric_limits<uint64_t>::max()};
+  for (uint64_t value : kValues) {
+    char buffer[kMaxVarintSize];
+    const char* end = write_varint(buffer, value);
+    EXPECT_EQ(static_cast<std::size_t>(end - buffer), varint_size(value));
+
+    uint64_t decoded = 0;
+    EXPECT_EQ(read_varint(buffer, end, &decoded), end);
+    EXPECT_EQ(decoded, value);
+    // Truncated input is reported rather than misread.
+    EXPECT_EQ(read_varint(buffer, end - 1, &decoded), nullptr);
+  }
+  EXPECT_EQ(varint_size(127), 1u);
+  EXPECT_EQ(varint_size(128), 2u);
+  EXPECT_EQ(varint_size(std::numeric_limits<uint64_t>::max()),
+            kMaxVarintSize);
+}
+
+TEST(QueuedEntryHeaderTest, RoundTrips) {
+  for (bool has_timestamp : {false, true}) {
+    QueuedEntryHeader header;
+    header.call_site_index = 0x12345678;
+    header.payload_len = 300;
+    header.timestamp_delta = 5000;
+
+    char buffer[QueuedEntryHeader::kMaxSize];
+    const char* payload = header.encode(buffer, has_timestamp);
+    const std::size_t size = header.size(has_timestamp);
+    EXPECT_EQ(static_cast<std::size_t>(payload - buffer), size);
+
+    QueuedEntryHeader decoded;
+    EXPECT_EQ(decoded.decode(buffer, size, has_timestamp), size);
+    EXPECT_EQ(decoded.call_site_index, header.call_site_index);
+    EXPECT_EQ(decoded.payload_len, header.payload_len);
+    if (has_timestamp) {
+      EXPECT_EQ(decoded.timestamp_delta, header.timestamp_delta);
+    }
+    EXPECT_EQ(decoded.decode(buffer, size - 1, has_timestamp), 0u);
+  }
+}
+
+TEST(QueuedEntryHeaderTest, IsCompact) {
+  // A literal costs its call site index and a one-byte length.
+  QueuedEntryHeader literal;
+  literal.call_site_index = 1;
+  EXPECT_EQ(literal.size(false), 5u);
+
+  // Back-to-back entries are usually a few hundred ticks apart.
+  QueuedEntryHeader formatted;
+  formatted.call_site_index = 1;
+  formatted.payload_len = 100;
+  formatted.timestamp_delta = 300;
+  EXPECT_EQ(formatted.size(true), 7u);
+}
+
+}  // namespace
+
+}  // namespace femtolog
@@ -0,0 +1,111 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#include "femtolog/base/string_registry.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace femtolog {
+
+// Never called; referencing the string is enough to register it.
+void string_registry_test_unused_call_site() {
+  StringRegistry::register_static<"registered statically {}\n">();
+  StringRegistry::register_static<"static collision 191: {}\n">();
+  StringRegistry::register_static<"static collision 211: {}\n">();
+}
+
+namespace {
+
+TEST(StringRegistryTest, EmptyRegistryOwnsNoStorage) {
+  StringRegistry registry;
+  EXPECT_EQ(registry.size(), 0u);
+  EXPECT_EQ(registry.memory_usage(), 0u);
+  EXPECT_TRUE(registry.get_string(123).empty());
+}
+
+TEST(StringRegistryTest, RegisterAndLookUp) {
+  StringRegistry registry;
+  registry.register_string<"value: {}\n">();
+  constexpr StringId id = StringRegistry::get_string_id<"value: {}\n">();
+  EXPECT_EQ(registry.get_string(id), "value: {}\n");
+  EXPECT_EQ(registry.size(), 1u);
+
+  // Registering the same string again is not a collision.
+  EXPECT_TRUE(registry.register_string(id, "value: {}\n"));
+  EXPECT_EQ(registry.size(), 1u);
+  EXPECT_EQ(registry.collision_count(), 0u);
+}
+
+TEST(StringRegistryTest, CollisionKeepsFirstString) {
+  // These two strings share a 16-bit id.
+  constexpr StringId id =
+      StringRegistry::get_string_id<"collision 295: {}\n">();
+  static_assert(id == StringRegistry::get_string_id<"collision 360: {}\n">());
+
+  StringRegistry registry;
+  EXPECT_TRUE(registry.register_string<"collision 295: {}\n">());
+  EXPECT_FALSE(registry.register_string<"collision 360: {}\n">());
+  EXPECT_FALSE(registry.register_string_arena(id, "collision 360: {}\n"));
+  EXPECT_EQ(registry.get_string(id), "collision 295: {}\n");
+  EXPECT_EQ(registry.size(), 1u);
+  EXPECT_EQ(registry.collision_count(), 2u);
+}
+
+TEST(StringRegistryTest, GrowsWithDistinctIdsOnly) {
+  StringRegistry registry;
+  std::vector<std::string> texts;
+  for (int i = 0; i < 1000; ++i) {
+    texts.push_back("string " + std::to_string(i));
+  }
+  // Ids sharing low bits exercise probing across growth.
+  for (int i = 0; i < 1000; ++i) {
+    registry.register_string(static_cast<StringId>(i * 64), texts[i]);
+  }
+  EXPECT_EQ(registry.size(), 1000u);
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(registry.get_string(static_cast<StringId>(i * 64)), texts[i]);
+  }
+  EXPECT_TRUE(registry.get_string(1).empty());
+  EXPECT_LT(registry.memory_usage(), 1000u * 64);
+}
+
+TEST(StringRegistryTest, ArenaKeepsCopies) {
+  StringRegistry registry;
+  std::string text = "temporary";
+  registry.register_string_arena(7, text);
+  const std::string large(10000, 'x');
+  registry.register_string_arena(8, large);
+  text = "overwritten";
+  EXPECT_EQ(registry.get_string(7), "temporary");
+  EXPECT_EQ(registry.get_string(8), large);
+}
+
+TEST(StringRegistryTest, RegisterStaticFillsSharedInstanceBeforeMain) {
+  constexpr StringId id =
+      StringRegistry::get_string_id<"registered statically {}\n">();
+  EXPECT_EQ(StringRegistry::instance().get_string(id),
+            "registered statically {}\n");
+}
+
+TEST(StringRegistryTest, RegisterStaticCountsCollisions) {
+  constexpr StringId id =
+      StringRegistry::get_string_id<"static collision 191: {}\n">();
+  static_assert(
+      id == StringRegistry::get_string_id<"static collision 211: {}\n">());
+
+  // Getting this far means the collision did not abort static
+  // initialization. Which of the two strings came first is unspecified.
+  const std::string_view registered = StringRegistry::instance().get_string(id);
+  EXPECT_TRUE(registered == "static collision 191: {}\n" ||
+              registered == "static collision 211: {}\n");
+  EXPECT_GE(StringRegistry::instance().collision_count(), 1u);
+}
+
+}  // namespace
+
+}  // namespace femtolog
@@ -0,0 +1,44 @@
+// Copyright 2025 pugur
+// This source code is licensed under the Apache License, Version 2.0
+// which can be found in the LICENSE file.
+
+#ifndef TESTING_TEMP_DIR_TEST_UTIL_H_
+#define TESTING_TEMP_DIR_TEST_UTIL_H_
+
+#include <string>
+
+#include "femtolog/core/base/file_util.h"
+#include "gtest/gtest.h"
+
+namespace femtolog {
+
+// Fixture of tests writing log files. Each test gets an empty directory named
+// after `prefix`, and `path_` of a log file in it; both are removed after the
+// test. `Base` is ::testing::TestWithParam for parameterized tests.
+template <typename Base = ::testing::Test>
+class TempDirTest : public Base {
+ protected:
+  explicit TempDirTest(const char* prefix) : prefix_(prefix) {}
+
+  void SetUp() override {
+    dir_ = core::temp_path(prefix_);
+    path_ = core::join_path(dir_, "latest.log");
+  }
+
+  void TearDown() override {
+    for (const std::string& file : core::list_files(dir_)) {
+      core::remove_file(core::join_path(dir_, file).c_str());
+    }
+    core::remove_directory(dir_.c_str());
+  }
+
+  std::string dir_;
+  std::string path_;
+
+ private:
+  const char* prefix_;
+};
+
+}  // namespace femtolog
+
+#endif  // TESTING_TEMP_DIR_TEST_UTIL_H_